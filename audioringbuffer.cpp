@@ -0,0 +1,110 @@
+#include "audioringbuffer.h"
+#include <QMutexLocker>
+#include <algorithm>
+#include <cstring>
+
+void AudioRingBuffer::grow(qint64 needed)
+{
+    qint64 cap = qint64(m_buf.size());
+    if (needed <= cap) return;
+    qint64 newCap = std::max<qint64>(cap * 2, 64 * 1024);
+    while (newCap < needed) newCap *= 2;
+
+    // 展开为从 0 开始的连续数据
+    std::vector<uint8_t> buf(static_cast<size_t>(newCap));
+    qint64 first = std::min(m_size, cap - m_read);
+    if (first > 0) std::memcpy(buf.data(), m_buf.data() + m_read, size_t(first));
+    if (m_size > first) std::memcpy(buf.data() + first, m_buf.data(), size_t(m_size - first));
+    m_buf.swap(buf);
+    m_read = 0;
+}
+
+void AudioRingBuffer::write(const uint8_t *data, qint64 bytes, quint64 serial)
+{
+    if (bytes <= 0) return;
+    QMutexLocker locker(&m_mutex);
+    grow(m_size + bytes);
+
+    qint64 cap = qint64(m_buf.size());
+    qint64 pos = (m_read + m_size) % cap;
+    qint64 first = std::min(bytes, cap - pos);
+    std::memcpy(m_buf.data() + pos, data, size_t(first));
+    if (bytes > first) std::memcpy(m_buf.data(), data + first, size_t(bytes - first));
+    m_size += bytes;
+
+    if (!m_segments.empty() && m_segments.back().serial == serial) m_segments.back().bytes += bytes;
+    else m_segments.push_back({bytes, serial});
+}
+
+qint64 AudioRingBuffer::dropStale(quint64 serial)
+{
+    QMutexLocker locker(&m_mutex);
+    qint64 dropped = 0;
+    while (!m_segments.empty() && m_segments.front().serial < serial) {
+        dropped += m_segments.front().bytes;
+        m_segments.pop_front();
+    }
+    if (dropped > 0) {
+        m_read = (m_read + dropped) % qint64(m_buf.size());
+        m_size -= dropped;
+    }
+    return dropped;
+}
+
+qint64 AudioRingBuffer::readInto(QIODevice *dev, qint64 maxBytes)
+{
+    QMutexLocker locker(&m_mutex);
+    qint64 total = 0;
+    qint64 cap = qint64(m_buf.size());
+    // 环绕时分两段写出
+    while (total < maxBytes && m_size > 0) {
+        qint64 span = std::min({maxBytes - total, m_size, cap - m_read});
+        qint64 written = dev->write(reinterpret_cast<const char*>(m_buf.data() + m_read), span);
+        if (written <= 0) break;
+        m_read = (m_read + written) % cap;
+        m_size -= written;
+        total += written;
+        if (written < span) break;
+    }
+
+    consumeSegments(total);
+    return total;
+}
+
+qint64 AudioRingBuffer::skip(qint64 maxBytes)
+{
+    QMutexLocker locker(&m_mutex);
+    qint64 skipped = std::min(maxBytes, m_size);
+    if (skipped <= 0) return 0;
+    m_read = (m_read + skipped) % qint64(m_buf.size());
+    m_size -= skipped;
+    consumeSegments(skipped);
+    return skipped;
+}
+
+void AudioRingBuffer::consumeSegments(qint64 bytes)
+{
+    while (bytes > 0 && !m_segments.empty()) {
+        Segment &seg = m_segments.front();
+        qint64 take = std::min(bytes, seg.bytes);
+        seg.bytes -= take;
+        bytes -= take;
+        if (seg.bytes == 0) m_segments.pop_front();
+    }
+}
+
+qint64 AudioRingBuffer::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    qint64 cleared = m_size;
+    m_read = 0;
+    m_size = 0;
+    m_segments.clear();
+    return cleared;
+}
+
+qint64 AudioRingBuffer::size() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_size;
+}
@@ -0,0 +1,42 @@
+#ifndef AUDIORINGBUFFER_H
+#define AUDIORINGBUFFER_H
+
+#include <QMutex>
+#include <QIODevice>
+#include <deque>
+#include <vector>
+
+/**
+ * @brief 解码线程与声卡之间的 PCM 环形缓冲
+ *
+ * 解码线程把 filter 输出直接拷入环形缓冲，主线程直接从缓冲写入声卡设备，
+ * 中间不再经过 QByteArray。每段数据记录所属的 seek 序号，读取时丢弃过期段。
+ * 容量按需翻倍增长（占用上限由 MemoryBudget 的背压约束），稳定后不再分配内存。线程安全。
+ */
+class AudioRingBuffer
+{
+public:
+    void write(const uint8_t *data, qint64 bytes, quint64 serial);
+    qint64 dropStale(quint64 serial);               // 丢弃序号小于 serial 的数据，返回字节数
+    qint64 readInto(QIODevice *dev, qint64 maxBytes);   // 直接写入设备，返回实际消耗的字节数
+    qint64 skip(qint64 maxBytes);                   // 丢弃最早的数据，返回字节数
+    qint64 clear();                                 // 返回被清除的字节数
+    qint64 size() const;
+
+private:
+    struct Segment {
+        qint64 bytes;
+        quint64 serial;
+    };
+
+    void grow(qint64 needed);                       // 需持有 m_mutex
+    void consumeSegments(qint64 bytes);             // 按消耗的字节推进分段，需持有 m_mutex
+
+    mutable QMutex m_mutex;
+    std::vector<uint8_t> m_buf;
+    qint64 m_read = 0;          // 读位置
+    qint64 m_size = 0;          // 有效字节数
+    std::deque<Segment> m_segments;
+};
+
+#endif // AUDIORINGBUFFER_H
@@ -0,0 +1,248 @@
+#include "bardetector.h"
+#include <QDebug>
+#include <QMutexLocker>
+#include <algorithm>
+
+extern "C" {
+#include <libavutil/pixdesc.h>
+}
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BARDETECT_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define BARDETECT_NEON 1
+#endif
+
+namespace {
+// 一行中亮于 threshold 的像素数
+int countBright(const uint8_t *p, int n, unsigned threshold)
+{
+    int i = 0;
+    int count = 0;
+#if defined(BARDETECT_SSE2)
+    const __m128i thr = _mm_set1_epi8(char(threshold));
+    const __m128i one = _mm_set1_epi8(1);
+    const __m128i zero = _mm_setzero_si128();
+    __m128i acc = _mm_setzero_si128();
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        __m128i bright = _mm_min_epu8(_mm_subs_epu8(v, thr), one);     // 亮为 1，暗为 0
+        acc = _mm_add_epi64(acc, _mm_sad_epu8(bright, zero));
+    }
+    count = _mm_cvtsi128_si32(acc) + _mm_cvtsi128_si32(_mm_srli_si128(acc, 8));
+#elif defined(BARDETECT_NEON)
+    const uint8x16_t thr = vdupq_n_u8(uint8_t(threshold));
+    const uint8x16_t one = vdupq_n_u8(1);
+    uint16x8_t acc = vdupq_n_u16(0);
+    for (; i + 16 <= n; i += 16) {
+        uint8x16_t bright = vminq_u8(vqsubq_u8(vld1q_u8(p + i), thr), one);
+        acc = vpadalq_u8(acc, bright);
+    }
+    uint64x2_t sum = vpaddlq_u32(vpaddlq_u16(acc));
+    count = int(vgetq_lane_u64(sum, 0) + vgetq_lane_u64(sum, 1));
+#endif
+    for (; i < n; ++i) count += p[i] > threshold;
+    return count;
+}
+
+// 高位深：样本少，标量即可
+int countBright(const uint16_t *p, int n, unsigned threshold)
+{
+    int count = 0;
+    for (int i = 0; i < n; ++i) count += p[i] > threshold;
+    return count;
+}
+
+// 每列的亮像素计数加上这一行，饱和于 255
+void accumulateColumns(const uint8_t *p, uint8_t *acc, int n, unsigned threshold)
+{
+    int i = 0;
+#if defined(BARDETECT_SSE2)
+    const __m128i thr = _mm_set1_epi8(char(threshold));
+    const __m128i one = _mm_set1_epi8(1);
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        __m128i bright = _mm_min_epu8(_mm_subs_epu8(v, thr), one);
+        __m128i *dst = reinterpret_cast<__m128i*>(acc + i);
+        _mm_storeu_si128(dst, _mm_adds_epu8(_mm_loadu_si128(dst), bright));
+    }
+#elif defined(BARDETECT_NEON)
+    const uint8x16_t thr = vdupq_n_u8(uint8_t(threshold));
+    const uint8x16_t one = vdupq_n_u8(1);
+    for (; i + 16 <= n; i += 16) {
+        uint8x16_t bright = vminq_u8(vqsubq_u8(vld1q_u8(p + i), thr), one);
+        vst1q_u8(acc + i, vqaddq_u8(vld1q_u8(acc + i), bright));
+    }
+#endif
+    for (; i < n; ++i) {
+        if (p[i] > threshold && acc[i] < 255) ++acc[i];
+    }
+}
+
+void accumulateColumns(const uint16_t *p, uint8_t *acc, int n, unsigned threshold)
+{
+    for (int i = 0; i < n; ++i) {
+        if (p[i] > threshold && acc[i] < 255) ++acc[i];
+    }
+}
+}
+
+BarDetector::~BarDetector()
+{
+    m_quit.store(true);
+    {
+        QMutexLocker locker(&m_mutex);
+        m_cond.wakeAll();
+    }
+    if (m_thread) {
+        m_thread->wait();
+        delete m_thread;
+    }
+    av_frame_free(&m_pending);
+}
+
+void BarDetector::start()
+{
+    m_thread = QThread::create([this]() { run(); });
+    m_thread->start(QThread::LowestPriority);
+}
+
+void BarDetector::submit(const AVFrame *frame)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_pending) return;
+    m_pending = av_frame_clone(frame);
+    m_cond.wakeAll();
+}
+
+bool BarDetector::takeCrop(QRect &crop)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_changed) return false;
+    m_changed = false;
+    crop = m_crop;
+    return true;
+}
+
+void BarDetector::run()
+{
+    while (!m_quit.load()) {
+        AVFrame *frame = nullptr;
+        {
+            QMutexLocker locker(&m_mutex);
+            while (!m_pending && !m_quit.load()) m_cond.wait(&m_mutex);
+            frame = m_pending;
+        }
+        if (!frame) break;
+        analyze(frame);
+        // 分析完才清空：分析期间到达的样本直接丢弃
+        QMutexLocker locker(&m_mutex);
+        av_frame_free(&m_pending);
+    }
+}
+
+void BarDetector::analyze(const AVFrame *frame)
+{
+    const QSize size(frame->width, frame->height);
+    if (size != m_size) {
+        m_size = size;
+        m_union = QRect();
+        m_samples = 0;
+        // 旧尺寸下的结论作废
+        QMutexLocker locker(&m_mutex);
+        if (!m_crop.isNull()) {
+            m_crop = QRect();
+            m_changed = true;
+        }
+    }
+
+    QRect active;
+    if (!scan(frame, active)) return;
+    m_union = m_union.isNull() ? active : m_union.united(active);
+    if (++m_samples < MIN_SAMPLES) return;
+
+    const QRect crop = cropFor(m_union);
+    QMutexLocker locker(&m_mutex);
+    if (crop == m_crop) return;
+    m_crop = crop;
+    m_changed = true;
+    qDebug() << "Black bars:" << m_size << "active" << m_union << "crop" << crop << "after" << m_samples << "samples";
+}
+
+bool BarDetector::scan(const AVFrame *frame, QRect &active)
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(AVPixelFormat(frame->format));
+    if (!desc || frame->hw_frames_ctx || !frame->data[0]) return false;
+    if (desc->flags & (AV_PIX_FMT_FLAG_RGB | AV_PIX_FMT_FLAG_PAL | AV_PIX_FMT_FLAG_HWACCEL | AV_PIX_FMT_FLAG_BE))
+        return false;
+    // 亮度必须单独成平面（排除 YUYV 等打包格式）
+    const AVComponentDescriptor &luma = desc->comp[0];
+    if (luma.plane != 0 || desc->nb_components < 1) return false;
+    if (luma.step == 1 && luma.depth == 8)
+        return scanPlane<uint8_t>(frame->data[0], frame->linesize[0], frame->width, frame->height,
+                                  LUMA_THRESHOLD, active);
+    if (luma.step == 2 && luma.depth > 8 && luma.depth <= 16)
+        return scanPlane<uint16_t>(frame->data[0], frame->linesize[0], frame->width, frame->height,
+                                   unsigned(LUMA_THRESHOLD << (luma.depth - 8)) << luma.shift, active);
+    return false;
+}
+
+/**
+ * @brief 行从上下两端向内扫描到第一行画面为止；列只统计画面行范围内抽样的至多 255 行
+ */
+template <typename T>
+bool BarDetector::scanPlane(const uint8_t *data, int linesize, int width, int height, unsigned threshold, QRect &active)
+{
+    if (width <= 0 || height <= 0) return false;
+    auto row = [&](int y) { return reinterpret_cast<const T*>(data + ptrdiff_t(y) * linesize); };
+
+    const int rowTolerance = width / BRIGHT_FRACTION;
+    int top = 0;
+    while (top < height && countBright(row(top), width, threshold) <= rowTolerance) ++top;
+    if (top >= height) return false;        // 黑场
+    int bottom = height - 1;
+    while (bottom > top && countBright(row(bottom), width, threshold) <= rowTolerance) --bottom;
+
+    const int rows = bottom - top + 1;
+    const int step = std::max(1, (rows + 254) / 255);
+    m_columns.assign(size_t(width), 0);
+    int sampled = 0;
+    for (int y = top; y <= bottom; y += step, ++sampled)
+        accumulateColumns(row(y), m_columns.data(), width, threshold);
+
+    const int columnTolerance = sampled / BRIGHT_FRACTION;
+    int left = 0;
+    while (left < width && m_columns[size_t(left)] <= columnTolerance) ++left;
+    if (left >= width) return false;
+    int right = width - 1;
+    while (right > left && m_columns[size_t(right)] <= columnTolerance) --right;
+
+    active = QRect(QPoint(left, top), QPoint(right, bottom));
+    // 暗场景中只有一小块亮区域时结论不可靠
+    return active.width() * 4 >= width && active.height() * 4 >= height;
+}
+
+/**
+ * @brief 有效画面换算为裁剪区域：忽略过窄的黑边，边界向外对齐到偶数（色度二次采样）
+ */
+QRect BarDetector::cropFor(const QRect &active) const
+{
+    const int width = m_size.width();
+    const int height = m_size.height();
+    int left = active.left();
+    int top = active.top();
+    int right = width - 1 - active.right();
+    int bottom = height - 1 - active.bottom();
+    if (left * MIN_BAR_FRACTION < width) left = 0;
+    if (right * MIN_BAR_FRACTION < width) right = 0;
+    if (top * MIN_BAR_FRACTION < height) top = 0;
+    if (bottom * MIN_BAR_FRACTION < height) bottom = 0;
+    left &= ~1;
+    top &= ~1;
+    right &= ~1;
+    bottom &= ~1;
+    if (left + right + top + bottom == 0) return QRect();
+    return QRect(left, top, width - left - right, height - top - bottom);
+}
@@ -0,0 +1,67 @@
+#ifndef BARDETECTOR_H
+#define BARDETECTOR_H
+
+#include <QMutex>
+#include <QRect>
+#include <QSize>
+#include <QThread>
+#include <QWaitCondition>
+#include <atomic>
+#include <vector>
+
+extern "C" {
+#include <libavutil/frame.h>
+}
+
+/**
+ * @brief 黑边检测：后台分析抽样的解码帧，给出去掉上下/左右黑边后的稳定裁剪区域
+ *
+ * 每帧在亮度平面上从四边向内扫描：行与列中亮于阈值的像素不超过容差即视为黑边（SSE2/NEON）。
+ * 各帧的有效画面区域取并集，有效样本达到 MIN_SAMPLES 后才给出结论，之后区域只会扩大，
+ * 黑场、淡入淡出和暗场景不会把画面越裁越小。只支持平面亮度（YUV、NV12 等），其他格式不检测。
+ *
+ * submit/takeCrop 由解码线程调用，分析在最低优先级的后台线程进行；上一帧还没分析完时新帧直接丢弃。
+ */
+class BarDetector
+{
+public:
+    static constexpr double SAMPLE_INTERVAL_SEC = 0.5;  // 送检间隔（视频时间）
+    static constexpr int MIN_SAMPLES = 6;               // 有效样本数达到后才给出第一个结论
+    static constexpr int LUMA_THRESHOLD = 32;           // 8 位亮度；有限范围的黑为 16，留出噪声余量
+    static constexpr int BRIGHT_FRACTION = 32;          // 一行/列中亮像素不超过 1/32 仍算黑边（噪点、台标）
+    static constexpr int MIN_BAR_FRACTION = 100;        // 窄于边长 1% 的黑边不裁（1080 编码为 1088 等）
+
+    BarDetector() = default;
+    ~BarDetector();
+    BarDetector(const BarDetector &) = delete;
+    BarDetector &operator=(const BarDetector &) = delete;
+
+    void start();
+    void submit(const AVFrame *frame);      // 只增加引用，不拷贝像素
+    bool takeCrop(QRect &crop);             // 结论变化时返回 true；crop 为解码尺寸下的区域，空为不裁剪
+
+private:
+    void run();
+    void analyze(const AVFrame *frame);
+    bool scan(const AVFrame *frame, QRect &active);     // 单帧的有效画面；全黑、画面过小或格式不支持返回 false
+    template <typename T>
+    bool scanPlane(const uint8_t *data, int linesize, int width, int height, unsigned threshold, QRect &active);
+    QRect cropFor(const QRect &active) const;
+
+    QThread *m_thread = nullptr;
+    std::atomic<bool> m_quit{false};
+
+    QMutex m_mutex;
+    QWaitCondition m_cond;                  // 新样本或退出
+    AVFrame *m_pending = nullptr;
+    QRect m_crop;
+    bool m_changed = false;
+
+    // 以下只在后台线程使用
+    QSize m_size;                           // 解码尺寸变化时重新统计
+    QRect m_union;                          // 各样本有效画面的并集
+    int m_samples = 0;
+    std::vector<uint8_t> m_columns;         // 每列亮像素计数（饱和于 255）
+};
+
+#endif // BARDETECTOR_H
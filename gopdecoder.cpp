@@ -0,0 +1,330 @@
+#include "gopdecoder.h"
+#include <QMutexLocker>
+#include <QDebug>
+#include <algorithm>
+#include <cstdint>
+
+GopParallelDecoder::Gop::~Gop()
+{
+    for (AVPacket *p : packets) {
+        if (budget) budget->release(MemoryBudget::GopPackets, p->size);
+        av_packet_free(&p);
+    }
+    for (AVFrame *f : frames) {
+        if (budget) budget->release(MemoryBudget::GopFrames, frameBytes(f));
+        av_frame_free(&f);
+    }
+}
+
+GopParallelDecoder::GopParallelDecoder(MemoryBudget *budget, int workerCount)
+    : m_budget(budget)
+{
+    if (workerCount <= 0) workerCount = std::clamp(QThread::idealThreadCount() / 2, 2, 8);
+    m_workerCount = workerCount;
+    m_maxInFlight = workerCount * 2;   // 每个工作线程一个在解 + 一个排队
+}
+
+GopParallelDecoder::~GopParallelDecoder()
+{
+    close();
+}
+
+// ---------------- open / close ----------------
+bool GopParallelDecoder::open(const AVCodecParameters *par, AVRational timeBase)
+{
+    close();
+    m_quit.store(false);
+
+    const AVCodec *codec = avcodec_find_decoder(par->codec_id);
+    if (!codec) {
+        qWarning() << "GopParallelDecoder: 未找到视频解码器";
+        return false;
+    }
+
+    for (int i = 0; i < m_workerCount; ++i) {
+        AVCodecContext *ctx = avcodec_alloc_context3(codec);
+        if (!ctx || avcodec_parameters_to_context(ctx, par) < 0) {
+            avcodec_free_context(&ctx);
+            close();
+            return false;
+        }
+        // 并行度来自多个 GOP，单个实例不再开帧线程
+        ctx->thread_count = 1;
+#ifdef AV_CODEC_FLAG_COPY_OPAQUE
+        // 帧的 opaque 带回产生它的包的下标，无时间戳的帧据此归属
+        ctx->flags |= AV_CODEC_FLAG_COPY_OPAQUE;
+#endif
+        ctx->pkt_timebase = timeBase;
+        if (avcodec_open2(ctx, codec, nullptr) < 0) {
+            qWarning() << "GopParallelDecoder: 解码器实例打开失败";
+            avcodec_free_context(&ctx);
+            close();
+            return false;
+        }
+        m_contexts.push_back(ctx);
+    }
+
+    for (AVCodecContext *ctx : m_contexts) {
+        QThread *t = QThread::create([this, ctx]() { workerLoop(ctx); });
+        t->start();
+        m_workers.push_back(t);
+    }
+    qDebug() << "GopParallelDecoder: workers =" << m_workerCount;
+    return true;
+}
+
+void GopParallelDecoder::close()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_quit.store(true);
+        m_generation.fetch_add(1);
+        m_jobCond.wakeAll();
+        m_doneCond.wakeAll();
+    }
+    for (QThread *t : m_workers) {
+        t->wait();
+        delete t;
+    }
+    m_workers.clear();
+    for (AVCodecContext *ctx : m_contexts) avcodec_free_context(&ctx);
+    m_contexts.clear();
+
+    QMutexLocker locker(&m_mutex);
+    m_gops.clear();
+    m_current.reset();
+    m_previous.reset();
+    m_queuedCount = 0;
+}
+
+// ---------------- 输入：按关键帧切分 ----------------
+void GopParallelDecoder::queueGop(const std::shared_ptr<Gop> &gop)
+{
+    gop->queued = true;
+    ++m_queuedCount;
+    m_jobCond.wakeOne();
+}
+
+void GopParallelDecoder::addPacket(Gop &gop, const AVPacket *pkt)
+{
+    AVPacket *copy = av_packet_clone(pkt);
+    copy->opaque = reinterpret_cast<void*>(intptr_t(gop.packets.size()));
+    gop.packets.push_back(copy);
+    if (m_budget) m_budget->acquire(MemoryBudget::GopPackets, pkt->size);
+}
+
+void GopParallelDecoder::pushPacket(const AVPacket *pkt)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (pkt->flags & AV_PKT_FLAG_KEY) {
+        // 上一个 GOP 还在等前导包就遇到了新关键帧，说明前导包已经结束
+        if (m_previous) {
+            queueGop(m_previous);
+            m_previous.reset();
+        }
+        if (m_current) {
+            m_current->endPts = pkt->pts;
+            m_current->tailStart = m_current->packets.size();
+            m_previous = m_current;
+            addPacket(*m_previous, pkt);
+        }
+        m_current = std::make_shared<Gop>(m_budget);
+        m_current->keyPts = pkt->pts;
+        addPacket(*m_current, pkt);
+        m_gops.push_back(m_current);
+        return;
+    }
+
+    // seek 后第一个关键帧之前的包无法独立解码，直接丢弃
+    if (!m_current) return;
+    addPacket(*m_current, pkt);
+
+    if (m_previous) {
+        bool leading = pkt->pts != AV_NOPTS_VALUE && m_previous->endPts != AV_NOPTS_VALUE
+                       && pkt->pts < m_previous->endPts;
+        if (leading) {
+            addPacket(*m_previous, pkt);
+            m_current->headEnd = m_current->packets.size();
+        } else {
+            queueGop(m_previous);
+            m_previous.reset();
+        }
+    }
+}
+
+void GopParallelDecoder::flush()
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_previous) {
+        queueGop(m_previous);
+        m_previous.reset();
+    }
+    if (m_current) {
+        m_current->endPts = AV_NOPTS_VALUE;
+        queueGop(m_current);
+        m_current.reset();
+    }
+}
+
+void GopParallelDecoder::reset()
+{
+    QMutexLocker locker(&m_mutex);
+    // 正在解码的任务持有 shared_ptr，结束后随引用释放
+    m_generation.fetch_add(1);
+    m_gops.clear();
+    m_current.reset();
+    m_previous.reset();
+    m_queuedCount = 0;
+    m_doneCond.wakeAll();
+}
+
+// ---------------- 输出：按 GOP 顺序取帧 ----------------
+AVFrame *GopParallelDecoder::takeFrame(bool block)
+{
+    QMutexLocker locker(&m_mutex);
+    while (!m_gops.empty()) {
+        std::shared_ptr<Gop> front = m_gops.front();
+        if (front->done) {
+            if (!front->frames.empty()) {
+                AVFrame *f = front->frames.front();
+                front->frames.pop_front();
+                if (m_budget) m_budget->release(MemoryBudget::GopFrames, frameBytes(f));
+                return f;
+            }
+            m_gops.pop_front();
+            --m_queuedCount;
+            continue;
+        }
+        // 还在积累的 GOP 不会自己完成，阻塞等待会死锁
+        if (!block || !front->queued || m_quit.load()) return nullptr;
+        m_doneCond.wait(&m_mutex);
+    }
+    return nullptr;
+}
+
+bool GopParallelDecoder::saturated() const
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_queuedCount >= m_maxInFlight) return true;
+    // 至少保留一个在途 GOP，避免配额过小时永远无法前进
+    if (m_budget && m_queuedCount > 0) {
+        return !m_budget->hasRoom(MemoryBudget::GopFrames) || !m_budget->hasRoom(MemoryBudget::GopPackets);
+    }
+    return false;
+}
+
+bool GopParallelDecoder::hasPending() const
+{
+    QMutexLocker locker(&m_mutex);
+    return !m_gops.empty();
+}
+
+// ---------------- 工作线程 ----------------
+void GopParallelDecoder::workerLoop(AVCodecContext *ctx)
+{
+    QMutexLocker locker(&m_mutex);
+    while (!m_quit.load()) {
+        std::shared_ptr<Gop> job;
+        for (const auto &g : m_gops) {
+            if (g->queued && !g->running && !g->done) { job = g; break; }
+        }
+        if (!job) {
+            m_jobCond.wait(&m_mutex);
+            continue;
+        }
+
+        job->running = true;
+        quint64 generation = m_generation.load();
+        locker.unlock();
+        std::vector<AVFrame*> frames = decodeGop(ctx, *job, generation);
+        locker.relock();
+
+        for (AVFrame *f : frames) {
+            if (m_budget) m_budget->acquire(MemoryBudget::GopFrames, frameBytes(f));
+            job->frames.push_back(f);
+        }
+        job->running = false;
+        job->done = true;
+        m_doneCond.wakeAll();
+    }
+}
+
+int64_t GopParallelDecoder::framePts(const AVFrame *f)
+{
+    return f->pts != AV_NOPTS_VALUE ? f->pts : f->best_effort_timestamp;
+}
+
+/**
+ * @brief 包的归属：自己的关键帧和普通包、下一个关键帧的前导包归本 GOP；
+ *        自己的前导包归前一个 GOP（它持有参考帧），下一个关键帧归下一个 GOP
+ */
+bool GopParallelDecoder::ownsPacket(const Gop &gop, size_t index)
+{
+    if (index == 0) return true;
+    if (index < gop.headEnd) return false;
+    return index != gop.tailStart;
+}
+
+qint64 GopParallelDecoder::frameBytes(const AVFrame *f)
+{
+    qint64 bytes = 0;
+    for (int i = 0; i < AV_NUM_DATA_POINTERS; ++i) {
+        if (f->buf[i]) bytes += f->buf[i]->size;
+    }
+    return bytes;
+}
+
+std::vector<AVFrame*> GopParallelDecoder::decodeGop(AVCodecContext *ctx, const Gop &gop, quint64 generation)
+{
+    // 排序键：无时间戳的帧沿用解码器输出顺序中前一帧的 pts，留在原位置而不是排到最前
+    std::vector<std::pair<int64_t, AVFrame*>> kept;
+    int64_t lastPts = INT64_MIN;
+    AVFrame *f = av_frame_alloc();
+
+    // 有时间戳的帧按显示区间 [keyPts, endPts) 归属，没有的按产生它的包归属
+    auto receiveAll = [&]() {
+        while (avcodec_receive_frame(ctx, f) == 0) {
+            int64_t pts = framePts(f);
+            bool keep;
+            if (pts != AV_NOPTS_VALUE) {
+                keep = (gop.keyPts == AV_NOPTS_VALUE || pts >= gop.keyPts)
+                       && (gop.endPts == AV_NOPTS_VALUE || pts < gop.endPts);
+                lastPts = pts;
+            } else {
+#ifdef AV_CODEC_FLAG_COPY_OPAQUE
+                keep = ownsPacket(gop, size_t(reinterpret_cast<intptr_t>(f->opaque)));
+#else
+                keep = ownsPacket(gop, size_t(f->reordered_opaque));
+#endif
+            }
+            if (keep) {
+                kept.emplace_back(pts != AV_NOPTS_VALUE ? pts : lastPts, f);
+                f = av_frame_alloc();
+            } else {
+                av_frame_unref(f);
+            }
+        }
+    };
+
+    for (const AVPacket *pkt : gop.packets) {
+        if (m_quit.load() || m_generation.load() != generation) break;
+#ifndef AV_CODEC_FLAG_COPY_OPAQUE
+        ctx->reordered_opaque = reinterpret_cast<intptr_t>(pkt->opaque);
+#endif
+        avcodec_send_packet(ctx, pkt);
+        receiveAll();
+    }
+    avcodec_send_packet(ctx, nullptr);
+    receiveAll();
+    avcodec_flush_buffers(ctx);
+    av_frame_free(&f);
+
+    std::stable_sort(kept.begin(), kept.end(), [](const auto &a, const auto &b) {
+        return a.first < b.first;
+    });
+    std::vector<AVFrame*> out;
+    out.reserve(kept.size());
+    for (const auto &k : kept) out.push_back(k.second);
+    return out;
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <QMutex>
+#include <QWaitCondition>
+#include <QThread>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "memorybudget.h"
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+/**
+ * @brief GOP 级并行解码引擎
+ *
+ * 按关键帧把视频包切成 GOP，每个 GOP 交给独立的解码器实例并行解码，
+ * 输出按 GOP 顺序、GOP 内按 pts 重排，结果与单解码器顺序解码一致。
+ *
+ * 开放 GOP 处理：第 k 个 GOP 的任务会额外解码第 k+1 个关键帧及其前导包
+ * （pts 小于该关键帧的包），前导帧由持有参考帧的第 k 个任务输出；
+ * 第 k+1 个任务只输出 pts 不小于自身关键帧的帧。
+ *
+ * 没有时间戳的帧无法按 pts 区间归属，改按产生它的包判断：每个包只归一个 GOP
+ * （关键帧归自己的 GOP，前导包归前一个 GOP），重叠解码的包产生的无时间戳帧只输出一次。
+ */
+class GopParallelDecoder
+{
+public:
+    // budget 用于压缩包/解码帧的字节记账，可为空；workerCount 为 0 表示按 CPU 核数自动选择
+    explicit GopParallelDecoder(MemoryBudget *budget = nullptr, int workerCount = 0);
+    ~GopParallelDecoder();
+
+    bool open(const AVCodecParameters *par, AVRational timeBase);
+    void close();
+
+    void pushPacket(const AVPacket *pkt);   // 按解码顺序送入视频包（内部增加引用）
+    void flush();                           // 文件结束：提交剩余的 GOP
+    void reset();                           // seek 后丢弃所有在途数据
+
+    AVFrame *takeFrame(bool block);         // 按显示顺序取下一帧，调用者负责 av_frame_free
+    bool saturated() const;                 // 在途 GOP 数或内存配额已达上限（此时应阻塞取帧）
+    bool hasPending() const;                // 是否还有未取出的帧
+
+    int workerCount() const { return m_workerCount; }
+
+    static qint64 frameBytes(const AVFrame *f);     // 解码帧引用的缓冲大小，用于内存记账
+
+private:
+    struct Gop {
+        explicit Gop(MemoryBudget *b) : budget(b) {}
+        ~Gop();
+        MemoryBudget *budget;
+        int64_t keyPts = AV_NOPTS_VALUE;    // 本 GOP 关键帧 pts
+        int64_t endPts = AV_NOPTS_VALUE;    // 下一个关键帧 pts（不含），最后一个 GOP 为 NOPTS
+        std::vector<AVPacket*> packets;     // opaque 为包在本 GOP 中的下标
+        size_t headEnd = 1;                 // [1, headEnd) 为本 GOP 的前导包，由前一个 GOP 输出
+        size_t tailStart = SIZE_MAX;        // 下一个关键帧的下标，其后为它的前导包
+        std::deque<AVFrame*> frames;        // 解码完成后按 pts 排好序
+        bool queued = false;                // 已提交给工作线程，之后 packets 不再变化
+        bool running = false;
+        bool done = false;
+    };
+
+    void workerLoop(AVCodecContext *ctx);
+    std::vector<AVFrame*> decodeGop(AVCodecContext *ctx, const Gop &gop, quint64 generation);
+    void queueGop(const std::shared_ptr<Gop> &gop);     // 需持有 m_mutex
+    static int64_t framePts(const AVFrame *f);
+    static bool ownsPacket(const Gop &gop, size_t index);   // 该包产生的帧是否由本 GOP 输出
+    void addPacket(Gop &gop, const AVPacket *pkt);
+
+    MemoryBudget *m_budget = nullptr;
+
+    int m_workerCount = 0;
+    int m_maxInFlight = 0;
+    std::vector<QThread*> m_workers;
+    std::vector<AVCodecContext*> m_contexts;
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_jobCond;       // 有新任务或退出
+    QWaitCondition m_doneCond;      // 有 GOP 解码完成
+    std::deque<std::shared_ptr<Gop>> m_gops;   // 按解码顺序，包含正在积累的 GOP
+    std::shared_ptr<Gop> m_current;            // 正在积累包的 GOP
+    std::shared_ptr<Gop> m_previous;           // 等待下一个 GOP 前导包的 GOP
+    int m_queuedCount = 0;                     // m_gops 中已提交的 GOP 数
+    std::atomic<quint64> m_generation{0};      // reset 时递增，用于中止过期任务
+    std::atomic<bool> m_quit{false};
+};
@@ -3,6 +3,62 @@
 
 #include <QScreen>
 #include <QShortcut>
+#include <QFileInfo>
+#include <QFileDialog>
+#include <QWindow>
+
+#ifdef Q_OS_WIN
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <dwmapi.h>
+#endif
+
+namespace {
+constexpr int SUBTITLE_LOAD_FILE = -3;   // 字幕下拉框中“加载字幕文件…”项
+
+/**
+ * @brief 窗口是否被其他窗口完全覆盖。Windows 在被覆盖时不发送 Expose(false)，需要自己判断：
+ * 从窗口矩形中依次减去 Z 序在它之上的可见顶层窗口，什么都不剩即为完全遮挡。
+ * 半透明（分层）窗口后面的画面仍然可见，不计入；其他虚拟桌面上的窗口被 DWM 隐藏（cloaked），也不计入。
+ * 其他平台的遮挡由 isExposed() 反映，这里返回 false
+ */
+bool isOccluded(QWindow *window)
+{
+#ifdef Q_OS_WIN
+    HWND hwnd = reinterpret_cast<HWND>(window->winId());
+    BOOL cloaked = FALSE;
+    if (SUCCEEDED(DwmGetWindowAttribute(hwnd, DWMWA_CLOAKED, &cloaked, sizeof(cloaked))) && cloaked) return true;
+    RECT rect;
+    if (!GetWindowRect(hwnd, &rect)) return false;
+
+    HRGN remaining = CreateRectRgnIndirect(&rect);
+    bool occluded = false;
+    for (HWND above = GetWindow(hwnd, GW_HWNDPREV); above && !occluded; above = GetWindow(above, GW_HWNDPREV)) {
+        if (!IsWindowVisible(above) || IsIconic(above)) continue;
+        if (GetWindowLongPtr(above, GWL_EXSTYLE) & (WS_EX_LAYERED | WS_EX_TRANSPARENT)) continue;
+        BOOL aboveCloaked = FALSE;
+        if (SUCCEEDED(DwmGetWindowAttribute(above, DWMWA_CLOAKED, &aboveCloaked, sizeof(aboveCloaked))) && aboveCloaked)
+            continue;
+        // 不含阴影的实际边框；取不到时退回含阴影的窗口矩形
+        RECT cover;
+        if (FAILED(DwmGetWindowAttribute(above, DWMWA_EXTENDED_FRAME_BOUNDS, &cover, sizeof(cover)))
+            && !GetWindowRect(above, &cover)) {
+            continue;
+        }
+        HRGN coverRgn = CreateRectRgnIndirect(&cover);
+        occluded = CombineRgn(remaining, remaining, coverRgn, RGN_DIFF) == NULLREGION;
+        DeleteObject(coverRgn);
+    }
+    DeleteObject(remaining);
+    return occluded;
+#else
+    Q_UNUSED(window);
+    return false;
+#endif
+}
+}
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
@@ -33,6 +89,79 @@ MainWindow::MainWindow(QWidget *parent)
         manager->m_scalingAlgo = index;
         player->setScalingAlgorithm(player->scalingAlgorithm[index]);
     });
+    connect(m_settings,&SettingsWidget::gopParallelChanged,this,[=](bool enabled){
+        if(enabled == manager->m_gopParallel) return ;
+        qDebug() << "GOP 并行解码：" << enabled;
+        manager->m_gopParallel = enabled;
+        player->setGopParallelDecoding(enabled);
+    });
+    connect(m_settings,&SettingsWidget::memoryLimitChanged,this,[=](int mb){
+        if(mb == manager->m_memoryLimitMB) return ;
+        manager->m_memoryLimitMB = mb;
+        player->setMemoryLimit(qint64(mb) * 1024 * 1024);
+    });
+    connect(m_settings,&SettingsWidget::readAheadAlwaysChanged,this,[=](bool enabled){
+        if(enabled == manager->m_readAheadAlways) return ;
+        qDebug() << "本地文件预读：" << enabled;
+        manager->m_readAheadAlways = enabled;
+        player->setReadAhead(enabled, manager->m_readAheadMB);
+    });
+    connect(m_settings,&SettingsWidget::readAheadWindowChanged,this,[=](int mb){
+        if(mb == manager->m_readAheadMB) return ;
+        manager->m_readAheadMB = mb;
+        player->setReadAhead(manager->m_readAheadAlways, mb);
+    });
+    connect(m_settings,&SettingsWidget::rewindCacheChanged,this,[=](int sec){
+        if(sec == manager->m_rewindCacheSec) return ;
+        manager->m_rewindCacheSec = sec;
+        player->setRewindCacheSeconds(sec);
+    });
+    connect(m_settings,&SettingsWidget::skipPrefetchChanged,this,[=](bool enabled){
+        if(enabled == manager->m_skipPrefetch) return ;
+        qDebug() << "预判快进：" << enabled;
+        manager->m_skipPrefetch = enabled;
+        player->setSkipPrefetch(enabled);
+    });
+    connect(m_settings,&SettingsWidget::deinterlaceChanged,this,[=](int mode){
+        if(mode == manager->m_deinterlace) return ;
+        qDebug() << "去隔行：" << mode;
+        manager->m_deinterlace = mode;
+        player->setDeinterlace(mode);
+    });
+    connect(m_settings,&SettingsWidget::autoRotateChanged,this,[=](bool enabled){
+        if(enabled == manager->m_autoRotate) return ;
+        qDebug() << "自动旋转：" << enabled;
+        manager->m_autoRotate = enabled;
+        player->setAutoRotate(enabled);
+        updateVideoRenderSize();    //横竖方向可能改变
+    });
+    connect(m_settings,&SettingsWidget::autoCropChanged,this,[=](bool enabled){
+        if(enabled == manager->m_autoCrop) return ;
+        qDebug() << "自动裁黑边：" << enabled;
+        manager->m_autoCrop = enabled;
+        player->setAutoCrop(enabled);
+        updateVideoRenderSize();
+    });
+    connect(m_settings,&SettingsWidget::timeStretchEngineChanged,this,[=](int engine){
+        if(engine == manager->m_stretchEngine) return ;
+        qDebug() << "变速音频引擎：" << engine;
+        manager->m_stretchEngine = engine;
+        player->setTimeStretchEngine(engine);
+    });
+    connect(m_settings,&SettingsWidget::audioOnlyChanged,this,[=](bool enabled){
+        if(enabled == manager->m_audioOnly) return ;
+        qDebug() << "仅播放音频：" << enabled;
+        manager->m_audioOnly = enabled;
+        player->setAudioOnly(enabled);
+        if (enabled) {     //不再刷新画面，清掉停住的旧帧
+            {
+                QMutexLocker locker(&m_frameMutex);
+                m_lastFrame = QImage();
+            }
+            m_currentTarget->clear();
+            m_currentTarget->setText("仅播放音频");
+        }
+    });
 
     // 成员对象初始化
     manager = new VideoManager(this);
@@ -56,42 +185,97 @@ MainWindow::MainWindow(QWidget *parent)
         ui->pushButton_4->setChecked(false);
 
         updateVideoRenderSize();
+        updateSurfaceVisibility();
         safeUpdatePixmap();
     });
     m_currentTarget = m_videoLabel;
+    // 最小化、隐藏或被完全遮挡时播放器只解码不显示
+    watchSurface(this);
+    watchSurface(m_fullScreen);
     // 全屏按钮点击
     connect(ui->pushButton_4, &QPushButton::clicked, this, &MainWindow::toggleFullScreen);
 
 
     //双向绑定播放按钮到Player
     connect(player, &VideoPlayer::playingChanged, ui->pushButton_2, &QPushButton::setChecked);
+#ifdef Q_OS_WIN
+    // 被其他窗口覆盖没有事件通知，只在播放期间定时检查，暂停时主线程不被周期性唤醒
+    m_occlusionTimer = new QTimer(this);
+    m_occlusionTimer->setInterval(1000);
+    connect(m_occlusionTimer, &QTimer::timeout, this, &MainWindow::updateSurfaceVisibility);
+    connect(player, &VideoPlayer::playingChanged, this, [=](bool playing){
+        if (playing) m_occlusionTimer->start();
+        else m_occlusionTimer->stop();
+        updateSurfaceVisibility();
+    });
+#endif
     //选中播放视频时切换播放
     connect(pathSel,&PathSel::fileSelected,this,[=]{
         qDebug() << "Now Sel Change to : " << manager->selected;
         const VideoFile * __file = manager->findByPos(manager->selected);
         if(!__file) return ;
         __file->printInfo();
-        player->stop();         //先暂停在切换
-        player->openFile(__file->fullPath());
+        m_streamUrl.clear();
         ui->label_7->setText(__file->durationStr());
+        setLoadingState(true);
+        player->openFileAsync(__file->fullPath());  //停止当前播放并在后台打开，完成后再起播
+    });
+    // 异步打开完成：起播或提示失败
+    connect(player, &VideoPlayer::openFinished, this, [=](bool ok, const QString &path){
+        setLoadingState(false);
+        if (!ok) {
+            m_currentTarget->setText(QString("无法打开：%1").arg(QFileInfo(path).fileName()));
+            return;
+        }
+        if (!m_streamUrl.isEmpty()) {   //网络流没有列表信息，时长取自播放器，直播流显示为直播
+            double total = player->duration();
+            ui->label_7->setText(total > 0 ? VideoFile::FormatStr(total) : QString("直播"));
+        }
         updateVideoRenderSize();    //更新缩放
+        updateAudioTrackList();
+        updateSubtitleList();
         player->play();
     });
+    // 网络地址：回车或点击播放
+    connect(ui->lineEditUrl, &QLineEdit::returnPressed, this, &MainWindow::openUrl);
+    connect(ui->toolButtonUrl, &QToolButton::clicked, this, &MainWindow::openUrl);
+    // 网络缓冲提示
+    m_bufferingTimer = new QTimer(this);
+    m_bufferingTimer->setInterval(200);
+    connect(m_bufferingTimer, &QTimer::timeout, this, [=]{
+        ui->statusbar->showMessage(QString("正在缓冲... %1%").arg(player->bufferingPercent()));
+    });
+    connect(player, &VideoPlayer::buffering, this, [=]{
+        ui->statusbar->showMessage(QString("正在缓冲... %1%").arg(player->bufferingPercent()));
+        m_bufferingTimer->start();
+    });
+    connect(player, &VideoPlayer::bufferingFinished, this, [=]{
+        m_bufferingTimer->stop();
+        ui->statusbar->clearMessage();
+    });
     // 绑定 VideoPlayer 信号到 UI
     connect(player, &VideoPlayer::frameReady, this, &MainWindow::onFrameReady);
+    // 检测到黑边后按有效画面重新计算渲染尺寸
+    connect(player, &VideoPlayer::displaySizeChanged, this, &MainWindow::updateVideoRenderSize);
     // 播放/暂停按钮
     connect(ui->pushButton_2, &QPushButton::clicked, this, &MainWindow::onPlayPauseClicked);
     // 绑定速率切换
     connect(ui->comboBox,&QComboBox::currentIndexChanged,this, &MainWindow::currentIndexSpeedChanged);
+    // 绑定音轨切换
+    connect(ui->comboBoxAudioTrack,&QComboBox::currentIndexChanged,this, &MainWindow::currentIndexAudioTrackChanged);
+    // 绑定字幕切换
+    connect(ui->comboBoxSubtitle,&QComboBox::currentIndexChanged,this, &MainWindow::currentIndexSubtitleChanged);
 
     // 初始化滚动条相关
     SlideFuncInit();
 
     // 播放器播放位置更新时，同步滑块位置
     connect(player, &VideoPlayer::positionChanged, this, [=](double pos){
-        const VideoFile* zan = manager->findByPos(manager->selected);
-        if(!zan) return ;
-        double total = zan->getNumDuration();
+        double total = currentDuration();
+        if (total <= 0) {   //未选中文件或直播流：只更新时间
+            if (!m_streamUrl.isEmpty()) ui->label_6->setText(VideoFile::FormatStr(pos));
+            return ;
+        }
         if (!ui->slider->isSliderDown()) {  // 用户未拖动时更 新滑块
             int value = int(pos / total * ui->slider->maximum());
             // qDebug() << value << ' ' << pos << ' ' << total;
@@ -107,10 +291,7 @@ MainWindow::MainWindow(QWidget *parent)
 
     // 连接 sliderMoved（计算 newPos 与 tip 位置）
     connect(ui->slider, &QSlider::sliderMoved, this, [=](int value){
-        if (manager->selected < 0) return;
-        const VideoFile* zan = manager->findByPos(manager->selected);
-        if (!zan) return;
-        double total = zan->getNumDuration();
+        double total = currentDuration();
         if (total <= 0) return;
         double newPos = double(value) / ui->slider->maximum() * total;
         QString text = VideoFile::FormatStr(newPos);
@@ -137,23 +318,25 @@ MainWindow::MainWindow(QWidget *parent)
 
         m_sliderTip->move(tipPos);
         m_sliderTip->show();
+
+        // 画面跟随把手预览
+        player->scrubTo(newPos);
     });
 
     // 隐藏 tip 在释放时 用户拖动结束时跳转视频
     connect(ui->slider, &QSlider::sliderReleased, this, [=](){
         if (m_sliderTip) m_sliderTip->hide();
-        const VideoFile* zan = manager->findByPos(manager->selected);
-        if(!zan) return ;
-        double total = zan->getNumDuration();
+        double total = currentDuration();
+        if (total <= 0) return ;
         int value = ui->slider->value();
         double newPos = double(value) / ui->slider->maximum() * total;
-        player->seek(newPos);
+        player->endScrub(newPos);
     });
 
     //播放结束，精度对齐
     connect(player, &VideoPlayer::finished, this, [=]() {
         ui->slider->setValue(ui->slider->maximum());
-        ui->label_6->setText(VideoFile::FormatStr(manager->findByPos(manager->selected)->getNumDuration()));
+        ui->label_6->setText(VideoFile::FormatStr(currentDuration()));
         if (m_fullScreen && m_fullScreen->isVisible()) {
             // 直接把 pos/total 传给全屏窗口，它会做映射
             m_fullScreen->setProgress(1.0, 1.0);
@@ -223,6 +406,7 @@ void MainWindow::toggleFullScreen()
     }
     // 更新 VideoPlayer 输出尺寸
     updateVideoRenderSize();
+    updateSurfaceVisibility();
     // 切换目标后立即刷新缓存帧
     safeUpdatePixmap();
 }
@@ -231,16 +415,21 @@ void MainWindow::toggleFullScreen()
 void MainWindow::updateVideoRenderSize()
 {
     if (!m_currentTarget || !player) return;
-    const VideoFile* __file = manager->findByPos(manager->selected);
-    if(!__file) return ;
+    // 源尺寸：已打开的文件取滤镜输出（旋转、裁剪后）的尺寸，否则列表中的文件取探测信息
+    QSize srcSize = player->displaySize();
+    if (srcSize.isEmpty()) {
+        if (const VideoFile* __file = manager->findByPos(manager->selected))
+            srcSize = QSize(__file->getWidth(), __file->getHeight());
+    }
+    if (srcSize.width() <= 0 || srcSize.height() <= 0) return ;
     QSize targetSize = m_currentTarget->size();
-    double rate = std::min(targetSize.width() * 1.0 / __file->getWidth(),targetSize.height() * 1.0 / __file->getHeight());
+    double rate = std::min(targetSize.width() * 1.0 / srcSize.width(),targetSize.height() * 1.0 / srcSize.height());
 
       // 逻辑尺寸 2239 x 1319 || 1119 x 699
     qreal dpr = m_currentTarget->devicePixelRatioF();   // DPR
 
-    int pixelW = qRound(__file->getWidth() * rate * dpr);
-    int pixelH = qRound(__file->getHeight() * rate * dpr);
+    int pixelW = qRound(srcSize.width() * rate * dpr);
+    int pixelH = qRound(srcSize.height() * rate * dpr);
 
     qDebug() << "[updateVideoRenderSize] target pixels:" << pixelW << "x" << pixelH
              << "DPR:" << dpr;
@@ -248,12 +437,96 @@ void MainWindow::updateVideoRenderSize()
     player->setRenderSize(pixelW, pixelH); // decodeLoop 会重新创建 swsCtx
 }
 
+// ----------------------- 画面可见性 -----------------------
+void MainWindow::watchSurface(QWidget *window)
+{
+    window->installEventFilter(this);
+    // X11/macOS 的遮挡体现在 QWindow 的 Expose 事件上，窗口句柄在首次显示时才创建
+    if (window->windowHandle()) window->windowHandle()->installEventFilter(this);
+}
+
+bool MainWindow::eventFilter(QObject *watched, QEvent *event)
+{
+    switch (event->type()) {
+    case QEvent::Show:
+        if (QWidget *w = qobject_cast<QWidget*>(watched); w && w->windowHandle())
+            w->windowHandle()->installEventFilter(this);    // 重复安装只会保留一份
+        Q_FALLTHROUGH();
+    case QEvent::Hide:
+    case QEvent::WindowStateChange:
+    case QEvent::Expose:
+        // 事件处理完窗口状态才更新
+        QTimer::singleShot(0, this, &MainWindow::updateSurfaceVisibility);
+        break;
+    default:
+        break;
+    }
+    return QMainWindow::eventFilter(watched, event);
+}
+
+/**
+ * @brief 当前显示目标所在的窗口被最小化、隐藏或完全遮挡时，通知播放器不再缩放和发送画面；
+ * 恢复可见时播放器从下一帧起照常显示。遮挡在 X11/macOS 上由 Expose 事件（isExposed）反映，
+ * Windows 上由播放期间的定时检查（isOccluded）发现
+ */
+void MainWindow::updateSurfaceVisibility()
+{
+    QWidget *window = m_isFullScreen ? static_cast<QWidget*>(m_fullScreen) : this;
+    QWindow *handle = window->windowHandle();
+    bool visible = window->isVisible() && !window->isMinimized()
+                   && (!handle || (handle->isExposed() && !isOccluded(handle)));
+    player->setSurfaceVisible(visible);
+}
+
+/**
+ * @brief 打开文件期间的加载状态：清空画面显示提示，禁用播放按钮（界面保持可操作）
+ */
+void MainWindow::setLoadingState(bool loading)
+{
+    ui->pushButton_2->setEnabled(!loading);
+    if (!loading) return;
+    {
+        QMutexLocker locker(&m_frameMutex);
+        m_lastFrame = QImage();     // 不再显示上一个视频的画面
+    }
+    m_currentTarget->clear();
+    m_currentTarget->setText("加载中...");
+}
+
+/**
+ * @brief 播放输入框中的网络地址：不进入文件列表，取消列表的选中行
+ */
+void MainWindow::openUrl()
+{
+    QString url = ui->lineEditUrl->text().trimmed();
+    if (url.isEmpty()) return;
+    if (!VideoPlayer::isNetworkUrl(url)) {
+        ui->statusbar->showMessage("请输入 http/https 等网络地址", 3000);
+        return;
+    }
+    pathSel->clearSelection();
+    m_streamUrl = url;
+    ui->label_7->setText("--:--");
+    setLoadingState(true);
+    player->openFileAsync(url);
+}
+
+/**
+ * @brief 当前播放内容的总时长：列表文件取探测结果，网络流取播放器（直播流为 0）
+ */
+double MainWindow::currentDuration() const
+{
+    if (const VideoFile* zan = manager->findByPos(manager->selected)) return zan->getNumDuration();
+    if (!m_streamUrl.isEmpty()) return player->duration();
+    return 0;
+}
+
 /**
  * @brief 绑定按钮与播放状态
  */
 void MainWindow::onPlayPauseClicked()
 {
-    if(manager->selected == -1) {ui->pushButton_2->setChecked(false); return ;}
+    if(manager->selected == -1 && m_streamUrl.isEmpty()) {ui->pushButton_2->setChecked(false); return ;}
     if (ui->pushButton_2->isChecked()) {
         player->play();  // 如果暂停中，继续播放
     } else {
@@ -276,6 +549,84 @@ void MainWindow::currentIndexSpeedChanged(int index)
     qDebug() << "Change Rate to " << manager->playSpeed;
 }
 
+/**
+ * @brief 音轨选择
+ */
+void MainWindow::currentIndexAudioTrackChanged(int index)
+{
+    if(index < 0) return;
+    int stream = ui->comboBoxAudioTrack->itemData(index).toInt();
+    if(stream == player->currentAudioTrack()) return;
+    qDebug() << "Change Audio Track to stream" << stream;
+    player->setAudioTrack(stream);
+}
+
+/**
+ * @brief 按当前文件的音轨重新填充下拉框，只有一条音轨时禁用
+ */
+void MainWindow::updateAudioTrackList()
+{
+    QSignalBlocker blocker(ui->comboBoxAudioTrack);
+    ui->comboBoxAudioTrack->clear();
+    const QList<VideoPlayer::AudioTrack> tracks = player->audioTracks();
+    for (int i = 0; i < tracks.size(); ++i) {
+        const VideoPlayer::AudioTrack &t = tracks[i];
+        QString text = QString("音轨 %1").arg(i + 1);
+        if (!t.language.isEmpty()) text += " " + t.language;
+        text += QString(" %1 %2ch").arg(t.codec.toUpper()).arg(t.channels);
+        if (!t.title.isEmpty()) text += " - " + t.title;
+        ui->comboBoxAudioTrack->addItem(text, t.streamIndex);
+        if (t.streamIndex == player->currentAudioTrack()) ui->comboBoxAudioTrack->setCurrentIndex(i);
+    }
+    ui->comboBoxAudioTrack->setEnabled(tracks.size() > 1 && player->currentAudioTrack() >= 0);
+}
+
+/**
+ * @brief 字幕选择，最后一项为加载外挂字幕文件
+ */
+void MainWindow::currentIndexSubtitleChanged(int index)
+{
+    if(index < 0) return;
+    int selection = ui->comboBoxSubtitle->itemData(index).toInt();
+    if(selection == SUBTITLE_LOAD_FILE) {
+        QString path = QFileDialog::getOpenFileName(this, "加载字幕", QString(), "字幕文件 (*.srt *.ass *.ssa)");
+        if(!path.isEmpty() && !player->loadSubtitleFile(path)) {
+            qDebug() << "Load subtitle failed:" << path;
+        }
+        updateSubtitleList();
+        return;
+    }
+    if(selection == player->currentSubtitle()) return;
+    qDebug() << "Change Subtitle to" << selection;
+    player->setSubtitle(selection);
+}
+
+/**
+ * @brief 按当前文件的内嵌字幕流和外挂字幕重新填充下拉框
+ */
+void MainWindow::updateSubtitleList()
+{
+    QSignalBlocker blocker(ui->comboBoxSubtitle);
+    ui->comboBoxSubtitle->clear();
+    ui->comboBoxSubtitle->addItem("关闭字幕", VideoPlayer::SUBTITLE_OFF);
+    const QList<VideoPlayer::SubtitleStream> streams = player->subtitleStreams();
+    for (int i = 0; i < streams.size(); ++i) {
+        const VideoPlayer::SubtitleStream &t = streams[i];
+        QString text = QString("字幕 %1").arg(i + 1);
+        if (!t.language.isEmpty()) text += " " + t.language;
+        if (!t.title.isEmpty()) text += " - " + t.title;
+        ui->comboBoxSubtitle->addItem(text, t.streamIndex);
+    }
+    if (!player->externalSubtitleName().isEmpty()) {
+        ui->comboBoxSubtitle->addItem("外挂：" + player->externalSubtitleName(), VideoPlayer::SUBTITLE_EXTERNAL);
+    }
+    ui->comboBoxSubtitle->addItem("加载字幕文件…", SUBTITLE_LOAD_FILE);
+
+    int current = ui->comboBoxSubtitle->findData(player->currentSubtitle());
+    ui->comboBoxSubtitle->setCurrentIndex(current >= 0 ? current : 0);
+    ui->comboBoxSubtitle->setEnabled(true);
+}
+
 /**
  * @brief 滑动条和tip和视频窗口初始化函数
  */
@@ -337,6 +688,18 @@ void MainWindow::KeysInit(){
     connect(backwardShortcut, &QShortcut::activated, this, [this]() {
         player->forward(-5.0);
     });
+    // 逐帧向前：'.'（可按住连续步进）
+    auto *stepForwardShortcut = new QShortcut(QKeySequence(Qt::Key_Period), this);
+    stepForwardShortcut->setContext(Qt::ApplicationShortcut);
+    connect(stepForwardShortcut, &QShortcut::activated, this, [this]() {
+        player->stepFrame(1);
+    });
+    // 逐帧向后：','
+    auto *stepBackwardShortcut = new QShortcut(QKeySequence(Qt::Key_Comma), this);
+    stepBackwardShortcut->setContext(Qt::ApplicationShortcut);
+    connect(stepBackwardShortcut, &QShortcut::activated, this, [this]() {
+        player->stepFrame(-1);
+    });
 }
 
 
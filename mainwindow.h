@@ -29,12 +29,18 @@ public:
 
     void updateVideoRenderSize();
 
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
 private slots:
     void onFrameReady(const QImage &img);
     void onPlayPauseClicked();
     void toggleFullScreen();
 
     void currentIndexSpeedChanged(int index);
+    void currentIndexAudioTrackChanged(int index);
+    void currentIndexSubtitleChanged(int index);
+    void openUrl();                     // 播放输入框中的网络地址
 
 private:
     Ui::MainWindow *ui;
@@ -50,6 +56,9 @@ private:
     FullScreenWindow *m_fullScreen;   // 全屏窗口
     QLabel *m_currentTarget;          // 当前显示目标（主UI 或 全屏UI）
     bool m_isFullScreen = false;
+    QString m_streamUrl;              // 正在播放的网络地址，播放列表文件时为空
+    QTimer *m_bufferingTimer = nullptr;   // 缓冲期间刷新状态栏进度
+    QTimer *m_occlusionTimer = nullptr;   // Windows：播放期间定时检查窗口是否被完全遮挡
 
     QImage m_lastFrame;        // 缓存最新视频帧
     QMutex m_frameMutex;       // 保护 m_lastFrame
@@ -59,6 +68,12 @@ private:
     void KeysInit();                    //快捷键绑定函数
 
     void safeUpdatePixmap(); // 用于主线程刷新 pixmap
+    void setLoadingState(bool loading); // 异步打开文件期间的加载提示
+    void updateAudioTrackList();        // 打开文件后刷新音轨下拉框
+    void updateSubtitleList();          // 打开文件或加载字幕后刷新字幕下拉框
+    double currentDuration() const;     // 列表文件或网络流的总时长（秒）
+    void watchSurface(QWidget *window); // 跟踪窗口的最小化/显隐/遮挡
+    void updateSurfaceVisibility();     // 显示目标不可见时让播放器跳过缩放与显示
 
 };
 #endif // MAINWINDOW_H
@@ -0,0 +1,182 @@
+#include "mappedfileio.h"
+#include <QDebug>
+#include <QFileInfo>
+#include <QUrl>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+extern "C" {
+#include <libavutil/error.h>
+#include <libavutil/mem.h>
+}
+
+#if defined(Q_OS_UNIX)
+#include <sys/mman.h>
+#include <unistd.h>
+#elif defined(Q_OS_WIN)
+#include <windows.h>
+#endif
+
+namespace {
+// 给内核的预读提示：[addr, addr + len) 即将被读取
+void adviseWillNeed(uchar *addr, qint64 len)
+{
+#if defined(Q_OS_UNIX)
+    static const qint64 page = qMax<qint64>(4096, sysconf(_SC_PAGESIZE));
+    quintptr p = reinterpret_cast<quintptr>(addr);
+    quintptr aligned = p - p % quintptr(page);
+    posix_madvise(reinterpret_cast<void*>(aligned), size_t(len + qint64(p - aligned)), POSIX_MADV_WILLNEED);
+#elif defined(Q_OS_WIN)
+    // PrefetchVirtualMemory 从 Windows 8 开始提供，按需动态解析
+    struct RangeEntry { PVOID address; SIZE_T bytes; };
+    using PrefetchFn = BOOL (WINAPI *)(HANDLE, ULONG_PTR, RangeEntry*, ULONG);
+    static const PrefetchFn prefetch = reinterpret_cast<PrefetchFn>(
+        reinterpret_cast<void*>(GetProcAddress(GetModuleHandleW(L"kernel32.dll"), "PrefetchVirtualMemory")));
+    if (!prefetch) return;
+    RangeEntry range{addr, SIZE_T(len)};
+    prefetch(GetCurrentProcess(), 1, &range, 0);
+#else
+    Q_UNUSED(addr);
+    Q_UNUSED(len);
+#endif
+}
+}
+
+MappedFileIO::~MappedFileIO()
+{
+    if (m_ctx) {
+        av_freep(&m_ctx->buffer);
+        avio_context_free(&m_ctx);
+    }
+    if (m_map) m_file.unmap(m_map);
+}
+
+bool MappedFileIO::isLocalFile(const QString &path)
+{
+    // Windows 盘符路径 "C:/..." 会被当成 scheme 为 c 的 URL，只把两个字符以上的 scheme 视为网络地址
+    QUrl url(path);
+    if (url.scheme().size() > 1 && !url.isLocalFile()) return false;
+    return QFileInfo(path).isFile();
+}
+
+bool MappedFileIO::open(const QString &path)
+{
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) return false;
+    m_size = m_file.size();
+    if (m_size <= 0 || !mapWindow(0)) return false;
+
+    auto *buffer = static_cast<unsigned char*>(av_malloc(AVIO_BUFFER_SIZE));
+    if (!buffer) return false;
+    m_ctx = avio_alloc_context(buffer, AVIO_BUFFER_SIZE, 0, this, &MappedFileIO::readPacket, nullptr, &MappedFileIO::seek);
+    if (!m_ctx) {
+        av_free(buffer);
+        return false;
+    }
+    // 大于缓冲的读取直接从映射区拷到目标，seek 也不经过缓冲
+    m_ctx->direct = 1;
+    adviseAround(0, false);
+    return true;
+}
+
+MappedFileIO::Stats MappedFileIO::stats() const
+{
+    Stats st;
+    st.reads = m_reads.load();
+    st.bytes = m_bytes.load();
+    st.seeks = m_seeks.load();
+    st.remaps = m_remaps.load();
+    return st;
+}
+
+/**
+ * @brief 64 位进程中不太大的文件整体映射一次；否则按 WINDOW_SIZE 对齐的窗口映射
+ */
+bool MappedFileIO::mapWindow(qint64 pos)
+{
+    if (m_map && pos >= m_mapStart && pos < m_mapStart + m_mapLength) return true;
+    if (m_map) {
+        m_file.unmap(m_map);
+        m_map = nullptr;
+    }
+
+    qint64 start = 0;
+    qint64 length = m_size;
+    if (sizeof(void*) < 8 || m_size > WHOLE_FILE_LIMIT) {
+        start = pos - pos % WINDOW_SIZE;
+        length = std::min(WINDOW_SIZE, m_size - start);
+    }
+    m_map = m_file.map(start, length);
+    if (!m_map) {
+        qWarning() << "MappedFileIO: map failed" << m_file.fileName() << m_file.errorString();
+        return false;
+    }
+    m_mapStart = start;
+    m_mapLength = length;
+    m_advisedFrom = m_advisedTo = -1;
+    ++m_remaps;
+    return true;
+}
+
+/**
+ * @brief 顺序读取时预取前方 READAHEAD；向后跳转时预取目标之前的一段，快退的下一个关键帧多半在那里
+ */
+void MappedFileIO::adviseAround(qint64 pos, bool backward)
+{
+    qint64 from = backward ? pos - READAHEAD : pos;
+    qint64 to = backward ? pos + READAHEAD / 8 : pos + READAHEAD;
+    from = std::max(from, m_mapStart);
+    to = std::min(to, m_mapStart + m_mapLength);
+    if (to <= from) return;
+    adviseWillNeed(m_map + (from - m_mapStart), to - from);
+    m_advisedFrom = from;
+    m_advisedTo = to;
+}
+
+int MappedFileIO::read(uint8_t *buf, int size)
+{
+    if (m_pos >= m_size) return AVERROR_EOF;
+    if (!mapWindow(m_pos)) return AVERROR(EIO);
+
+    // 跨窗口时先返回本窗口内的部分，下次读取再映射下一个窗口
+    qint64 n = std::min<qint64>(size, m_mapStart + m_mapLength - m_pos);
+    std::memcpy(buf, m_map + (m_pos - m_mapStart), size_t(n));
+    m_pos += n;
+    ++m_reads;
+    m_bytes += n;
+
+    // 读过已提示范围的一半时继续向前提示
+    if (m_pos > m_advisedTo - READAHEAD / 2 || m_pos < m_advisedFrom) adviseAround(m_pos, false);
+    return int(n);
+}
+
+int MappedFileIO::readPacket(void *opaque, uint8_t *buf, int size)
+{
+    return static_cast<MappedFileIO*>(opaque)->read(buf, size);
+}
+
+int64_t MappedFileIO::seek(void *opaque, int64_t offset, int whence)
+{
+    auto *io = static_cast<MappedFileIO*>(opaque);
+    whence &= ~AVSEEK_FORCE;
+    if (whence == AVSEEK_SIZE) return io->m_size;
+
+    qint64 target;
+    switch (whence) {
+    case SEEK_SET: target = offset; break;
+    case SEEK_CUR: target = io->m_pos + offset; break;
+    case SEEK_END: target = io->m_size + offset; break;
+    default: return AVERROR(EINVAL);
+    }
+    if (target < 0) return AVERROR(EINVAL);
+
+    bool backward = target < io->m_pos;
+    io->m_pos = target;
+    ++io->m_seeks;
+    if (target < io->m_size && io->mapWindow(target)
+        && (target < io->m_advisedFrom || target >= io->m_advisedTo)) {
+        io->adviseAround(target, backward);
+    }
+    return target;
+}
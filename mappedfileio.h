@@ -0,0 +1,73 @@
+#ifndef MAPPEDFILEIO_H
+#define MAPPEDFILEIO_H
+
+#include <QFile>
+#include <QString>
+#include <atomic>
+
+extern "C" {
+#include <libavformat/avio.h>
+}
+
+/**
+ * @brief 本地文件的内存映射 AVIOContext
+ *
+ * 代替 FFmpeg 默认的 file 协议（每次 read() 一个 32 KB 缓冲）：文件按大窗口映射，
+ * 读取与 seek 直接在映射区上完成，没有 read 系统调用；AVIOContext 设为 direct，
+ * 大块读取直接从映射区拷入 FFmpeg 的目标缓冲。
+ * 按读取方向给内核预读提示：顺序前进时预取前方，向后跳（快退）时预取后方。
+ *
+ * 用法：open() 成功后把 context() 赋给 AVFormatContext::pb 并设置 AVFMT_FLAG_CUSTOM_IO；
+ * 必须在 avformat_close_input 之后再析构。只在一个线程中使用，统计可跨线程读取。
+ */
+class MappedFileIO
+{
+public:
+    struct Stats {
+        qint64 reads = 0;       // read 回调次数
+        qint64 bytes = 0;       // 读取字节数
+        qint64 seeks = 0;
+        qint64 remaps = 0;      // 映射（窗口切换）次数
+    };
+
+    MappedFileIO() = default;
+    ~MappedFileIO();
+    MappedFileIO(const MappedFileIO &) = delete;
+    MappedFileIO &operator=(const MappedFileIO &) = delete;
+
+    bool open(const QString &path);
+    AVIOContext *context() const { return m_ctx; }
+    Stats stats() const;
+
+    static bool isLocalFile(const QString &path);   // 不是 URL 且文件存在
+
+private:
+    static int readPacket(void *opaque, uint8_t *buf, int size);
+    static int64_t seek(void *opaque, int64_t offset, int whence);
+
+    int read(uint8_t *buf, int size);
+    bool mapWindow(qint64 pos);             // 确保 pos 落在当前映射窗口内
+    void adviseAround(qint64 pos, bool backward);
+
+    static constexpr qint64 WINDOW_SIZE = 256LL * 1024 * 1024;     // 大文件按窗口映射
+    static constexpr qint64 WHOLE_FILE_LIMIT = 2LL * 1024 * 1024 * 1024;   // 64 位下不超过该大小时整体映射
+    static constexpr qint64 READAHEAD = 8LL * 1024 * 1024;         // 预读提示的长度
+    static constexpr int AVIO_BUFFER_SIZE = 256 * 1024;
+
+    QFile m_file;
+    qint64 m_size = 0;
+    qint64 m_pos = 0;
+    uchar *m_map = nullptr;
+    qint64 m_mapStart = 0;
+    qint64 m_mapLength = 0;
+    qint64 m_advisedFrom = -1;              // 最近一次预读提示覆盖的范围
+    qint64 m_advisedTo = -1;
+    AVIOContext *m_ctx = nullptr;
+
+    std::atomic<qint64> m_reads{0};
+    std::atomic<qint64> m_bytes{0};
+    std::atomic<qint64> m_seeks{0};
+    std::atomic<qint64> m_remaps{0};
+};
+
+#endif // MAPPEDFILEIO_H
@@ -0,0 +1,133 @@
+#include "memorybudget.h"
+#include <QMutexLocker>
+
+namespace {
+// 各队列占总上限的比例，总和为 1
+constexpr double kShares[MemoryBudget::QueueCount] = {
+    0.15,   // AudioPcm
+    0.10,   // GopPackets
+    0.40,   // GopFrames
+    0.10,   // NetPackets
+    0.10,   // RewindFrames
+    0.15,   // StepFrames
+};
+
+QString toMB(qint64 bytes)
+{
+    return QString::number(bytes / (1024.0 * 1024.0), 'f', 1);
+}
+}
+
+MemoryBudget::MemoryBudget(qint64 limitBytes)
+    : m_limit(limitBytes > 0 ? limitBytes : DEFAULT_LIMIT)
+{
+}
+
+void MemoryBudget::setLimit(qint64 bytes)
+{
+    if (bytes <= 0) return;
+    QMutexLocker locker(&m_mutex);
+    m_limit = bytes;
+    m_released.wakeAll();   // 上限变大时让等待者重新检查
+}
+
+qint64 MemoryBudget::limit() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_limit;
+}
+
+qint64 MemoryBudget::quota(Queue q) const
+{
+    QMutexLocker locker(&m_mutex);
+    return qint64(m_limit * kShares[q]);
+}
+
+void MemoryBudget::acquire(Queue q, qint64 bytes)
+{
+    if (bytes <= 0) return;
+    QMutexLocker locker(&m_mutex);
+    m_used[q] += bytes;
+    if (m_used[q] > m_highWater[q]) m_highWater[q] = m_used[q];
+}
+
+void MemoryBudget::release(Queue q, qint64 bytes)
+{
+    if (bytes <= 0) return;
+    QMutexLocker locker(&m_mutex);
+    m_used[q] -= bytes;
+    if (m_used[q] < 0) m_used[q] = 0;
+    m_released.wakeAll();
+}
+
+void MemoryBudget::clear(Queue q)
+{
+    QMutexLocker locker(&m_mutex);
+    m_used[q] = 0;
+    m_released.wakeAll();
+}
+
+bool MemoryBudget::hasRoom(Queue q) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_used[q] < qint64(m_limit * kShares[q]);
+}
+
+bool MemoryBudget::waitForRoom(Queue q, int timeoutMs)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_used[q] < qint64(m_limit * kShares[q])) return true;
+    m_released.wait(&m_mutex, timeoutMs);
+    return m_used[q] < qint64(m_limit * kShares[q]);
+}
+
+qint64 MemoryBudget::used(Queue q) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_used[q];
+}
+
+qint64 MemoryBudget::totalUsed() const
+{
+    QMutexLocker locker(&m_mutex);
+    qint64 total = 0;
+    for (qint64 u : m_used) total += u;
+    return total;
+}
+
+qint64 MemoryBudget::highWater(Queue q) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_highWater[q];
+}
+
+void MemoryBudget::resetHighWater()
+{
+    QMutexLocker locker(&m_mutex);
+    m_highWater = m_used;
+}
+
+QString MemoryBudget::report() const
+{
+    QMutexLocker locker(&m_mutex);
+    QString out = QString("MemoryBudget limit %1 MB").arg(toMB(m_limit));
+    for (int i = 0; i < QueueCount; ++i) {
+        out += QString("\n  %1: used %2 MB, high-water %3 MB, quota %4 MB")
+                   .arg(QString::fromLatin1(queueName(Queue(i))), -11)
+                   .arg(toMB(m_used[i]), toMB(m_highWater[i]), toMB(qint64(m_limit * kShares[i])));
+    }
+    return out;
+}
+
+const char *MemoryBudget::queueName(Queue q)
+{
+    switch (q) {
+    case AudioPcm:   return "AudioPcm";
+    case GopPackets: return "GopPackets";
+    case GopFrames:  return "GopFrames";
+    case NetPackets: return "NetPackets";
+    case RewindFrames: return "RewindFrames";
+    case StepFrames: return "StepFrames";
+    default:         return "Unknown";
+    }
+}
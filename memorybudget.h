@@ -0,0 +1,59 @@
+#ifndef MEMORYBUDGET_H
+#define MEMORYBUDGET_H
+
+#include <QMutex>
+#include <QWaitCondition>
+#include <QString>
+#include <array>
+
+/**
+ * @brief 播放器内存预算
+ *
+ * 播放器内所有缓冲队列（解码帧、压缩包、PCM）都按字节记账，共享一个可配置的总上限，
+ * 每个队列按固定比例分得配额；生产者在配额用尽时应等待或施加背压。
+ * 同时记录每个队列的高水位，便于观察实际占用。线程安全。
+ */
+class MemoryBudget
+{
+public:
+    enum Queue {
+        AudioPcm = 0,   // 待写入声卡的 PCM
+        GopPackets,     // GOP 并行引擎缓存的压缩包
+        GopFrames,      // GOP 并行引擎解码完成、待显示的帧
+        NetPackets,     // 网络流解复用线程缓冲的压缩包
+        RewindFrames,   // 快退缓存中 JPEG 压缩的已显示画面
+        StepFrames,     // 逐帧浏览窗口中解码好的帧
+        QueueCount
+    };
+
+    static constexpr qint64 DEFAULT_LIMIT = 256LL * 1024 * 1024;
+
+    explicit MemoryBudget(qint64 limitBytes = DEFAULT_LIMIT);
+
+    void setLimit(qint64 bytes);
+    qint64 limit() const;
+    qint64 quota(Queue q) const;            // 该队列可用的字节数
+
+    void acquire(Queue q, qint64 bytes);    // 记账（不阻塞，超额由调用方通过 hasRoom 施加背压）
+    void release(Queue q, qint64 bytes);
+    void clear(Queue q);                    // 队列整体清空时归零
+    bool hasRoom(Queue q) const;
+    bool waitForRoom(Queue q, int timeoutMs);   // 等待其他线程释放，返回是否有空间
+
+    qint64 used(Queue q) const;
+    qint64 totalUsed() const;
+    qint64 highWater(Queue q) const;
+    void resetHighWater();
+    QString report() const;                 // 各队列 当前/高水位/配额
+
+    static const char *queueName(Queue q);
+
+private:
+    mutable QMutex m_mutex;
+    QWaitCondition m_released;
+    qint64 m_limit;
+    std::array<qint64, QueueCount> m_used{};
+    std::array<qint64, QueueCount> m_highWater{};
+};
+
+#endif // MEMORYBUDGET_H
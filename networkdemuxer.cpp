@@ -0,0 +1,369 @@
+#include "networkdemuxer.h"
+#include "memorybudget.h"
+#include <QDeadlineTimer>
+#include <QDebug>
+#include <QMutexLocker>
+#include <QUrl>
+#include <algorithm>
+
+extern "C" {
+#include <libavutil/error.h>
+}
+
+NetworkDemuxer::NetworkDemuxer(AVFormatContext *fmt, int refStream, const std::atomic<bool> &stopFlag)
+    : m_fmt(fmt)
+    , m_refStream(refStream)
+    , m_stopFlag(stopFlag)
+    , m_lastDts(fmt->nb_streams, AV_NOPTS_VALUE)
+    , m_lastTs(fmt->nb_streams, AV_NOPTS_VALUE)
+    , m_resyncing(fmt->nb_streams, 0)
+{
+}
+
+NetworkDemuxer::~NetworkDemuxer()
+{
+    if (m_thread) {
+        m_spaceCond.wakeAll();
+        m_thread->wait();
+        delete m_thread;
+    }
+    QMutexLocker locker(&m_mutex);
+    clearLocked();
+}
+
+bool NetworkDemuxer::isNetworkUrl(const QString &path)
+{
+    // 与 MappedFileIO::isLocalFile 相同：单字符 scheme 是 Windows 盘符
+    QUrl url(path);
+    return url.scheme().size() > 1 && !url.isLocalFile();
+}
+
+AVDictionary *NetworkDemuxer::openOptions()
+{
+    AVDictionary *opts = nullptr;
+    av_dict_set(&opts, "reconnect", "1", 0);
+    av_dict_set(&opts, "reconnect_streamed", "1", 0);
+    av_dict_set(&opts, "reconnect_on_network_error", "1", 0);
+    av_dict_set(&opts, "reconnect_delay_max", "4", 0);
+    av_dict_set(&opts, "rw_timeout", "10000000", 0);     // 微秒：单次读取最多阻塞 10 秒
+    return opts;
+}
+
+void NetworkDemuxer::start(MemoryBudget *budget)
+{
+    m_budget = budget;
+    m_thread = QThread::create([this]() { run(); });
+    m_thread->start();
+}
+
+void NetworkDemuxer::run()
+{
+    AVPacket *pkt = av_packet_alloc();
+    int attempt = 0;
+    while (pkt && !m_stopFlag.load()) {
+        {
+            QMutexLocker locker(&m_mutex);
+            if (m_discardPending || m_refPending) applyStreamConfigLocked();
+            if (m_seekPending) {
+                m_seekPending = false;
+                m_abortRead.store(false);
+                const int stream = m_seekStream;
+                const int64_t ts = m_seekTs;
+                const int flags = m_seekFlags;
+                const quint64 ticket = m_seekRequested;
+                locker.unlock();
+
+                int ret = av_seek_frame(m_fmt, stream, ts, flags);
+                std::fill(m_lastDts.begin(), m_lastDts.end(), AV_NOPTS_VALUE);
+                std::fill(m_lastTs.begin(), m_lastTs.end(), AV_NOPTS_VALUE);
+                std::fill(m_resyncing.begin(), m_resyncing.end(), 0);
+                m_lastPos = -1;
+                m_lastRefSec = m_lastAdjSec = -1.0;
+                m_timeOffset = 0.0;
+                attempt = 0;
+
+                locker.relock();
+                clearLocked();
+                m_eof = false;
+                m_error = 0;
+                m_buffering = true;
+                m_resumeSec = START_WATERMARK_SEC;
+                m_seekResult = ret;
+                m_seekCompleted = ticket;
+                m_dataCond.wakeAll();
+                continue;
+            }
+            bool full = levelLocked() >= MAX_BUFFER_SEC
+                        || (m_budget && !m_budget->hasRoom(MemoryBudget::NetPackets));
+            if (m_eof || m_error || full) {
+                m_spaceCond.wait(&m_mutex, 100);
+                continue;
+            }
+        }
+
+        int ret = av_read_frame(m_fmt, pkt);
+        if (ret >= 0) {
+            attempt = 0;
+            if (isDuplicate(pkt)) av_packet_unref(pkt);
+            else push(pkt);
+            continue;
+        }
+        if (ret == AVERROR_EXIT) continue;      // 被 seek 请求或停止打断
+
+        if (ret == AVERROR_EOF && !looksTruncated()) {
+            QMutexLocker locker(&m_mutex);
+            m_eof = true;
+            m_dataCond.wakeAll();
+            continue;
+        }
+        if (attempt >= MAX_RECONNECTS) {
+            qWarning() << "NetworkDemuxer: giving up after" << attempt << "reconnects";
+            QMutexLocker locker(&m_mutex);
+            m_error = ret;
+            m_dataCond.wakeAll();
+            continue;
+        }
+        reconnect(ret, ++attempt);
+    }
+    av_packet_free(&pkt);
+}
+
+/**
+ * @brief 连接断开时 http 也可能只报告 EOF：时长已知、可 seek 且离结尾还远时按中断处理
+ */
+bool NetworkDemuxer::looksTruncated() const
+{
+    if (!m_fmt->pb || !(m_fmt->pb->seekable & AVIO_SEEKABLE_NORMAL)) return false;
+    if (m_fmt->duration <= 0 || m_lastRefSec < 0.0) return false;
+    double start = m_fmt->start_time != AV_NOPTS_VALUE ? m_fmt->start_time / double(AV_TIME_BASE) : 0.0;
+    return m_lastRefSec - start + 1.0 < m_fmt->duration / double(AV_TIME_BASE);
+}
+
+void NetworkDemuxer::reconnect(int error, int attempt)
+{
+    char msg[AV_ERROR_MAX_STRING_SIZE] = {0};
+    av_strerror(error, msg, sizeof(msg));
+    int delayMs = std::min(250 << attempt, 4000);
+    qWarning() << "NetworkDemuxer: read failed (" << msg << "), reconnect" << attempt << "in" << delayMs << "ms";
+    ++m_reconnects;
+    if (!sleepInterruptible(delayMs)) return;
+
+    // 出错后 AVIOContext 停在 EOF/错误状态，清掉后下一次读取才会重新发起请求
+    if (m_fmt->pb) {
+        m_fmt->pb->eof_reached = 0;
+        m_fmt->pb->error = 0;
+    }
+    // 可 seek 的流回到最后读到的位置之前的关键帧，重新读到的已入队部分由 isDuplicate 丢弃；直播流直接继续读取
+    if (m_fmt->pb && (m_fmt->pb->seekable & AVIO_SEEKABLE_NORMAL) && m_refStream >= 0
+        && m_lastTs[m_refStream] != AV_NOPTS_VALUE
+        && av_seek_frame(m_fmt, m_refStream, m_lastTs[m_refStream], AVSEEK_FLAG_BACKWARD) >= 0) {
+        for (size_t i = 0; i < m_resyncing.size(); ++i)
+            m_resyncing[i] = m_lastPos >= 0 || m_lastDts[i] != AV_NOPTS_VALUE;
+    }
+}
+
+bool NetworkDemuxer::sleepInterruptible(int ms)
+{
+    QDeadlineTimer deadline(ms);
+    QMutexLocker locker(&m_mutex);
+    while (!m_stopFlag.load() && !m_seekPending && !deadline.hasExpired()) m_spaceCond.wait(&m_mutex, deadline);
+    return !m_stopFlag.load() && !m_seekPending;
+}
+
+/**
+ * @brief 重连 seek 回退后丢弃断点之前已入队过的包
+ *
+ * 优先按文件偏移判断：偏移对所有流单调，越过断点即全部恢复。没有偏移时各流分别按 dts 判断——
+ * 各流交错并不同步，参考流追上断点时其它流可能还在重复，不能以参考流为准一起结束。
+ */
+bool NetworkDemuxer::isDuplicate(const AVPacket *pkt)
+{
+    const int idx = pkt->stream_index;
+    if (idx < 0 || idx >= int(m_lastDts.size())) return false;
+    if (m_resyncing[idx]) {
+        if (pkt->pos >= 0 && m_lastPos >= 0) {
+            if (pkt->pos <= m_lastPos) return true;
+            std::fill(m_resyncing.begin(), m_resyncing.end(), 0);
+        } else if (pkt->dts != AV_NOPTS_VALUE && m_lastDts[idx] != AV_NOPTS_VALUE) {
+            if (pkt->dts <= m_lastDts[idx]) return true;
+            m_resyncing[idx] = 0;
+        }
+    }
+    m_lastPos = std::max(m_lastPos, pkt->pos);
+    if (pkt->dts != AV_NOPTS_VALUE) m_lastDts[idx] = pkt->dts;
+    const int64_t ts = pkt->dts != AV_NOPTS_VALUE ? pkt->dts : pkt->pts;
+    if (ts != AV_NOPTS_VALUE) m_lastTs[idx] = ts;
+    return false;
+}
+
+double NetworkDemuxer::refTime(const AVPacket *pkt)
+{
+    if (m_refStream < 0 || pkt->stream_index != m_refStream) return -1.0;
+    int64_t t = pkt->dts != AV_NOPTS_VALUE ? pkt->dts : pkt->pts;
+    if (t == AV_NOPTS_VALUE) return -1.0;
+    double raw = t * av_q2d(m_fmt->streams[m_refStream]->time_base);
+    m_lastRefSec = raw;
+    // 时间戳回绕或 HLS 分段不连续时把跳变折算掉，缓冲量按连续时间计算
+    double sec = raw + m_timeOffset;
+    if (m_lastAdjSec >= 0.0 && (sec < m_lastAdjSec - 1.0 || sec > m_lastAdjSec + 10.0)) {
+        m_timeOffset += m_lastAdjSec - sec;
+        sec = m_lastAdjSec;
+    }
+    m_lastAdjSec = sec;
+    return sec;
+}
+
+void NetworkDemuxer::push(AVPacket *pkt)
+{
+    const double sec = refTime(pkt);
+
+    AVPacket *p = av_packet_alloc();
+    if (!p) return;
+    av_packet_move_ref(p, pkt);
+
+    QMutexLocker locker(&m_mutex);
+    m_queue.push_back({p, sec});
+    if (sec >= 0.0) m_refTimes.push_back(sec);
+    m_bytes += p->size;
+    if (m_budget) m_budget->acquire(MemoryBudget::NetPackets, p->size);
+    m_dataCond.wakeAll();
+}
+
+/**
+ * @brief 水位状态机只在这里转换：解码线程取包时判断是否进入/离开缓冲状态
+ */
+int NetworkDemuxer::read(AVPacket *out, bool honorWatermarks)
+{
+    QMutexLocker locker(&m_mutex);
+    const bool ended = m_eof || m_error;
+    if (honorWatermarks) {
+        const double level = levelLocked();
+        if (m_buffering) {
+            bool ready = ended || level >= m_resumeSec
+                         || (m_budget && !m_budget->hasRoom(MemoryBudget::NetPackets));
+            if (!ready) return AVERROR(EAGAIN);
+            m_buffering = false;
+        } else if (!ended && level < LOW_WATERMARK_SEC) {
+            m_buffering = true;
+            m_resumeSec = HIGH_WATERMARK_SEC;
+            ++m_rebuffers;
+            return AVERROR(EAGAIN);
+        }
+    }
+
+    if (m_queue.empty()) {
+        if (m_error) return m_error;
+        return m_eof ? AVERROR_EOF : AVERROR(EAGAIN);
+    }
+    Entry e = m_queue.front();
+    m_queue.pop_front();
+    if (e.sec >= 0.0) m_refTimes.pop_front();
+    m_bytes -= e.packet->size;
+    if (m_budget) m_budget->release(MemoryBudget::NetPackets, e.packet->size);
+    av_packet_move_ref(out, e.packet);
+    av_packet_free(&e.packet);
+    m_spaceCond.wakeAll();
+    return 0;
+}
+
+void NetworkDemuxer::setStreamDiscard(const std::vector<AVDiscard> &discard)
+{
+    QMutexLocker locker(&m_mutex);
+    m_discardRequest = discard;
+    m_discardPending = true;
+    m_spaceCond.wakeAll();
+}
+
+void NetworkDemuxer::setReferenceStream(int streamIndex)
+{
+    QMutexLocker locker(&m_mutex);
+    m_refRequest = streamIndex;
+    m_refPending = true;
+    m_spaceCond.wakeAll();
+}
+
+/**
+ * @brief 读取线程中执行流配置请求。换参考流时把队列中已有的包按新的流重新计时，
+ *        缓冲量立即按新的流计算（例如切到纯音频后不再等待永远不会到来的视频包）
+ */
+void NetworkDemuxer::applyStreamConfigLocked()
+{
+    if (m_discardPending) {
+        m_discardPending = false;
+        for (unsigned i = 0; i < m_fmt->nb_streams && i < m_discardRequest.size(); ++i)
+            m_fmt->streams[i]->discard = m_discardRequest[i];
+    }
+    if (m_refPending) {
+        m_refPending = false;
+        if (m_refRequest == m_refStream) return;
+        m_refStream = m_refRequest;
+        m_lastRefSec = m_lastAdjSec = -1.0;
+        m_timeOffset = 0.0;
+        m_refTimes.clear();
+        for (Entry &e : m_queue) {
+            e.sec = refTime(e.packet);
+            if (e.sec >= 0.0) m_refTimes.push_back(e.sec);
+        }
+        m_dataCond.wakeAll();
+    }
+}
+
+void NetworkDemuxer::waitForData(int timeoutMs)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_eof && !m_error && !m_stopFlag.load()) m_dataCond.wait(&m_mutex, timeoutMs);
+}
+
+int NetworkDemuxer::seek(int streamIndex, int64_t ts, int flags)
+{
+    QMutexLocker locker(&m_mutex);
+    m_seekStream = streamIndex;
+    m_seekTs = ts;
+    m_seekFlags = flags;
+    m_seekPending = true;
+    const quint64 ticket = ++m_seekRequested;
+    m_abortRead.store(true);
+    m_spaceCond.wakeAll();
+    while (m_seekCompleted < ticket && !m_stopFlag.load()) m_dataCond.wait(&m_mutex, 50);
+    return m_seekCompleted >= ticket ? m_seekResult : AVERROR_EXIT;
+}
+
+bool NetworkDemuxer::isBuffering() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_buffering;
+}
+
+int NetworkDemuxer::bufferingPercent() const
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_buffering) return 100;
+    return std::clamp(int(levelLocked() / m_resumeSec * 100.0), 0, 99);
+}
+
+NetworkDemuxer::Stats NetworkDemuxer::stats() const
+{
+    Stats st;
+    st.rebuffers = m_rebuffers.load();
+    st.reconnects = m_reconnects.load();
+    QMutexLocker locker(&m_mutex);
+    st.bufferedSec = levelLocked();
+    st.bufferedBytes = m_bytes;
+    return st;
+}
+
+void NetworkDemuxer::clearLocked()
+{
+    for (Entry &e : m_queue) av_packet_free(&e.packet);
+    m_queue.clear();
+    m_refTimes.clear();
+    if (m_budget) m_budget->release(MemoryBudget::NetPackets, m_bytes);
+    m_bytes = 0;
+    m_spaceCond.wakeAll();
+}
+
+double NetworkDemuxer::levelLocked() const
+{
+    if (m_refTimes.size() < 2) return 0.0;
+    return m_refTimes.back() - m_refTimes.front();
+}
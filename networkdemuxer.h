@@ -0,0 +1,135 @@
+#ifndef NETWORKDEMUXER_H
+#define NETWORKDEMUXER_H
+
+#include <QMutex>
+#include <QString>
+#include <QThread>
+#include <QWaitCondition>
+#include <atomic>
+#include <deque>
+#include <vector>
+
+extern "C" {
+#include <libavformat/avformat.h>
+}
+
+class MemoryBudget;
+
+/**
+ * @brief 网络流（HTTP/HLS 等）的解复用线程与压缩包缓冲
+ *
+ * 独立线程执行 av_read_frame 并把包放入队列，解码线程只从队列取包，网络抖动不再直接卡住解码。
+ * 缓冲量按参考流（视频；纯音频播放时为音轨）在队列中首尾包的时间差计算，read() 带水位状态机：
+ * 低于 LOW_WATERMARK_SEC 进入缓冲状态，不再出包，直到达到 HIGH_WATERMARK_SEC
+ * （起播和 seek 之后只需 START_WATERMARK_SEC）、读到流尾或内存配额用尽。
+ * 读取出错时按退避间隔重连：可 seek 的流回到最后读到的位置并丢弃重复的包，直播流直接重试。
+ *
+ * fmt 的读取、seek 和流的 discard 设置都在本线程执行：解码线程通过 seek() 提交请求并等待完成，
+ * setStreamDiscard()/setReferenceStream() 只登记请求，在下一次 av_read_frame 之前生效；
+ * 中断回调应同时检查 interruptRequested()，让阻塞中的读取尽快让位给 seek。
+ */
+class NetworkDemuxer
+{
+public:
+    struct Stats {
+        double bufferedSec = 0.0;
+        qint64 bufferedBytes = 0;
+        qint64 rebuffers = 0;       // 播放中途低于低水位的次数
+        qint64 reconnects = 0;
+    };
+
+    static constexpr double LOW_WATERMARK_SEC = 0.5;
+    static constexpr double START_WATERMARK_SEC = 1.0;
+    static constexpr double HIGH_WATERMARK_SEC = 3.0;
+    static constexpr double MAX_BUFFER_SEC = 30.0;      // 超过后读取线程暂停
+
+    // stopFlag 为所属会话的停止标志，置位后读取线程退出
+    NetworkDemuxer(AVFormatContext *fmt, int refStream, const std::atomic<bool> &stopFlag);
+    ~NetworkDemuxer();                      // 调用前 stopFlag 必须已置位
+    NetworkDemuxer(const NetworkDemuxer &) = delete;
+    NetworkDemuxer &operator=(const NetworkDemuxer &) = delete;
+
+    void start(MemoryBudget *budget);
+
+    // 0：取到包；AVERROR(EAGAIN)：缓冲中（honorWatermarks 为 false 时只在队列为空时返回）；
+    // AVERROR_EOF 或重连失败的错误码：流已结束
+    int read(AVPacket *out, bool honorWatermarks = true);
+    void waitForData(int timeoutMs);
+    int seek(int streamIndex, int64_t ts, int flags);   // 阻塞到读取线程执行完，返回 av_seek_frame 的结果
+    void setStreamDiscard(const std::vector<AVDiscard> &discard);     // 每个流的 AVStream::discard
+    void setReferenceStream(int streamIndex);           // 计算缓冲量的流，队列中已有的包按新的流重新计算
+    bool interruptRequested() const { return m_abortRead.load(); }
+
+    bool isBuffering() const;
+    int bufferingPercent() const;           // 缓冲状态下距离恢复水位的进度
+    Stats stats() const;
+
+    static bool isNetworkUrl(const QString &path);
+    static AVDictionary *openOptions();     // avformat_open_input 的 http 自动重连与超时选项
+
+private:
+    struct Entry {
+        AVPacket *packet;
+        double sec;                         // 参考流包的（去除时间戳跳变后的）时间，其它包为 -1
+    };
+
+    void run();
+    void push(AVPacket *pkt);
+    bool isDuplicate(const AVPacket *pkt);
+    bool looksTruncated() const;
+    void reconnect(int error, int attempt);
+    bool sleepInterruptible(int ms);        // 停止或有 seek 请求时提前返回 false
+    double refTime(const AVPacket *pkt);    // 参考流包去除时间戳跳变后的时间，其它包为 -1
+    void applyStreamConfigLocked();
+    void clearLocked();
+    double levelLocked() const;
+
+    static constexpr int MAX_RECONNECTS = 6;
+
+    AVFormatContext *m_fmt;
+    int m_refStream;                        // 只在读取线程修改，修改时持锁
+    const std::atomic<bool> &m_stopFlag;
+    MemoryBudget *m_budget = nullptr;
+    QThread *m_thread = nullptr;
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_dataCond;              // 入队、流结束、seek 完成
+    QWaitCondition m_spaceCond;             // 出队、seek 请求
+    std::deque<Entry> m_queue;
+    std::deque<double> m_refTimes;          // 队列中参考流包的时间
+    qint64 m_bytes = 0;
+    bool m_buffering = true;
+    double m_resumeSec = START_WATERMARK_SEC;
+    bool m_eof = false;
+    int m_error = 0;
+
+    // seek 请求，由读取线程执行
+    bool m_seekPending = false;
+    int m_seekStream = -1;
+    int64_t m_seekTs = 0;
+    int m_seekFlags = 0;
+    int m_seekResult = 0;
+    quint64 m_seekRequested = 0;
+    quint64 m_seekCompleted = 0;
+    std::atomic<bool> m_abortRead{false};
+
+    // 流配置请求，由读取线程在两次读取之间执行
+    bool m_discardPending = false;
+    std::vector<AVDiscard> m_discardRequest;
+    bool m_refPending = false;
+    int m_refRequest = -1;
+
+    // 以下只在读取线程使用
+    std::vector<int64_t> m_lastDts;         // 每个流最后入队的 dts，包没有文件偏移时据此丢弃重复包
+    std::vector<int64_t> m_lastTs;          // 每个流最后入队的 dts（没有时为 pts），重连时 seek 到参考流的这个位置
+    std::vector<char> m_resyncing;          // 重连后尚未越过断点的流
+    int64_t m_lastPos = -1;                 // 已入队的包在文件中的最大偏移
+    double m_lastRefSec = -1.0;             // 参考流最后一个包的原始时间
+    double m_lastAdjSec = -1.0;
+    double m_timeOffset = 0.0;
+
+    std::atomic<qint64> m_rebuffers{0};
+    std::atomic<qint64> m_reconnects{0};
+};
+
+#endif // NETWORKDEMUXER_H
@@ -5,6 +5,7 @@
 #include <QDebug>
 #include <QStringList>
 #include <QHeaderView>
+#include <QPixmap>
 
 /**
  * @brief PathSel::PathSel
@@ -20,6 +21,7 @@ PathSel::PathSel(QTableWidget* tableWidget, QLabel* pathLabel, QToolButton* butt
     this->button = button;
     this->manager = manager;
     this->Last = Last; this->Next = Next;
+    this->m_thumbs = new ThumbnailGenerator(this);
 
     infoLabel->setTextFormat(Qt::RichText);
     infoLabel->setAlignment(Qt::AlignLeft | Qt::AlignTop);
@@ -33,6 +35,8 @@ PathSel::PathSel(QTableWidget* tableWidget, QLabel* pathLabel, QToolButton* butt
     // 监听 VideoManager 列表更新信号
     if (manager)
         connect(manager, &VideoManager::videosUpdated, this, &PathSel::updateTable);
+    // 缩略图在工作线程生成，排队回到主线程更新表格
+    connect(m_thumbs, &ThumbnailGenerator::thumbnailReady, this, &PathSel::onThumbnailReady, Qt::QueuedConnection);
 
     if(infoLabel)
         connect(this, &PathSel::fileSelected, this,[=]{
@@ -112,39 +116,68 @@ void PathSel::updateTable()
 
     tableWidget->clearContents();
     tableWidget->setRowCount(videos.size());
+    m_rowByPath.clear();
+    QStringList missing;
 
     for (int i = 0; i < videos.size(); ++i) {
         const VideoFile &v = videos.at(i);
+        m_rowByPath.insert(v.fullPath(), i);
+
+        // 缩略图 → 已缓存的直接显示，其余交给后台生成
+        QTableWidgetItem *thumbItem = new QTableWidgetItem();
+        QImage thumb = m_thumbs->cached(v.fullPath());
+        if (!thumb.isNull()) thumbItem->setData(Qt::DecorationRole, QPixmap::fromImage(thumb));
+        else missing << v.fullPath();
+        tableWidget->setItem(i, 0, thumbItem);
 
         // 文件名 → 左对齐
         QTableWidgetItem *nameItem = new QTableWidgetItem(v.fileName());
         nameItem->setTextAlignment(Qt::AlignLeft | Qt::AlignVCenter);
         nameItem->setToolTip(v.fullPath()); // 鼠标悬停显示完整路径
-        tableWidget->setItem(i, 0, nameItem);
+        tableWidget->setItem(i, 1, nameItem);
 
         // 大小 → 居中
         QString sizeStr = QString::number(v.sizeMB(), 'f', 2);
         QTableWidgetItem *sizeItem = new QTableWidgetItem(sizeStr);
         sizeItem->setTextAlignment(Qt::AlignCenter);
         sizeItem->setToolTip(sizeStr); // 悬停也显示完整数字
-        tableWidget->setItem(i, 1, sizeItem);
+        tableWidget->setItem(i, 2, sizeItem);
 
         // 时长 → 居中
         QString durStr = v.durationStr();
         QTableWidgetItem *durationItem = new QTableWidgetItem(durStr);
         durationItem->setTextAlignment(Qt::AlignCenter);
         durationItem->setToolTip(durStr); // 悬停显示完整时长
-        tableWidget->setItem(i, 2, durationItem);
+        tableWidget->setItem(i, 3, durationItem);
     }
+    m_thumbs->request(missing);
+}
+
+/**
+ * @brief 后台生成的缩略图到达，按路径找到对应行显示
+ */
+void PathSel::onThumbnailReady(const QString& path, const QImage& image)
+{
+    auto it = m_rowByPath.constFind(path);
+    if (it == m_rowByPath.constEnd()) return;   // 列表已切换
+    QTableWidgetItem *item = tableWidget->item(it.value(), 0);
+    if (item) item->setData(Qt::DecorationRole, QPixmap::fromImage(image));
 }
 
 void PathSel::initTable()
 {
     // 设置列头
-    tableWidget->setColumnCount(3);
-    QStringList headers = { "文件名", "大小 (MB)", "时长" };
+    tableWidget->setColumnCount(4);
+    QStringList headers = { "预览", "文件名", "大小 (MB)", "时长" };
     tableWidget->setHorizontalHeaderLabels(headers);
 
+    // 缩略图列：按半尺寸显示，行高随之增加
+    const QSize iconSize(ThumbnailGenerator::THUMB_WIDTH / 2, ThumbnailGenerator::THUMB_HEIGHT / 2);
+    tableWidget->setIconSize(iconSize);
+    tableWidget->verticalHeader()->setDefaultSectionSize(iconSize.height() + 4);
+    tableWidget->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Fixed);
+    tableWidget->setColumnWidth(0, iconSize.width() + 8);
+
     // 禁止 Qt 默认的单击选中效果
     tableWidget->setSelectionMode(QAbstractItemView::NoSelection);
     tableWidget->setSelectionBehavior(QAbstractItemView::SelectRows);
@@ -223,13 +256,32 @@ void PathSel::onRowDoubleClicked(int row, int column)
     // 更新记录的选中行
     manager->selected = row;
     // 发射信号
-    QString fileName    = tableWidget->item(row, 0)->text();
-    double sizeMB       = tableWidget->item(row, 1)->text().toDouble();
-    QString durationStr = tableWidget->item(row, 2)->text();
+    QString fileName    = tableWidget->item(row, 1)->text();
+    double sizeMB       = tableWidget->item(row, 2)->text().toDouble();
+    QString durationStr = tableWidget->item(row, 3)->text();
 
     emit fileSelected(fileName, sizeMB, durationStr);
 }
 
+/**
+ * @brief 取消选中行的加粗并清除选中记录
+ */
+void PathSel::clearSelection()
+{
+    if (manager->selected >= 0) {
+        for (int c = 0; c < tableWidget->columnCount(); ++c) {
+            QTableWidgetItem* item = tableWidget->item(manager->selected, c);
+            if (item) {
+                QFont font = item->font();
+                font.setBold(false);
+                item->setFont(font);
+            }
+        }
+    }
+    manager->selected = -1;
+    infoLabel->clear();
+}
+
 /**
  * @brief PathSel::getPath
  * @return 返回当前文件夹路径
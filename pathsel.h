@@ -6,8 +6,10 @@
 #include <QToolButton>
 #include <QObject>
 #include <QPushButton>
+#include <QHash>
 
 #include "videomanager.h"
+#include "thumbnailgenerator.h"
 
 class PathSel: public QObject
 {
@@ -24,6 +26,8 @@ private:
     QString m_lastSelectedPath;  // 保存上次选择的路径
 
     VideoManager* manager;
+    ThumbnailGenerator* m_thumbs;        // 缩略图生成与缓存
+    QHash<QString, int> m_rowByPath;     // 完整路径 → 表格行，缩略图异步到达时定位
 
     void setLabelContent();
     QStringList getVideoList();
@@ -38,6 +42,7 @@ private slots:
 
     void onCellEntered(const QModelIndex& index);     // 鼠标 hover
     void onRowDoubleClicked(int row, int column);
+    void onThumbnailReady(const QString& path, const QImage& image);
 
 public:
     PathSel(QTableWidget* tableWidget, QLabel* pathLabel, QToolButton* button, VideoManager* manager,
@@ -45,6 +50,7 @@ public:
     QString getPath();
 
     void initTable();
+    void clearSelection();      // 改为播放列表之外的内容（网络地址）时取消选中行
 };
 
 #endif // PATHSEL_H
@@ -0,0 +1,39 @@
+#include "playercommand.h"
+
+CommandQueue::CommandQueue()
+{
+    Node *stub = new Node;
+    m_head.store(stub);
+    m_tail = stub;
+}
+
+CommandQueue::~CommandQueue()
+{
+    PlayerCommand cmd;
+    while (pop(cmd)) {}
+    delete m_tail;
+}
+
+void CommandQueue::push(const PlayerCommand &cmd)
+{
+    Node *node = new Node;
+    node->cmd = cmd;
+    // 先抢占队尾，再把前驱链接过来；两步之间消费者只会看到队列暂时为空
+    Node *prev = m_head.exchange(node, std::memory_order_acq_rel);
+    prev->next.store(node, std::memory_order_release);
+}
+
+bool CommandQueue::pop(PlayerCommand &out)
+{
+    Node *next = m_tail->next.load(std::memory_order_acquire);
+    if (!next) return false;
+    out = next->cmd;
+    delete m_tail;
+    m_tail = next;
+    return true;
+}
+
+bool CommandQueue::empty() const
+{
+    return m_tail->next.load(std::memory_order_acquire) == nullptr;
+}
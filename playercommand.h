@@ -0,0 +1,75 @@
+#ifndef PLAYERCOMMAND_H
+#define PLAYERCOMMAND_H
+
+#include <QtGlobal>
+#include <QRect>
+#include <atomic>
+#include <memory>
+
+class SubtitleTrack;
+
+/**
+ * @brief 播放控制命令
+ *
+ * 主线程的所有控制操作都封装为命令投递给解码线程，由解码线程在固定的检查点统一执行，
+ * 避免控制状态在两个线程之间同时读写。seq 全局单调递增，解码输出携带最近一次
+ * 生效的 seek 命令的 seq，主线程据此精确丢弃过期的帧和 PCM。
+ */
+struct PlayerCommand
+{
+    enum Type {
+        Play,
+        Pause,
+        Seek,               // value: 目标位置（秒），width 非 0 时精确定位（目标之前的帧不显示）
+        SetRate,            // value: 倍速
+        Resize,             // width/height: 渲染尺寸
+        ScalingAlgorithm,   // width: sws 缩放算法
+        TimeStretchEngine,  // width: 变速音频引擎
+        AudioTrack,         // width: 音轨流序号
+        Subtitle,           // width: 字幕流序号或 SUBTITLE_OFF/SUBTITLE_EXTERNAL，subtitle: 外挂字幕
+        StepFrame,          // width: 1 向前一帧，-1 向后一帧（暂停时）
+        Scrub,              // value: 拖动进度条时的预览位置（秒），只显示最近的关键帧
+        VideoOutput,        // width: 画面输出方式（显示 / 不可见时只解码参考帧 / 纯音频）
+        VideoFilter,        // width: 去隔行方式，height: 非 0 时自动旋转，rect: 裁剪区域
+    };
+
+    Type type = Play;
+    quint64 seq = 0;
+    double value = 0.0;
+    int width = 0;
+    int height = 0;
+    std::shared_ptr<SubtitleTrack> subtitle;
+    QRect rect;
+
+    // seek、逐帧和拖动预览之后旧的输出全部作废；变速不作废，已排队的输出照常播放
+    bool flushesOutput() const { return type == Seek || type == StepFrame || type == Scrub; }
+};
+
+/**
+ * @brief 多生产者单消费者的无锁命令队列（Vyukov 链表队列）
+ *
+ * push 可在任意线程调用，pop/empty 只能在唯一的消费者线程调用。
+ */
+class CommandQueue
+{
+public:
+    CommandQueue();
+    ~CommandQueue();
+    CommandQueue(const CommandQueue &) = delete;
+    CommandQueue &operator=(const CommandQueue &) = delete;
+
+    void push(const PlayerCommand &cmd);
+    bool pop(PlayerCommand &out);
+    bool empty() const;
+
+private:
+    struct Node {
+        std::atomic<Node*> next{nullptr};
+        PlayerCommand cmd;
+    };
+
+    std::atomic<Node*> m_head;  // 生产者在此追加
+    Node *m_tail;               // 消费者持有的哨兵节点
+};
+
+#endif // PLAYERCOMMAND_H
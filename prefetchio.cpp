@@ -0,0 +1,235 @@
+#include "prefetchio.h"
+#include <QDeadlineTimer>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include <QStorageInfo>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+extern "C" {
+#include <libavutil/error.h>
+#include <libavutil/mem.h>
+}
+
+namespace {
+constexpr int WAIT_SLICE_MS = 20;       // 等待数据时检查中断回调的间隔
+
+// PLAYER_IO_THROTTLE="KB/s[,延迟ms]"：限速读取，模拟慢盘/网络盘
+void parseThrottle(qint64 &bytesPerSec, int &latencyMs)
+{
+    const QStringList parts = qEnvironmentVariable("PLAYER_IO_THROTTLE").split(',', Qt::SkipEmptyParts);
+    bytesPerSec = parts.size() > 0 ? parts[0].trimmed().toLongLong() * 1024 : 0;
+    latencyMs = parts.size() > 1 ? parts[1].trimmed().toInt() : 0;
+}
+}
+
+PrefetchIO::~PrefetchIO()
+{
+    if (m_reader) {
+        {
+            QMutexLocker locker(&m_mutex);
+            m_stop = true;
+        }
+        m_spaceCond.wakeAll();
+        m_dataCond.wakeAll();
+        m_reader->wait();
+        delete m_reader;
+    }
+    if (m_ctx) {
+        av_freep(&m_ctx->buffer);
+        avio_context_free(&m_ctx);
+    }
+}
+
+bool PrefetchIO::isNetworkPath(const QString &path)
+{
+    if (path.startsWith("//") || path.startsWith("\\\\")) return true;
+    const QByteArray fs = QStorageInfo(path).fileSystemType().toLower();
+    return fs.startsWith("cifs") || fs.startsWith("smb") || fs.startsWith("nfs")
+        || fs == "fuse.sshfs" || fs == "9p";
+}
+
+bool PrefetchIO::throttled()
+{
+    return !qEnvironmentVariableIsEmpty("PLAYER_IO_THROTTLE");
+}
+
+bool PrefetchIO::open(const QString &path, int windowMB, const AVIOInterruptCB &interrupt)
+{
+    m_file.setFileName(path);
+    // 预读线程自己按大块读取，不需要 QFile 再缓冲一层
+    if (!m_file.open(QIODevice::ReadOnly | QIODevice::Unbuffered)) return false;
+    m_size = m_file.size();
+    if (m_size <= 0) return false;
+
+    m_window = qint64(std::clamp(windowMB, 8, 64)) * 1024 * 1024;
+    m_window = std::min(m_window, std::max(m_size, CHUNK));
+    m_backKeep = m_window / 8;
+    m_ring.resize(size_t(m_window));
+    m_interrupt = interrupt;
+    parseThrottle(m_throttleBytesPerSec, m_throttleLatencyMs);
+
+    auto *buffer = static_cast<unsigned char*>(av_malloc(AVIO_BUFFER_SIZE));
+    if (!buffer) return false;
+    m_ctx = avio_alloc_context(buffer, AVIO_BUFFER_SIZE, 0, this, &PrefetchIO::readPacket, nullptr, &PrefetchIO::seek);
+    if (!m_ctx) {
+        av_free(buffer);
+        return false;
+    }
+
+    m_reader = QThread::create([this]() { readerLoop(); });
+    m_reader->start(QThread::HighPriority);
+    return true;
+}
+
+PrefetchIO::Stats PrefetchIO::stats() const
+{
+    Stats st;
+    st.stalls = m_stalls.load();
+    st.stallUs = m_stallUs.load();
+    st.diskReads = m_diskReads.load();
+    st.diskBytes = m_diskBytes.load();
+    st.retargets = m_retargets.load();
+    QMutexLocker locker(&m_mutex);
+    st.buffered = std::max<qint64>(0, m_end - m_pos);
+    return st;
+}
+
+/**
+ * @brief 预读线程：读取位置前方不足一个窗口时从 m_end 继续读下一块。
+ * 读取本身不持锁，写入的是缓冲中尚未生效的区域；读完后若窗口已被重定位则丢弃
+ */
+void PrefetchIO::readerLoop()
+{
+    QMutexLocker locker(&m_mutex);
+    while (!m_stop) {
+        // 读取位置之前只保留 m_backKeep，其余空间让给前方的数据
+        qint64 reclaimTo = std::min(m_pos - m_backKeep, m_end);
+        if (reclaimTo > m_begin) m_begin = reclaimTo;
+
+        qint64 free = m_window - (m_end - m_begin);
+        if (m_readError || m_end >= m_size || free <= 0) {
+            m_spaceCond.wait(&m_mutex);
+            continue;
+        }
+
+        const qint64 offset = m_end;
+        const qint64 ringPos = offset % m_window;
+        const qint64 n = std::min({CHUNK, free, m_window - ringPos, m_size - offset});
+        const quint64 generation = m_generation;
+        locker.unlock();
+
+        qint64 got = -1;
+        if (m_file.seek(offset)) got = m_file.read(reinterpret_cast<char*>(m_ring.data() + ringPos), n);
+        ++m_diskReads;
+        if (got > 0) m_diskBytes += got;
+        throttle(std::max<qint64>(got, 0));
+
+        locker.relock();
+        if (generation != m_generation) continue;
+        if (got <= 0) {
+            qWarning() << "PrefetchIO: read failed at" << offset << m_file.errorString();
+            m_readError = true;
+        } else {
+            m_end += got;
+        }
+        m_dataCond.wakeAll();
+    }
+}
+
+void PrefetchIO::throttle(qint64 bytes)
+{
+    if (m_throttleBytesPerSec <= 0 && m_throttleLatencyMs <= 0) return;
+    qint64 ms = m_throttleLatencyMs;
+    if (m_throttleBytesPerSec > 0) ms += bytes * 1000 / m_throttleBytesPerSec;
+
+    // 析构时可以打断
+    QDeadlineTimer deadline(ms);
+    QMutexLocker locker(&m_mutex);
+    while (!m_stop && !deadline.hasExpired()) m_spaceCond.wait(&m_mutex, deadline);
+}
+
+int PrefetchIO::read(uint8_t *buf, int size)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_pos >= m_size) return AVERROR_EOF;
+
+    if (m_pos >= m_end) {
+        // 预读没跟上：这就是原来卡在 av_read_frame 里的时间
+        ++m_stalls;
+        QElapsedTimer waited;
+        waited.start();
+        m_spaceCond.wakeAll();
+        int ret = 0;
+        while (m_pos >= m_end && !m_readError && !m_stop) {
+            m_dataCond.wait(&m_mutex, WAIT_SLICE_MS);
+            if (m_interrupt.callback && m_interrupt.callback(m_interrupt.opaque)) {
+                ret = AVERROR_EXIT;
+                break;
+            }
+        }
+        m_stallUs += waited.nsecsElapsed() / 1000;
+        if (ret == 0 && m_pos >= m_end) ret = m_readError ? AVERROR(EIO) : AVERROR_EXIT;
+        if (ret != 0) return ret;
+    }
+
+    // [m_pos, m_end) 只有本线程会使其失效（seek），拷贝时无需持锁
+    const qint64 offset = m_pos;
+    const qint64 n = std::min({qint64(size), m_end - offset, m_backKeep});
+    locker.unlock();
+
+    const qint64 ringPos = offset % m_window;
+    const qint64 first = std::min(n, m_window - ringPos);
+    std::memcpy(buf, m_ring.data() + ringPos, size_t(first));
+    if (n > first) std::memcpy(buf + first, m_ring.data(), size_t(n - first));
+
+    locker.relock();
+    m_pos = offset + n;
+    m_spaceCond.wakeAll();
+    return int(n);
+}
+
+/**
+ * @brief 目标在缓冲内或刚好在前方一块之内时只移动读取位置；否则清空缓冲，预读线程从目标处重新开始
+ */
+int64_t PrefetchIO::seekTo(int64_t target)
+{
+    QMutexLocker locker(&m_mutex);
+    m_pos = target;
+    if (target < m_begin || target > m_end + CHUNK) {
+        m_begin = m_end = std::min<qint64>(target, m_size);
+        m_readError = false;
+        ++m_generation;
+        ++m_retargets;
+    }
+    m_spaceCond.wakeAll();
+    return target;
+}
+
+int PrefetchIO::readPacket(void *opaque, uint8_t *buf, int size)
+{
+    return static_cast<PrefetchIO*>(opaque)->read(buf, size);
+}
+
+int64_t PrefetchIO::seek(void *opaque, int64_t offset, int whence)
+{
+    auto *io = static_cast<PrefetchIO*>(opaque);
+    whence &= ~AVSEEK_FORCE;
+    if (whence == AVSEEK_SIZE) return io->m_size;
+
+    qint64 target;
+    switch (whence) {
+    case SEEK_SET: target = offset; break;
+    case SEEK_CUR: {
+        QMutexLocker locker(&io->m_mutex);
+        target = io->m_pos + offset;
+        break;
+    }
+    case SEEK_END: target = io->m_size + offset; break;
+    default: return AVERROR(EINVAL);
+    }
+    if (target < 0) return AVERROR(EINVAL);
+    return io->seekTo(target);
+}
@@ -0,0 +1,94 @@
+#ifndef PREFETCHIO_H
+#define PREFETCHIO_H
+
+#include <QFile>
+#include <QMutex>
+#include <QString>
+#include <QThread>
+#include <QWaitCondition>
+#include <atomic>
+#include <vector>
+
+extern "C" {
+#include <libavformat/avio.h>
+}
+
+/**
+ * @brief 带独立预读线程的 AVIOContext，面向机械硬盘和 SMB/NFS 等网络挂载
+ *
+ * 预读线程以大块顺序读取把读取位置之后的一段文件（窗口，可配置 8~64 MB）保存在环形缓冲中，
+ * 解码线程的 av_read_frame 只从内存取数据，不再被单次慢 I/O 卡住。
+ * 读取位置之前保留窗口的 1/8 供 FFmpeg 小幅回退；跳出缓冲范围的 seek 会把窗口重新定位到目标处。
+ * 缓冲追不上读取时记为一次停顿，累计停顿时间作为 I/O 健康度指标。
+ *
+ * 环境变量 PLAYER_IO_THROTTLE="KB/s[,延迟ms]" 会限制预读线程的读取速度，
+ * 可以用本地文件模拟慢盘/网络盘。
+ */
+class PrefetchIO
+{
+public:
+    struct Stats {
+        qint64 stalls = 0;          // 解码线程等待数据的次数
+        qint64 stallUs = 0;         // 累计等待时间
+        qint64 diskReads = 0;       // 预读线程的 read 次数
+        qint64 diskBytes = 0;
+        qint64 retargets = 0;       // seek 出缓冲范围、窗口重新定位的次数
+        qint64 buffered = 0;        // 读取位置之后已缓冲的字节数
+    };
+
+    PrefetchIO() = default;
+    ~PrefetchIO();
+    PrefetchIO(const PrefetchIO &) = delete;
+    PrefetchIO &operator=(const PrefetchIO &) = delete;
+
+    // interrupt 为 FFmpeg 的中断回调，等待数据期间周期性检查
+    bool open(const QString &path, int windowMB, const AVIOInterruptCB &interrupt);
+    AVIOContext *context() const { return m_ctx; }
+    Stats stats() const;
+
+    static bool isNetworkPath(const QString &path);  // UNC 路径或 SMB/NFS 等网络文件系统
+    static bool throttled();                         // 设置了 PLAYER_IO_THROTTLE，本地文件也走预读
+
+private:
+    static int readPacket(void *opaque, uint8_t *buf, int size);
+    static int64_t seek(void *opaque, int64_t offset, int whence);
+
+    int read(uint8_t *buf, int size);
+    int64_t seekTo(int64_t target);
+    void readerLoop();
+    void throttle(qint64 bytes);
+
+    static constexpr qint64 CHUNK = 1024 * 1024;            // 预读线程单次读取
+    static constexpr int AVIO_BUFFER_SIZE = 64 * 1024;
+
+    QFile m_file;                           // 只在预读线程中读取
+    qint64 m_size = 0;
+    std::vector<uint8_t> m_ring;
+    qint64 m_window = 0;                    // 环形缓冲容量
+    qint64 m_backKeep = 0;                  // 读取位置之前保留的字节数
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_dataCond;              // 有新数据 / 出错 / 停止
+    QWaitCondition m_spaceCond;             // 读取位置前进或窗口重定位
+    qint64 m_begin = 0;                     // 缓冲中的文件范围 [m_begin, m_end)
+    qint64 m_end = 0;
+    qint64 m_pos = 0;                       // 解码线程的读取位置
+    quint64 m_generation = 0;               // 每次重定位递增，预读线程据此丢弃过期的读取
+    bool m_readError = false;
+    bool m_stop = false;
+    QThread *m_reader = nullptr;
+
+    AVIOInterruptCB m_interrupt{nullptr, nullptr};
+    AVIOContext *m_ctx = nullptr;
+
+    qint64 m_throttleBytesPerSec = 0;
+    int m_throttleLatencyMs = 0;
+
+    std::atomic<qint64> m_stalls{0};
+    std::atomic<qint64> m_stallUs{0};
+    std::atomic<qint64> m_diskReads{0};
+    std::atomic<qint64> m_diskBytes{0};
+    std::atomic<qint64> m_retargets{0};
+};
+
+#endif // PREFETCHIO_H
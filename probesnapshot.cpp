@@ -0,0 +1,111 @@
+#include "probesnapshot.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QFileInfo>
+#include <QMutexLocker>
+
+QMutex ProbeSnapshot::s_mutex;
+QHash<QString, std::shared_ptr<const ProbeSnapshot>> ProbeSnapshot::s_registry;
+
+ProbeSnapshot::~ProbeSnapshot()
+{
+    for (Stream &st : m_streams) avcodec_parameters_free(&st.par);
+}
+
+/**
+ * @brief 在 avformat_find_stream_info 之后调用，复制探测结果
+ */
+std::shared_ptr<const ProbeSnapshot> ProbeSnapshot::capture(const AVFormatContext *fmt, const QString &path)
+{
+    // 流可能在读包过程中才出现的容器（如 MPEG-TS）没有可靠的头部，不做快照
+    if (!fmt || !fmt->iformat || (fmt->ctx_flags & AVFMTCTX_NOHEADER)) return nullptr;
+
+    QFileInfo info(path);
+    if (!info.exists()) return nullptr;
+
+    auto snap = std::make_shared<ProbeSnapshot>();
+    snap->m_formatName = QString::fromLatin1(fmt->iformat->name);
+    snap->m_fileSize = info.size();
+    snap->m_mtimeMs = info.lastModified().toMSecsSinceEpoch();
+    snap->m_startTime = fmt->start_time;
+    snap->m_duration = fmt->duration;
+    snap->m_bitRate = fmt->bit_rate;
+
+    snap->m_streams.resize(fmt->nb_streams);
+    for (unsigned i = 0; i < fmt->nb_streams; ++i) {
+        const AVStream *src = fmt->streams[i];
+        Stream &dst = snap->m_streams[i];
+        dst.par = avcodec_parameters_alloc();
+        if (!dst.par || avcodec_parameters_copy(dst.par, src->codecpar) < 0) return nullptr;
+        dst.timeBase = src->time_base;
+        dst.avgFrameRate = src->avg_frame_rate;
+        dst.rFrameRate = src->r_frame_rate;
+        dst.startTime = src->start_time;
+        dst.duration = src->duration;
+    }
+    return snap;
+}
+
+/**
+ * @brief 校验刚打开的上下文与快照的流布局一致，一致时写回探测结果
+ */
+bool ProbeSnapshot::applyTo(AVFormatContext *fmt) const
+{
+    if (!fmt || !fmt->iformat || (fmt->ctx_flags & AVFMTCTX_NOHEADER)) return false;
+    if (m_formatName != QString::fromLatin1(fmt->iformat->name)) return false;
+    if (fmt->nb_streams != m_streams.size()) return false;
+
+    // 先全部校验再修改，失败时上下文保持原样，可以直接继续完整探测
+    for (unsigned i = 0; i < fmt->nb_streams; ++i) {
+        const AVStream *st = fmt->streams[i];
+        const Stream &snap = m_streams[i];
+        if (st->codecpar->codec_type != snap.par->codec_type) return false;
+        if (st->codecpar->codec_id != AV_CODEC_ID_NONE && st->codecpar->codec_id != snap.par->codec_id) return false;
+        if (av_cmp_q(st->time_base, snap.timeBase) != 0) return false;
+    }
+
+    for (unsigned i = 0; i < fmt->nb_streams; ++i) {
+        AVStream *st = fmt->streams[i];
+        const Stream &snap = m_streams[i];
+        if (avcodec_parameters_copy(st->codecpar, snap.par) < 0) return false;
+        if (st->avg_frame_rate.num == 0) st->avg_frame_rate = snap.avgFrameRate;
+        if (st->r_frame_rate.num == 0) st->r_frame_rate = snap.rFrameRate;
+        if (st->start_time == AV_NOPTS_VALUE) st->start_time = snap.startTime;
+        if (st->duration == AV_NOPTS_VALUE) st->duration = snap.duration;
+    }
+    if (fmt->start_time == AV_NOPTS_VALUE) fmt->start_time = m_startTime;
+    if (fmt->duration == AV_NOPTS_VALUE) fmt->duration = m_duration;
+    if (fmt->bit_rate <= 0) fmt->bit_rate = m_bitRate;
+    return true;
+}
+
+void ProbeSnapshot::remember(const QString &path, std::shared_ptr<const ProbeSnapshot> snapshot)
+{
+    if (!snapshot) return;
+    QMutexLocker locker(&s_mutex);
+    s_registry.insert(path, std::move(snapshot));
+}
+
+std::shared_ptr<const ProbeSnapshot> ProbeSnapshot::lookup(const QString &path)
+{
+    std::shared_ptr<const ProbeSnapshot> snap;
+    {
+        QMutexLocker locker(&s_mutex);
+        snap = s_registry.value(path);
+    }
+    if (!snap) return nullptr;
+
+    QFileInfo info(path);
+    if (info.size() != snap->m_fileSize || info.lastModified().toMSecsSinceEpoch() != snap->m_mtimeMs) {
+        qDebug() << "Probe snapshot stale:" << path;
+        forget(path);
+        return nullptr;
+    }
+    return snap;
+}
+
+void ProbeSnapshot::forget(const QString &path)
+{
+    QMutexLocker locker(&s_mutex);
+    s_registry.remove(path);
+}
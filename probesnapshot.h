@@ -0,0 +1,57 @@
+#ifndef PROBESNAPSHOT_H
+#define PROBESNAPSHOT_H
+
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <memory>
+#include <vector>
+
+extern "C" {
+#include <libavformat/avformat.h>
+}
+
+/**
+ * @brief avformat_find_stream_info 的结果快照
+ *
+ * 列表加载时 VideoFile 已经完整探测过一次，这里保存各流的编解码参数（含 extradata）、
+ * 时间基、帧率与时长，以（路径，大小，修改时间）为键登记。播放器打开同一文件时
+ * 只执行 avformat_open_input，校验流布局一致后把快照写回各流，跳过第二次探测。
+ * 文件已变化、容器允许流动态出现或布局对不上时返回 false，由调用方完整探测。
+ */
+class ProbeSnapshot
+{
+public:
+    ~ProbeSnapshot();
+
+    static std::shared_ptr<const ProbeSnapshot> capture(const AVFormatContext *fmt, const QString &path);
+    bool applyTo(AVFormatContext *fmt) const;   // 只在刚 open、尚未读包的上下文上调用
+
+    // 进程内登记表（线程安全）：查询时会重新检查文件大小与修改时间
+    static void remember(const QString &path, std::shared_ptr<const ProbeSnapshot> snapshot);
+    static std::shared_ptr<const ProbeSnapshot> lookup(const QString &path);
+    static void forget(const QString &path);
+
+private:
+    struct Stream {
+        AVCodecParameters *par = nullptr;
+        AVRational timeBase{0, 1};
+        AVRational avgFrameRate{0, 1};
+        AVRational rFrameRate{0, 1};
+        int64_t startTime = AV_NOPTS_VALUE;
+        int64_t duration = AV_NOPTS_VALUE;
+    };
+
+    QString m_formatName;
+    qint64 m_fileSize = -1;
+    qint64 m_mtimeMs = 0;
+    int64_t m_startTime = AV_NOPTS_VALUE;
+    int64_t m_duration = AV_NOPTS_VALUE;
+    int64_t m_bitRate = 0;
+    std::vector<Stream> m_streams;
+
+    static QMutex s_mutex;
+    static QHash<QString, std::shared_ptr<const ProbeSnapshot>> s_registry;
+};
+
+#endif // PROBESNAPSHOT_H
@@ -0,0 +1,117 @@
+#include "rewindcache.h"
+#include "memorybudget.h"
+#include <QBuffer>
+#include <QMutexLocker>
+#include <QThread>
+#include <algorithm>
+
+RewindCache::RewindCache(MemoryBudget *budget)
+    : m_budget(budget)
+{
+    // 单线程保证压缩结果按提交顺序入队
+    m_encoder.setMaxThreadCount(1);
+}
+
+RewindCache::~RewindCache()
+{
+    m_encoder.clear();
+    m_encoder.waitForDone();
+    clear();
+}
+
+void RewindCache::setWindow(double seconds)
+{
+    QMutexLocker locker(&m_mutex);
+    m_window = std::max(0.0, seconds);
+    trimLocked();
+}
+
+void RewindCache::add(const QImage &image, double pts)
+{
+    if (image.isNull() || pts < 0.0) return;
+    quint64 epoch;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_window <= 0.0) return;
+        // 抽样到 MAX_FPS；快退后重新播放已缓存的区间时也在这里跳过
+        if (m_lastQueuedPts >= 0.0 && pts < m_lastQueuedPts + 1.0 / MAX_FPS - 1e-3) return;
+        if (m_pending.load() >= MAX_PENDING) return;
+        m_lastQueuedPts = pts;
+        epoch = m_epoch;
+    }
+
+    ++m_pending;
+    // QImage 隐式共享：解码线程和界面都只读，这里不发生拷贝
+    m_encoder.start([this, image, pts, epoch]() {
+        QThread::currentThread()->setPriority(QThread::LowPriority);
+        QByteArray jpeg;
+        QBuffer buffer(&jpeg);
+        buffer.open(QIODevice::WriteOnly);
+        if (image.save(&buffer, "JPG", JPEG_QUALITY)) insert(pts, jpeg, epoch);
+        --m_pending;
+    });
+}
+
+void RewindCache::insert(double pts, const QByteArray &jpeg, quint64 epoch)
+{
+    QMutexLocker locker(&m_mutex);
+    if (epoch != m_epoch) return;
+    if (!m_entries.empty() && pts <= m_entries.back().pts) return;
+    m_entries.push_back({pts, jpeg});
+    m_bytes += jpeg.size();
+    if (m_budget) m_budget->acquire(MemoryBudget::RewindFrames, jpeg.size());
+    trimLocked();
+}
+
+void RewindCache::trimLocked()
+{
+    auto overBudget = [this]() { return m_budget && !m_budget->hasRoom(MemoryBudget::RewindFrames); };
+    while (!m_entries.empty()
+           && (m_window <= 0.0 || m_entries.back().pts - m_entries.front().pts > m_window
+               || (overBudget() && m_entries.size() > 1))) {
+        qint64 size = m_entries.front().jpeg.size();
+        m_entries.pop_front();
+        m_bytes -= size;
+        if (m_budget) m_budget->release(MemoryBudget::RewindFrames, size);
+    }
+}
+
+void RewindCache::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    ++m_epoch;
+    m_entries.clear();
+    if (m_budget) m_budget->release(MemoryBudget::RewindFrames, m_bytes);
+    m_bytes = 0;
+    m_lastQueuedPts = -1.0;
+}
+
+bool RewindCache::covers(double pts) const
+{
+    QMutexLocker locker(&m_mutex);
+    return !m_entries.empty() && pts >= m_entries.front().pts && pts <= m_entries.back().pts;
+}
+
+double RewindCache::nextPts(double after) const
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = std::upper_bound(m_entries.begin(), m_entries.end(), after,
+                               [](double t, const Entry &e) { return t < e.pts; });
+    return it != m_entries.end() ? it->pts : -1.0;
+}
+
+bool RewindCache::frameAt(double pts, Frame &out) const
+{
+    QByteArray jpeg;
+    {
+        QMutexLocker locker(&m_mutex);
+        auto it = std::upper_bound(m_entries.begin(), m_entries.end(), pts,
+                                   [](double t, const Entry &e) { return t < e.pts; });
+        if (it == m_entries.begin()) return false;
+        --it;
+        out.pts = it->pts;
+        jpeg = it->jpeg;    // 隐式共享，解压在锁外进行
+    }
+    out.image = QImage::fromData(jpeg, "JPG").convertToFormat(QImage::Format_RGB888);
+    return !out.image.isNull();
+}
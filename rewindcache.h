@@ -0,0 +1,69 @@
+#ifndef REWINDCACHE_H
+#define REWINDCACHE_H
+
+#include <QByteArray>
+#include <QImage>
+#include <QMutex>
+#include <QThreadPool>
+#include <atomic>
+#include <deque>
+
+class MemoryBudget;
+
+/**
+ * @brief 最近显示过的画面的滚动缓存，用于短距离快退
+ *
+ * 解码线程把显示尺寸的帧交给 add()，按 MAX_FPS 抽样后在单独的压缩线程中编码为 JPEG，
+ * 只保留最近 window 秒，占用计入 MemoryBudget::RewindFrames，超出配额时从最旧的帧开始淘汰。
+ * 快退目标落在缓存范围内时，播放器先按时间顺序放出缓存帧，解码器在后台从关键帧追上来。
+ * 缓存的帧在时间上必须连续：跳出范围的 seek、渲染尺寸变化、快进模式都应 clear()。线程安全。
+ */
+class RewindCache
+{
+public:
+    struct Frame {
+        double pts = -1.0;
+        QImage image;
+    };
+
+    static constexpr double DEFAULT_WINDOW_SEC = 6.0;
+    static constexpr int MAX_FPS = 15;              // 缓存的帧率上限
+    static constexpr int JPEG_QUALITY = 80;
+
+    explicit RewindCache(MemoryBudget *budget);
+    ~RewindCache();
+    RewindCache(const RewindCache &) = delete;
+    RewindCache &operator=(const RewindCache &) = delete;
+
+    void setWindow(double seconds);                 // 0 关闭
+    void add(const QImage &image, double pts);      // 按显示顺序调用
+    void clear();
+
+    bool covers(double pts) const;                  // pts 落在已缓存的时间范围内
+    double nextPts(double after) const;             // 晚于 after 的第一帧，没有时返回 -1
+    bool frameAt(double pts, Frame &out) const;     // 不晚于 pts 的最后一帧，解压后返回
+
+private:
+    struct Entry {
+        double pts;
+        QByteArray jpeg;
+    };
+
+    void insert(double pts, const QByteArray &jpeg, quint64 epoch);
+    void trimLocked();
+
+    static constexpr int MAX_PENDING = 4;           // 压缩线程积压超过该值时跳过新帧
+
+    MemoryBudget *m_budget;
+    QThreadPool m_encoder;
+
+    mutable QMutex m_mutex;
+    std::deque<Entry> m_entries;                    // 按 pts 递增
+    qint64 m_bytes = 0;
+    double m_window = DEFAULT_WINDOW_SEC;
+    double m_lastQueuedPts = -1.0;                  // 最近交给压缩线程的帧，抽样与去重依据
+    quint64 m_epoch = 0;                            // clear() 递增，之前排队的压缩结果作废
+    std::atomic<int> m_pending{0};
+};
+
+#endif // REWINDCACHE_H
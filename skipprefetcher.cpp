@@ -0,0 +1,251 @@
+#include "skipprefetcher.h"
+#include "probesnapshot.h"
+#include <QDebug>
+#include <QMutexLocker>
+#include <cmath>
+
+SkipPrefetcher::~SkipPrefetcher()
+{
+    m_quit.store(true);
+    {
+        QMutexLocker locker(&m_mutex);
+        m_cond.wakeAll();
+    }
+    if (m_thread) {
+        m_thread->wait();
+        delete m_thread;
+    }
+    closeInput();
+    av_frame_free(&m_ready);
+    for (AVFrame *f : m_ahead) av_frame_free(&f);
+}
+
+void SkipPrefetcher::start(const QString &path, int videoStream, AVCodecID codecId)
+{
+    m_path = path;
+    m_stream = videoStream;
+    m_codecId = codecId;
+    m_clock.start();
+    m_thread = QThread::create([this]() { run(); });
+    m_thread->start(QThread::LowestPriority);
+}
+
+void SkipPrefetcher::setTarget(double pts)
+{
+    QMutexLocker locker(&m_mutex);
+    m_target = pts;
+    m_cond.wakeAll();
+}
+
+void SkipPrefetcher::reportLate()
+{
+    qint64 now = m_clock.elapsed();
+    qint64 last = m_lateMs.exchange(now);
+    if (last < 0 || now - last >= BACKOFF_MS) ++m_backoffs;
+}
+
+bool SkipPrefetcher::backingOff() const
+{
+    qint64 last = m_lateMs.load();
+    return last >= 0 && m_clock.elapsed() - last < BACKOFF_MS;
+}
+
+/**
+ * @brief 取走与 target 最接近的已解码帧；无论是否命中，其余帧都作废，等待下一个目标
+ */
+AVFrame *SkipPrefetcher::take(double target)
+{
+    QMutexLocker locker(&m_mutex);
+    AVFrame *best = nullptr;
+    double bestDiff = MATCH_TOLERANCE_SEC;
+    auto consider = [&](AVFrame *&f) {
+        double diff = std::abs(framePts(f) - target);
+        if (diff > bestDiff) return;
+        bestDiff = diff;
+        best = f;
+    };
+    if (m_ready) consider(m_ready);
+    for (AVFrame *&f : m_ahead) consider(f);
+
+    if (best == m_ready) m_ready = nullptr;
+    av_frame_free(&m_ready);
+    for (AVFrame *f : m_ahead) {
+        if (f != best) av_frame_free(&f);
+    }
+    m_ahead.clear();
+    m_readyPts = -1.0;
+    m_target = -1.0;
+
+    if (best) ++m_hits;
+    else ++m_misses;
+    return best;
+}
+
+SkipPrefetcher::Stats SkipPrefetcher::stats() const
+{
+    Stats st;
+    st.hits = m_hits.load();
+    st.misses = m_misses.load();
+    st.reseeks = m_reseeks.load();
+    st.backoffs = m_backoffs.load();
+    return st;
+}
+
+int SkipPrefetcher::interruptCallback(void *opaque)
+{
+    return static_cast<SkipPrefetcher*>(opaque)->m_quit.load() ? 1 : 0;
+}
+
+void SkipPrefetcher::run()
+{
+    if (!openInput()) {
+        qWarning() << "SkipPrefetcher: cannot open" << m_path;
+        closeInput();
+        return;
+    }
+
+    while (!m_quit.load()) {
+        double target;
+        bool reseekNeeded;
+        {
+            QMutexLocker locker(&m_mutex);
+            // 目标前进：已解码的帧依次转为“不晚于目标的最后一帧”
+            while (!m_ahead.empty() && framePts(m_ahead.front()) <= m_target) {
+                av_frame_free(&m_ready);
+                m_ready = m_ahead.front();
+                m_readyPts = framePts(m_ready);
+                m_ahead.pop_front();
+            }
+
+            // 目标跳回已解码位置之前，或超前太多顺序追赶不划算时，重新定位到关键帧
+            double low = m_ready ? m_readyPts
+                       : !m_ahead.empty() ? framePts(m_ahead.front())
+                       : m_posPts >= 0.0 ? m_posPts : m_seekedTo;
+            reseekNeeded = m_target >= 0.0
+                           && (m_seekedTo < 0.0 || m_target < low - MATCH_TOLERANCE_SEC
+                               || m_target - std::max(m_posPts, m_seekedTo) > RESEEK_GAP_SEC);
+            bool idle = m_target < 0.0 || (!reseekNeeded && (!m_ahead.empty() || m_eof));
+            if (idle || backingOff()) {
+                m_cond.wait(&m_mutex, 100);
+                continue;
+            }
+            target = m_target;
+        }
+
+        if (reseekNeeded) reseek(target);
+        else decodeStep();
+    }
+    closeInput();
+}
+
+bool SkipPrefetcher::openInput()
+{
+    m_fmt = avformat_alloc_context();
+    if (!m_fmt) return false;
+    m_fmt->interrupt_callback.callback = &SkipPrefetcher::interruptCallback;
+    m_fmt->interrupt_callback.opaque = this;
+    if (MappedFileIO::isLocalFile(m_path) && m_io.open(m_path)) {
+        m_fmt->pb = m_io.context();
+        m_fmt->flags |= AVFMT_FLAG_CUSTOM_IO;
+    }
+    // 打开失败时 avformat_open_input 会释放并置空 m_fmt
+    if (avformat_open_input(&m_fmt, m_path.toUtf8().constData(), nullptr, nullptr) != 0) return false;
+    std::shared_ptr<const ProbeSnapshot> snapshot = ProbeSnapshot::lookup(m_path);
+    if (!(snapshot && snapshot->applyTo(m_fmt)) && avformat_find_stream_info(m_fmt, nullptr) < 0) return false;
+
+    if (m_stream < 0 || m_stream >= int(m_fmt->nb_streams)) return false;
+    AVStream *st = m_fmt->streams[m_stream];
+    if (st->codecpar->codec_id != m_codecId) return false;
+    for (unsigned i = 0; i < m_fmt->nb_streams; ++i) {
+        m_fmt->streams[i]->discard = int(i) == m_stream ? AVDISCARD_DEFAULT : AVDISCARD_ALL;
+    }
+
+    const AVCodec *codec = avcodec_find_decoder(m_codecId);
+    if (!codec) return false;
+    m_ctx = avcodec_alloc_context3(codec);
+    if (!m_ctx || avcodec_parameters_to_context(m_ctx, st->codecpar) < 0) return false;
+    m_ctx->thread_count = 1;                // 只占一个核心，不与主解码器争抢
+    if (avcodec_open2(m_ctx, codec, nullptr) < 0) return false;
+
+    m_timeBase = av_q2d(st->time_base);
+    m_packet = av_packet_alloc();
+    m_frame = av_frame_alloc();
+    return m_packet && m_frame;
+}
+
+void SkipPrefetcher::closeInput()
+{
+    av_frame_free(&m_frame);
+    av_packet_free(&m_packet);
+    avcodec_free_context(&m_ctx);
+    if (m_fmt) avformat_close_input(&m_fmt);
+}
+
+void SkipPrefetcher::reseek(double target)
+{
+    int64_t ts = static_cast<int64_t>(target / m_timeBase);
+    if (av_seek_frame(m_fmt, m_stream, ts, AVSEEK_FLAG_BACKWARD) < 0) {
+        av_seek_frame(m_fmt, m_stream, ts, AVSEEK_FLAG_ANY);
+    }
+    avcodec_flush_buffers(m_ctx);
+    m_posPts = -1.0;
+    m_seekedTo = target;
+    m_eof = false;
+    ++m_reseeks;
+
+    QMutexLocker locker(&m_mutex);
+    av_frame_free(&m_ready);
+    m_readyPts = -1.0;
+    for (AVFrame *f : m_ahead) av_frame_free(&f);
+    m_ahead.clear();
+}
+
+void SkipPrefetcher::decodeStep()
+{
+    int ret = av_read_frame(m_fmt, m_packet);
+    if (ret == AVERROR_EXIT || ret == AVERROR(EAGAIN)) return;
+    if (ret < 0) {
+        // 文件尾：冲出解码器中剩余的帧，之后等待目标跳回
+        avcodec_send_packet(m_ctx, nullptr);
+        m_eof = true;
+    } else if (m_packet->stream_index != m_stream) {
+        av_packet_unref(m_packet);
+        return;
+    } else {
+        avcodec_send_packet(m_ctx, m_packet);
+        av_packet_unref(m_packet);
+    }
+    while (avcodec_receive_frame(m_ctx, m_frame) == 0) acceptFrame(m_frame);
+}
+
+void SkipPrefetcher::acceptFrame(AVFrame *frame)
+{
+    double pts = framePts(frame);
+    if (pts < 0.0) {
+        av_frame_unref(frame);
+        return;
+    }
+    m_posPts = pts;
+    AVFrame *f = av_frame_alloc();
+    if (!f) {
+        av_frame_unref(frame);
+        return;
+    }
+    av_frame_move_ref(f, frame);
+
+    QMutexLocker locker(&m_mutex);
+    if (m_ahead.empty() && pts <= m_target) {
+        av_frame_free(&m_ready);
+        m_ready = f;
+        m_readyPts = pts;
+    } else {
+        m_ahead.push_back(f);
+    }
+}
+
+double SkipPrefetcher::framePts(const AVFrame *frame) const
+{
+    if (frame->pts != AV_NOPTS_VALUE) return frame->pts * m_timeBase;
+    if (frame->best_effort_timestamp != AV_NOPTS_VALUE) return frame->best_effort_timestamp * m_timeBase;
+    return -1.0;
+}
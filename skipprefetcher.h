@@ -0,0 +1,101 @@
+#ifndef SKIPPREFETCHER_H
+#define SKIPPREFETCHER_H
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QString>
+#include <QThread>
+#include <QWaitCondition>
+#include <atomic>
+#include <deque>
+
+#include "mappedfileio.h"
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+}
+
+/**
+ * @brief 预判快进：后台解码器提前准备“当前位置 + SKIP_SEC”处的画面
+ *
+ * 独立打开同一个文件，只解复用视频流，用单线程解码器从覆盖目标的关键帧解码到目标位置，
+ * 之后随播放位置前进顺序解码，始终持有不晚于目标的最后一帧。
+ * 右方向键快进时解码线程用 take() 取走这一帧立即显示，不必等主解码器从关键帧解码到目标。
+ *
+ * 只使用空闲的 CPU：线程优先级最低、解码器单线程；主解码报告掉帧后暂停 BACKOFF_MS。
+ * setTarget/reportLate/take 由主解码线程调用，线程安全。
+ */
+class SkipPrefetcher
+{
+public:
+    struct Stats {
+        qint64 hits = 0;            // take() 取到准备好的帧
+        qint64 misses = 0;
+        qint64 reseeks = 0;         // 目标跳变后重新定位到关键帧
+        qint64 backoffs = 0;        // 因主解码掉帧而暂停的次数
+    };
+
+    static constexpr double SKIP_SEC = 10.0;            // 与右方向键的快进距离一致
+    static constexpr double MATCH_TOLERANCE_SEC = 0.5;  // 准备好的帧与 seek 目标允许的差距
+    static constexpr double RESEEK_GAP_SEC = 3.0;       // 目标超前解码位置更多时直接 seek，不顺序追赶
+    static constexpr int BACKOFF_MS = 1000;
+
+    SkipPrefetcher() = default;
+    ~SkipPrefetcher();
+    SkipPrefetcher(const SkipPrefetcher &) = delete;
+    SkipPrefetcher &operator=(const SkipPrefetcher &) = delete;
+
+    // 启动后台线程，文件在线程中打开；codecId 用于确认与主会话解码的是同一个流
+    void start(const QString &path, int videoStream, AVCodecID codecId);
+
+    void setTarget(double pts);             // 小于 0 表示暂停准备（快进/快退模式）
+    void reportLate();                      // 主解码线程落后于时钟
+    AVFrame *take(double target);           // 取与 target 最接近且在容差内的帧，调用者负责 av_frame_free
+    Stats stats() const;
+
+private:
+    void run();
+    bool openInput();
+    void closeInput();
+    void reseek(double target);
+    void decodeStep();
+    void acceptFrame(AVFrame *frame);       // 按目标放入 m_ready 或 m_ahead
+    double framePts(const AVFrame *frame) const;
+    bool backingOff() const;
+    static int interruptCallback(void *opaque);
+
+    QString m_path;
+    int m_stream = -1;
+    AVCodecID m_codecId = AV_CODEC_ID_NONE;
+    QThread *m_thread = nullptr;
+    std::atomic<bool> m_quit{false};
+
+    // 以下只在后台线程使用
+    MappedFileIO m_io;
+    AVFormatContext *m_fmt = nullptr;
+    AVCodecContext *m_ctx = nullptr;
+    AVPacket *m_packet = nullptr;
+    AVFrame *m_frame = nullptr;
+    double m_timeBase = 0.0;
+    double m_posPts = -1.0;                 // 最近解码出的帧，重新定位后尚未出帧时为 -1
+    double m_seekedTo = -1.0;               // 最近一次重新定位的目标，-1 表示尚未定位
+    bool m_eof = false;
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_cond;                  // 目标变化或退出
+    double m_target = -1.0;
+    AVFrame *m_ready = nullptr;             // 不晚于目标的最后一帧
+    double m_readyPts = -1.0;
+    std::deque<AVFrame*> m_ahead;           // 已解码但晚于目标的帧，目标前进后依次转为 m_ready
+
+    QElapsedTimer m_clock;
+    std::atomic<qint64> m_lateMs{-1};       // 最近一次主解码掉帧的时刻（m_clock）
+
+    std::atomic<qint64> m_hits{0};
+    std::atomic<qint64> m_misses{0};
+    std::atomic<qint64> m_reseeks{0};
+    std::atomic<qint64> m_backoffs{0};
+};
+
+#endif // SKIPPREFETCHER_H
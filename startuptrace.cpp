@@ -0,0 +1,35 @@
+#include "startuptrace.h"
+#include <QMutexLocker>
+
+void StartupTrace::start()
+{
+    QMutexLocker locker(&m_mutex);
+    m_phases.clear();
+    m_lastUs = 0;
+    m_clock.start();
+}
+
+void StartupTrace::mark(const char *phase)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_clock.isValid()) return;
+    qint64 now = m_clock.nsecsElapsed() / 1000;
+    m_phases.append({phase, now - m_lastUs});
+    m_lastUs = now;
+}
+
+qint64 StartupTrace::elapsedUs() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_clock.isValid() ? m_clock.nsecsElapsed() / 1000 : 0;
+}
+
+QString StartupTrace::report() const
+{
+    QMutexLocker locker(&m_mutex);
+    QString out = QString("total %1 ms").arg(m_lastUs / 1000.0, 0, 'f', 1);
+    for (const Phase &p : m_phases) {
+        out += QString(" | %1 %2").arg(QString::fromLatin1(p.name)).arg(p.us / 1000.0, 0, 'f', 1);
+    }
+    return out;
+}
@@ -0,0 +1,32 @@
+#ifndef STARTUPTRACE_H
+#define STARTUPTRACE_H
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+/**
+ * @brief 起播耗时分段记录：从发起打开到首帧显示，每个阶段记一次 mark。
+ * 各阶段分布在主线程、打开线程和解码线程，线程安全。
+ */
+class StartupTrace
+{
+public:
+    void start();
+    void mark(const char *phase);       // 记录自上一个 mark 以来的耗时
+    qint64 elapsedUs() const;
+    QString report() const;             // "total 42.1 ms | stop 0.3 | open 5.2 | ..."
+
+private:
+    struct Phase {
+        const char *name;
+        qint64 us;
+    };
+    mutable QMutex m_mutex;
+    QElapsedTimer m_clock;
+    qint64 m_lastUs = 0;
+    QVector<Phase> m_phases;
+};
+
+#endif // STARTUPTRACE_H
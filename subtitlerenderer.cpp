@@ -0,0 +1,201 @@
+#include "subtitlerenderer.h"
+#include "subtitletrack.h"
+#include <QFont>
+#include <QFontMetricsF>
+#include <QPainter>
+#include <QPainterPath>
+#include <algorithm>
+
+namespace {
+// 贪心折行：优先在空格处断开，没有空格（中日韩文本）时按字符断开
+QStringList wrapText(const QString &text, const QFontMetricsF &fm, double maxWidth)
+{
+    QStringList out;
+    for (const QString &para : text.split('\n')) {
+        if (fm.horizontalAdvance(para) <= maxWidth) {
+            out << para;
+            continue;
+        }
+        QString line;
+        int lastSpace = -1;
+        for (QChar ch : para) {
+            if (ch == ' ') lastSpace = line.size();
+            line += ch;
+            if (line.size() > 1 && fm.horizontalAdvance(line) > maxWidth) {
+                int cut = lastSpace > 0 ? lastSpace : line.size() - 1;
+                out << line.left(cut);
+                line = line.mid(lastSpace > 0 ? cut + 1 : cut);
+                lastSpace = -1;
+            }
+        }
+        if (!line.isEmpty()) out << line;
+    }
+    return out;
+}
+}
+
+void SubtitleRenderer::composite(QImage &frame, const SubtitleTrack &track, qint64 ms, const QSize &videoSize)
+{
+    const QVector<int> &cues = track.activeAt(ms);
+    if (cues.isEmpty() || frame.isNull()) return;
+
+    auto it = std::find_if(m_cache.begin(), m_cache.end(), [&](const Overlay &o) {
+        return o.track == &track && o.frameSize == frame.size() && o.cues == cues;
+    });
+    if (it == m_cache.end()) {
+        m_cache.push_front(render(track, cues, frame.size(), videoSize));
+        if (m_cache.size() > size_t(CACHE_SIZE)) m_cache.pop_back();
+    } else if (it != m_cache.begin()) {
+        Overlay o = std::move(*it);
+        m_cache.erase(it);
+        m_cache.push_front(std::move(o));
+    }
+
+    const Overlay &o = m_cache.front();
+    if (!o.image.isNull()) blend(frame, o.image, o.pos);
+}
+
+/**
+ * @brief 排版并光栅化一组 cue：文字转为路径后依次画阴影、描边、填充，位图字幕按源视频比例缩放
+ */
+SubtitleRenderer::Overlay SubtitleRenderer::render(const SubtitleTrack &track, const QVector<int> &cues,
+                                                   const QSize &frameSize, const QSize &videoSize) const
+{
+    Overlay o;
+    o.track = &track;
+    o.cues = cues;
+    o.frameSize = frameSize;
+
+    const double W = frameSize.width();
+    const double H = frameSize.height();
+    QSize playRes = track.playRes().isEmpty() ? QSize(384, 288) : track.playRes();
+    const double sx = W / playRes.width();
+    const double sy = H / playRes.height();
+
+    struct Item {
+        QPainterPath path;
+        SubtitleStyle style;
+        double outline = 0.0;
+        double shadow = 0.0;
+        QImage image;
+        QRectF imageRect;
+    };
+    QVector<Item> items;
+    QRectF bounds;
+    double bottomUsed = 0.0;    // 同一方位的多条字幕依次堆叠，不互相覆盖
+    double topUsed = 0.0;
+
+    for (int idx : cues) {
+        const SubtitleCue &c = track.cue(idx);
+        Item item;
+
+        if (!c.image.isNull()) {
+            QSize canvas = !track.canvasSize().isEmpty() ? track.canvasSize()
+                           : !videoSize.isEmpty()       ? videoSize
+                                                        : frameSize;
+            double bx = W / canvas.width();
+            double by = H / canvas.height();
+            item.image = c.image;
+            item.imageRect = QRectF(c.imageRect.x() * bx, c.imageRect.y() * by,
+                                    c.imageRect.width() * bx, c.imageRect.height() * by);
+            bounds |= item.imageRect;
+            items.append(item);
+            continue;
+        }
+
+        SubtitleStyle st = track.style(c.style);
+        int align = c.alignment > 0 ? c.alignment : st.alignment;
+        QFont font(st.fontName);
+        font.setPixelSize(std::max(8, qRound(st.fontSize * sy)));
+        font.setBold(st.bold);
+        font.setItalic(st.italic);
+        QFontMetricsF fm(font);
+
+        double marginL = st.marginL * sx;
+        double marginR = st.marginR * sx;
+        double marginV = st.marginV * sy;
+        double maxWidth = W - marginL - marginR;
+        if (maxWidth < W / 4) maxWidth = W * 0.9;
+
+        const QStringList lines = wrapText(c.text, fm, maxWidth);
+        double lineH = fm.lineSpacing();
+        double blockH = lineH * lines.size();
+        int col = (align - 1) % 3;      // 0 左 1 中 2 右
+        int row = (align - 1) / 3;      // 0 底 1 中 2 顶
+
+        double top;
+        if (row == 0) {
+            top = H - marginV - bottomUsed - blockH;
+            bottomUsed += blockH;
+        } else if (row == 2) {
+            top = marginV + topUsed;
+            topUsed += blockH;
+        } else {
+            top = (H - blockH) / 2;
+        }
+
+        for (int i = 0; i < lines.size(); ++i) {
+            double w = fm.horizontalAdvance(lines[i]);
+            double x = col == 0 ? marginL : col == 2 ? W - marginR - w : marginL + (maxWidth - w) / 2;
+            item.path.addText(x, top + i * lineH + fm.ascent(), font, lines[i]);
+        }
+        item.style = st;
+        item.outline = st.outlineWidth * sy;
+        item.shadow = st.shadow * sy;
+        bounds |= item.path.boundingRect().adjusted(-item.outline, -item.outline,
+                                                    item.outline + item.shadow, item.outline + item.shadow);
+        items.append(item);
+    }
+
+    QRect box = bounds.toAlignedRect().adjusted(-1, -1, 1, 1).intersected(QRect(QPoint(0, 0), frameSize));
+    if (box.isEmpty()) return o;
+
+    o.image = QImage(box.size(), QImage::Format_ARGB32_Premultiplied);
+    o.image.fill(Qt::transparent);
+    o.pos = box.topLeft();
+
+    QPainter p(&o.image);
+    p.setRenderHint(QPainter::Antialiasing);
+    p.setRenderHint(QPainter::SmoothPixmapTransform);
+    p.translate(-box.topLeft());
+    for (const Item &item : items) {
+        if (!item.image.isNull()) {
+            p.drawImage(item.imageRect, item.image);
+            continue;
+        }
+        if (item.shadow > 0.0) p.fillPath(item.path.translated(item.shadow, item.shadow), item.style.back);
+        if (item.outline > 0.0) {
+            p.strokePath(item.path, QPen(item.style.outline, item.outline * 2, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin));
+        }
+        p.fillPath(item.path, item.style.primary);
+    }
+    return o;
+}
+
+/**
+ * @brief 预乘 ARGB 叠加图混合到 RGB888 帧上，只处理包围盒内的像素
+ */
+void SubtitleRenderer::blend(QImage &frame, const QImage &overlay, const QPoint &pos)
+{
+    if (frame.format() != QImage::Format_RGB888) {
+        QPainter p(&frame);
+        p.drawImage(pos, overlay);
+        return;
+    }
+
+    const int w = overlay.width();
+    const int h = overlay.height();
+    for (int y = 0; y < h; ++y) {
+        const QRgb *src = reinterpret_cast<const QRgb*>(overlay.constScanLine(y));
+        uchar *dst = frame.scanLine(pos.y() + y) + pos.x() * 3;
+        for (int x = 0; x < w; ++x, dst += 3) {
+            QRgb px = src[x];
+            int a = qAlpha(px);
+            if (a == 0) continue;
+            int ia = 255 - a;
+            dst[0] = uchar(qRed(px) + (dst[0] * ia + 127) / 255);
+            dst[1] = uchar(qGreen(px) + (dst[1] * ia + 127) / 255);
+            dst[2] = uchar(qBlue(px) + (dst[2] * ia + 127) / 255);
+        }
+    }
+}
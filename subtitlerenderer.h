@@ -0,0 +1,43 @@
+#ifndef SUBTITLERENDERER_H
+#define SUBTITLERENDERER_H
+
+#include <QImage>
+#include <QPoint>
+#include <QSize>
+#include <QVector>
+#include <deque>
+
+class SubtitleTrack;
+
+/**
+ * @brief 字幕叠加：同一组 cue 只排版、光栅化一次
+ *
+ * 当前显示的 cue 集合连同输出尺寸作为键，缓存裁剪到包围盒的预乘 ARGB 叠加图；
+ * 之后每帧只做一次查找和包围盒范围内的 alpha 混合，不再重新排版文字。
+ * 只在解码线程使用。
+ */
+class SubtitleRenderer
+{
+public:
+    // 把 ms 时刻的字幕混合到 frame（RGB888）上；videoSize 为源视频尺寸，用于位图字幕坐标换算
+    void composite(QImage &frame, const SubtitleTrack &track, qint64 ms, const QSize &videoSize);
+    void clear() { m_cache.clear(); }
+
+private:
+    struct Overlay {
+        const SubtitleTrack *track = nullptr;
+        QVector<int> cues;
+        QSize frameSize;
+        QImage image;       // ARGB32_Premultiplied，已裁剪到包围盒
+        QPoint pos;
+    };
+
+    Overlay render(const SubtitleTrack &track, const QVector<int> &cues,
+                   const QSize &frameSize, const QSize &videoSize) const;
+    static void blend(QImage &frame, const QImage &overlay, const QPoint &pos);
+
+    static constexpr int CACHE_SIZE = 4;
+    std::deque<Overlay> m_cache;    // 最近使用的在前
+};
+
+#endif // SUBTITLERENDERER_H
@@ -0,0 +1,362 @@
+#include "subtitletrack.h"
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <QStringDecoder>
+#include <algorithm>
+
+namespace {
+// 按逗号切成 count 段，最后一段保留其余全部内容（ASS 文本中可以有逗号）
+QStringList splitFields(const QString &s, int count)
+{
+    QStringList out;
+    int pos = 0;
+    for (int i = 0; i < count - 1; ++i) {
+        int comma = s.indexOf(',', pos);
+        if (comma < 0) break;
+        out << s.mid(pos, comma - pos).trimmed();
+        pos = comma + 1;
+    }
+    out << s.mid(pos);
+    return out;
+}
+
+// ASS 颜色 &HAABBGGRR，alpha 为透明度（00 不透明）；SSA 也可能是十进制
+QColor parseAssColor(QString v)
+{
+    v = v.trimmed();
+    bool ok = false;
+    quint32 c = 0;
+    if (v.startsWith("&H", Qt::CaseInsensitive)) {
+        v = v.mid(2);
+        if (v.endsWith('&')) v.chop(1);
+        c = v.toUInt(&ok, 16);
+    } else {
+        c = quint32(v.toLongLong(&ok));
+    }
+    if (!ok) return QColor();
+    return QColor(int(c & 0xff), int((c >> 8) & 0xff), int((c >> 16) & 0xff), 255 - int((c >> 24) & 0xff));
+}
+
+// SSA 的 Alignment：1~3 底部，5~7 顶部，9~11 居中；转为小键盘方位
+int ssaToNumpad(int a)
+{
+    if (a >= 9) return a - 5;
+    if (a >= 5) return a + 2;
+    return a;
+}
+
+qint64 srtTimeMs(const QRegularExpressionMatch &m, int first)
+{
+    QString frac = m.captured(first + 3);
+    while (frac.size() < 3) frac += '0';
+    return m.captured(first).toLongLong() * 3600000 + m.captured(first + 1).toLongLong() * 60000
+           + m.captured(first + 2).toLongLong() * 1000 + frac.left(3).toLongLong();
+}
+}
+
+// ---------------- 加载 ----------------
+bool SubtitleTrack::loadFile(const QString &path)
+{
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly)) return false;
+    QByteArray data = f.readAll();
+
+    // 大多数字幕为 UTF-8（可带 BOM），否则按本地编码（如 GBK）解码
+    QStringDecoder utf8(QStringDecoder::Utf8);
+    QString content = utf8(data);
+    if (utf8.hasError()) content = QString::fromLocal8Bit(data);
+
+    m_name = QFileInfo(path).fileName();
+    QString suffix = QFileInfo(path).suffix().toLower();
+    bool ok = (suffix == "ass" || suffix == "ssa") ? parseAss(content) : parseSrt(content);
+    qDebug() << "Subtitle loaded:" << m_name << "cues:" << m_cues.size();
+    return ok && !m_cues.isEmpty();
+}
+
+bool SubtitleTrack::parseSrt(const QString &content)
+{
+    static const QRegularExpression timeRe(
+        R"((\d+):(\d+):(\d+)[,.](\d+)\s*-->\s*(\d+):(\d+):(\d+)[,.](\d+))");
+    static const QRegularExpression htmlTag("<[^>]*>");
+
+    const QStringList lines = content.split('\n');
+    for (int i = 0; i < lines.size(); ++i) {
+        QRegularExpressionMatch m = timeRe.match(lines[i]);
+        if (!m.hasMatch()) continue;
+
+        QStringList text;
+        int j = i + 1;
+        for (; j < lines.size(); ++j) {
+            QString line = lines[j];
+            if (line.endsWith('\r')) line.chop(1);
+            if (line.trimmed().isEmpty()) break;
+            text << line;
+        }
+        i = j;
+
+        SubtitleCue cue;
+        cue.startMs = srtTimeMs(m, 1);
+        cue.endMs = srtTimeMs(m, 5);
+        bool drawing = false;
+        cue.text = stripAssTags(text.join('\n'), &cue.alignment, &drawing).remove(htmlTag);
+        if (!cue.text.trimmed().isEmpty()) addCue(cue);
+    }
+    return true;
+}
+
+bool SubtitleTrack::parseAss(const QString &content)
+{
+    QString section;
+    bool ssa = false;
+    QStringList styleFormat;
+
+    const QStringList lines = content.split('\n');
+    for (QString line : lines) {
+        line = line.trimmed();
+        if (line.isEmpty() || line.startsWith(';')) continue;
+        if (line.startsWith('[')) {
+            section = line.toLower();
+            ssa = section == "[v4 styles]";
+            continue;
+        }
+        int colon = line.indexOf(':');
+        if (colon < 0) continue;
+        QString key = line.left(colon).trimmed().toLower();
+        QString value = line.mid(colon + 1).trimmed();
+
+        if (section == "[script info]") {
+            if (key == "playresx") m_playRes.setWidth(value.toInt());
+            else if (key == "playresy") m_playRes.setHeight(value.toInt());
+        } else if (section == "[v4+ styles]" || section == "[v4 styles]") {
+            if (key == "format") {
+                styleFormat.clear();
+                for (const QString &f : value.split(',')) styleFormat << f.trimmed().toLower();
+            } else if (key == "style") {
+                parseStyleLine(styleFormat, value, ssa);
+            }
+        } else if (section == "[events]") {
+            if (key == "format") {
+                m_eventFormat.clear();
+                for (const QString &f : value.split(',')) m_eventFormat << f.trimmed().toLower();
+            } else if (key == "dialogue") {
+                addAssEvent(line, -1, -1);
+            }
+        }
+    }
+
+    // 只给了一边时按 4:3 推算另一边，都没有时使用 ASS 规范默认的 384x288
+    if (m_playRes.width() <= 0 && m_playRes.height() <= 0) m_playRes = QSize(384, 288);
+    else if (m_playRes.height() <= 0) m_playRes.setHeight(m_playRes.width() * 3 / 4);
+    else if (m_playRes.width() <= 0) m_playRes.setWidth(m_playRes.height() * 4 / 3);
+    return true;
+}
+
+void SubtitleTrack::parseAssHeader(const QByteArray &header)
+{
+    if (header.isEmpty()) return;
+    parseAss(QString::fromUtf8(header));
+}
+
+void SubtitleTrack::parseStyleLine(const QStringList &format, const QString &values, bool ssa)
+{
+    if (format.isEmpty()) return;
+    const QStringList v = splitFields(values, format.size());
+    auto field = [&](const char *name) -> QString {
+        int i = format.indexOf(QString::fromLatin1(name));
+        return i >= 0 && i < v.size() ? v[i].trimmed() : QString();
+    };
+
+    SubtitleStyle st;
+    QString name = field("name");
+    if (!field("fontname").isEmpty()) st.fontName = field("fontname");
+    if (field("fontsize").toDouble() > 0) st.fontSize = field("fontsize").toDouble();
+    QColor c = parseAssColor(field("primarycolour"));
+    if (c.isValid()) st.primary = c;
+    c = parseAssColor(field(ssa ? "tertiarycolour" : "outlinecolour"));
+    if (c.isValid()) st.outline = c;
+    c = parseAssColor(field("backcolour"));
+    if (c.isValid()) st.back = c;
+    st.bold = field("bold").toInt() != 0;
+    st.italic = field("italic").toInt() != 0;
+    if (!field("outline").isEmpty()) st.outlineWidth = field("outline").toDouble();
+    if (!field("shadow").isEmpty()) st.shadow = field("shadow").toDouble();
+    if (field("alignment").toInt() > 0) {
+        int a = field("alignment").toInt();
+        st.alignment = ssa ? ssaToNumpad(a) : a;
+    }
+    if (!field("marginl").isEmpty()) st.marginL = field("marginl").toInt();
+    if (!field("marginr").isEmpty()) st.marginR = field("marginr").toInt();
+    if (!field("marginv").isEmpty()) st.marginV = field("marginv").toInt();
+    m_styles.insert(name.toLower(), st);
+}
+
+/**
+ * @brief 添加一行 ASS 事件。文件中的 "Dialogue: ..." 按 Format 解析；
+ * 嵌入流解码得到 "ReadOrder,Layer,Style,Name,MarginL,MarginR,MarginV,Effect,Text"，时间由调用者给出
+ */
+void SubtitleTrack::addAssEvent(const QString &line, qint64 startMs, qint64 endMs)
+{
+    SubtitleCue cue;
+    QString text;
+    if (line.startsWith("Dialogue:", Qt::CaseInsensitive)) {
+        QStringList format = m_eventFormat;
+        if (format.isEmpty()) {
+            format = QStringList{"layer", "start", "end", "style", "name",
+                                 "marginl", "marginr", "marginv", "effect", "text"};
+        }
+        const QStringList v = splitFields(line.mid(9).trimmed(), format.size());
+        auto field = [&](const char *name) -> QString {
+            int i = format.indexOf(QString::fromLatin1(name));
+            return i >= 0 && i < v.size() ? v[i] : QString();
+        };
+        cue.layer = field("layer").toInt();
+        cue.style = field("style");
+        cue.startMs = startMs >= 0 ? startMs : parseAssTime(field("start"));
+        cue.endMs = endMs >= 0 ? endMs : parseAssTime(field("end"));
+        text = field("text");
+    } else {
+        const QStringList v = splitFields(line, 9);
+        if (v.size() < 9) return;
+        cue.layer = v[1].toInt();
+        cue.style = v[2];
+        cue.startMs = startMs;
+        cue.endMs = endMs;
+        text = v[8];
+    }
+
+    bool drawing = false;
+    cue.text = stripAssTags(text, &cue.alignment, &drawing);
+    // 矢量绘图（\p1）不支持，按文本画出来只会是一串坐标
+    if (drawing || cue.text.trimmed().isEmpty()) return;
+    addCue(cue);
+}
+
+qint64 SubtitleTrack::parseAssTime(const QString &s)
+{
+    // H:MM:SS.cc
+    const QStringList parts = s.trimmed().split(':');
+    if (parts.size() != 3) return -1;
+    double sec = parts[2].toDouble();
+    return parts[0].toLongLong() * 3600000 + parts[1].toLongLong() * 60000 + qint64(sec * 1000.0 + 0.5);
+}
+
+/**
+ * @brief 去掉 {\...} 覆盖标签，只保留 \an 对齐；\N、\n 换行，\h 不换行空格
+ */
+QString SubtitleTrack::stripAssTags(const QString &text, int *alignment, bool *drawing)
+{
+    static const QRegularExpression anTag(R"(\\an([1-9]))");
+    static const QRegularExpression aTag(R"(\\a([0-9]+))");
+    static const QRegularExpression pTag(R"(\\p([0-9]+))");
+
+    QString out;
+    out.reserve(text.size());
+    for (int i = 0; i < text.size(); ++i) {
+        QChar ch = text[i];
+        if (ch == '{') {
+            int close = text.indexOf('}', i);
+            if (close < 0) break;
+            QString block = text.mid(i + 1, close - i - 1);
+            QRegularExpressionMatch m = anTag.match(block);
+            if (m.hasMatch()) {
+                *alignment = m.captured(1).toInt();
+            } else if ((m = aTag.match(block)).hasMatch()) {
+                *alignment = ssaToNumpad(m.captured(1).toInt());
+            }
+            QRegularExpressionMatchIterator it = pTag.globalMatch(block);
+            while (it.hasNext()) *drawing = it.next().captured(1).toInt() > 0;
+            i = close;
+            continue;
+        }
+        if (ch == '\\' && i + 1 < text.size()) {
+            QChar next = text[i + 1];
+            if (next == 'N' || next == 'n') { out += '\n'; ++i; continue; }
+            if (next == 'h') { out += QChar(0x00A0); ++i; continue; }
+        }
+        out += ch;
+    }
+    return out;
+}
+
+// ---------------- 增量追加 ----------------
+void SubtitleTrack::addCue(SubtitleCue cue)
+{
+    if (cue.endMs <= cue.startMs) return;
+    QString key = cue.image.isNull()
+                      ? QString("%1|%2|%3").arg(cue.startMs).arg(cue.endMs).arg(cue.text)
+                      : QString("%1|img|%2,%3,%4x%5").arg(cue.startMs).arg(cue.imageRect.x()).arg(cue.imageRect.y())
+                            .arg(cue.imageRect.width()).arg(cue.imageRect.height());
+    if (m_cueKeys.contains(key)) return;
+    m_cueKeys.insert(key);
+    m_cues.append(std::move(cue));
+    m_dirty = true;
+}
+
+void SubtitleTrack::closeOpenCues(qint64 ms)
+{
+    for (SubtitleCue &c : m_cues) {
+        if (c.endMs == SubtitleCue::OPEN_END && c.startMs < ms) {
+            c.endMs = ms;
+            m_dirty = true;
+        }
+    }
+}
+
+SubtitleStyle SubtitleTrack::style(const QString &name) const
+{
+    auto it = m_styles.constFind(name.toLower());
+    if (it != m_styles.constEnd()) return *it;
+    it = m_styles.constFind("default");
+    return it != m_styles.constEnd() ? *it : SubtitleStyle();
+}
+
+// ---------------- 区间索引 ----------------
+const QVector<int> &SubtitleTrack::activeAt(qint64 ms) const
+{
+    static const QVector<int> none;
+    if (m_dirty) rebuildIndex();
+    auto it = std::upper_bound(m_bounds.cbegin(), m_bounds.cend(), ms);
+    int k = int(it - m_bounds.cbegin()) - 1;
+    if (k < 0 || k >= m_segments.size()) return none;
+    return m_segments.at(k);
+}
+
+/**
+ * @brief 扫描线重建基本区间：起止时间排序后依次进出活动集合，O(n log n + 输出)
+ */
+void SubtitleTrack::rebuildIndex() const
+{
+    m_dirty = false;
+    m_bounds.clear();
+    m_segments.clear();
+
+    const int n = m_cues.size();
+    QVector<int> byStart(n), byEnd(n);
+    for (int i = 0; i < n; ++i) {
+        byStart[i] = i;
+        byEnd[i] = i;
+        m_bounds << m_cues[i].startMs << m_cues[i].endMs;
+    }
+    std::sort(m_bounds.begin(), m_bounds.end());
+    m_bounds.erase(std::unique(m_bounds.begin(), m_bounds.end()), m_bounds.end());
+    std::sort(byStart.begin(), byStart.end(), [this](int a, int b) { return m_cues[a].startMs < m_cues[b].startMs; });
+    std::sort(byEnd.begin(), byEnd.end(), [this](int a, int b) { return m_cues[a].endMs < m_cues[b].endMs; });
+
+    QVector<int> active;
+    int si = 0, ei = 0;
+    m_segments.reserve(m_bounds.size());
+    for (int k = 0; k + 1 < m_bounds.size(); ++k) {
+        qint64 t = m_bounds[k];
+        for (; ei < n && m_cues[byEnd[ei]].endMs <= t; ++ei) active.removeOne(byEnd[ei]);
+        for (; si < n && m_cues[byStart[si]].startMs <= t; ++si) {
+            if (m_cues[byStart[si]].endMs > t) active.append(byStart[si]);
+        }
+        QVector<int> seg = active;
+        std::sort(seg.begin(), seg.end(), [this](int a, int b) {
+            return m_cues[a].layer != m_cues[b].layer ? m_cues[a].layer < m_cues[b].layer : a < b;
+        });
+        m_segments.append(seg);
+    }
+}
@@ -0,0 +1,103 @@
+#ifndef SUBTITLETRACK_H
+#define SUBTITLETRACK_H
+
+#include <QByteArray>
+#include <QColor>
+#include <QHash>
+#include <QImage>
+#include <QRect>
+#include <QSet>
+#include <QSize>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <limits>
+
+/**
+ * @brief ASS 样式（[V4+ Styles] 中的一行），尺寸以脚本分辨率 PlayResX/PlayResY 为单位
+ */
+struct SubtitleStyle
+{
+    QString fontName = "Arial";
+    double fontSize = 18.0;
+    QColor primary = Qt::white;
+    QColor outline = Qt::black;
+    QColor back = QColor(0, 0, 0, 128);     // 阴影
+    bool bold = false;
+    bool italic = false;
+    double outlineWidth = 1.5;
+    double shadow = 1.0;
+    int alignment = 2;                      // 小键盘方位：1~3 底部，4~6 居中，7~9 顶部
+    int marginL = 10;
+    int marginR = 10;
+    int marginV = 12;
+};
+
+/**
+ * @brief 一条字幕：文本（SRT/ASS）或位图（PGS/DVD 等嵌入流）
+ */
+struct SubtitleCue
+{
+    qint64 startMs = 0;
+    qint64 endMs = 0;           // 不含；OPEN_END 表示等下一条位图字幕到来时结束
+    QString text;               // 已去掉 ASS 覆盖标签，\N 转为换行
+    QString style;              // ASS 样式名
+    int alignment = 0;          // \an 覆盖，0 表示使用样式
+    int layer = 0;
+    QImage image;               // 位图字幕，ARGB32_Premultiplied
+    QRect imageRect;            // 位图在 canvasSize 坐标中的位置
+
+    static constexpr qint64 OPEN_END = std::numeric_limits<qint64>::max() / 2;
+};
+
+/**
+ * @brief 一条字幕轨：外挂文件一次解析完成，嵌入流在解码时增量追加。
+ *
+ * 查询使用基本区间索引：所有 cue 的起止时间把时间轴切成若干区间，
+ * 每个区间内显示的 cue 集合固定，二分查找区间即可 O(log n) 得到当前字幕。
+ * 只在解码线程使用（外挂文件在主线程解析完成后整体移交）。
+ */
+class SubtitleTrack
+{
+public:
+    bool loadFile(const QString &path);             // .srt / .ass / .ssa
+    void parseAssHeader(const QByteArray &header);  // [Script Info] 与样式表，嵌入 ASS 流的 subtitle_header
+    void addAssEvent(const QString &line, qint64 startMs, qint64 endMs);   // 嵌入 ASS 流的事件行
+    void addCue(SubtitleCue cue);                   // 重复的 cue（seek 后重新解码）忽略
+    void closeOpenCues(qint64 ms);
+
+    // t 时刻应显示的 cue 序号（按 layer、出现顺序排列）；没有字幕时为空
+    const QVector<int> &activeAt(qint64 ms) const;
+    const SubtitleCue &cue(int index) const { return m_cues[index]; }
+    int cueCount() const { return m_cues.size(); }
+
+    SubtitleStyle style(const QString &name) const;
+    QSize playRes() const { return m_playRes; }     // ASS 脚本分辨率，未指定时为空
+    void setCanvasSize(const QSize &size) { m_canvasSize = size; }
+    QSize canvasSize() const { return m_canvasSize; }   // 位图字幕坐标系
+
+    QString name() const { return m_name; }
+
+private:
+    bool parseSrt(const QString &content);
+    bool parseAss(const QString &content);
+    void parseStyleLine(const QStringList &format, const QString &values, bool ssa);
+    static qint64 parseAssTime(const QString &s);
+    static QString stripAssTags(const QString &text, int *alignment, bool *drawing);
+    void rebuildIndex() const;
+
+    QString m_name;
+    QVector<SubtitleCue> m_cues;                    // 只追加，序号稳定
+    QSet<QString> m_cueKeys;                        // 去重
+    QHash<QString, SubtitleStyle> m_styles;
+    QStringList m_eventFormat;
+    QSize m_playRes;
+    QSize m_canvasSize;
+
+    // 基本区间：[m_bounds[k], m_bounds[k+1]) 内显示 m_segments[k]
+    mutable bool m_dirty = false;
+    mutable QVector<qint64> m_bounds;
+    mutable QVector<QVector<int>> m_segments;
+};
+
+#endif // SUBTITLETRACK_H
@@ -0,0 +1,238 @@
+#include "testmedia.h"
+#include <QCryptographicHash>
+#include <QDebug>
+#include <cmath>
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavutil/pixdesc.h>
+}
+
+namespace TestMedia {
+
+EncodedVideo::~EncodedVideo()
+{
+    for (AVPacket *p : packets) av_packet_free(&p);
+    avcodec_parameters_free(&par);
+}
+
+namespace {
+// 斜向渐变加一个移动的方块，相邻帧都不同
+void fillPicture(AVFrame *frame, int index)
+{
+    for (int y = 0; y < frame->height; ++y) {
+        uint8_t *row = frame->data[0] + y * frame->linesize[0];
+        for (int x = 0; x < frame->width; ++x) row[x] = uint8_t(x + y + index * 3);
+    }
+    const int bx = (index * 7) % (frame->width - 32);
+    const int by = (index * 5) % (frame->height - 32);
+    for (int y = by; y < by + 32; ++y) {
+        uint8_t *row = frame->data[0] + y * frame->linesize[0];
+        for (int x = bx; x < bx + 32; ++x) row[x] = 235;
+    }
+    for (int y = 0; y < frame->height / 2; ++y) {
+        uint8_t *u = frame->data[1] + y * frame->linesize[1];
+        uint8_t *v = frame->data[2] + y * frame->linesize[2];
+        for (int x = 0; x < frame->width / 2; ++x) {
+            u[x] = uint8_t(128 + y + index * 2);
+            v[x] = uint8_t(64 + x + index * 5);
+        }
+    }
+}
+
+// 440 Hz 正弦，交错 s16 立体声
+void fillTone(AVFrame *frame, int64_t firstSample)
+{
+    int16_t *samples = reinterpret_cast<int16_t*>(frame->data[0]);
+    for (int i = 0; i < frame->nb_samples; ++i) {
+        double t = double(firstSample + i) / frame->sample_rate;
+        int16_t v = int16_t(8000 * std::sin(2.0 * 3.14159265358979323846 * 440.0 * t));
+        for (int c = 0; c < frame->ch_layout.nb_channels; ++c) *samples++ = v;
+    }
+}
+
+AVCodecContext *openVideoEncoder(AVRational timeBase, bool closedGop, bool globalHeader)
+{
+    const AVCodec *codec = avcodec_find_encoder(AV_CODEC_ID_MPEG2VIDEO);
+    if (!codec) {
+        qWarning() << "TestMedia: 没有 mpeg2video 编码器";
+        return nullptr;
+    }
+    AVCodecContext *enc = avcodec_alloc_context3(codec);
+    enc->width = 320;
+    enc->height = 240;
+    enc->pix_fmt = AV_PIX_FMT_YUV420P;
+    enc->time_base = timeBase;
+    enc->framerate = av_inv_q(timeBase);
+    enc->gop_size = 12;
+    enc->max_b_frames = 2;
+    enc->bit_rate = 2000000;
+    if (closedGop) enc->flags |= AV_CODEC_FLAG_CLOSED_GOP;
+    if (globalHeader) enc->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+    if (avcodec_open2(enc, codec, nullptr) < 0) avcodec_free_context(&enc);
+    return enc;
+}
+
+AVCodecContext *openAudioEncoder(bool globalHeader)
+{
+    const AVCodec *codec = avcodec_find_encoder(AV_CODEC_ID_MP2);
+    if (!codec) {
+        qWarning() << "TestMedia: 没有 mp2 编码器";
+        return nullptr;
+    }
+    AVCodecContext *enc = avcodec_alloc_context3(codec);
+    enc->sample_rate = 48000;
+    enc->sample_fmt = AV_SAMPLE_FMT_S16;
+    av_channel_layout_default(&enc->ch_layout, 2);
+    enc->bit_rate = 192000;
+    enc->time_base = AVRational{1, enc->sample_rate};
+    if (globalHeader) enc->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+    if (avcodec_open2(enc, codec, nullptr) < 0) avcodec_free_context(&enc);
+    return enc;
+}
+
+bool allocVideoFrame(AVFrame *frame, const AVCodecContext *enc)
+{
+    frame->format = enc->pix_fmt;
+    frame->width = enc->width;
+    frame->height = enc->height;
+    return av_frame_get_buffer(frame, 0) >= 0;
+}
+
+bool drain(AVCodecContext *enc, AVPacket *pkt, std::vector<AVPacket*> &out)
+{
+    int ret;
+    while ((ret = avcodec_receive_packet(enc, pkt)) == 0) {
+        out.push_back(av_packet_clone(pkt));
+        av_packet_unref(pkt);
+    }
+    return ret == AVERROR(EAGAIN) || ret == AVERROR_EOF;
+}
+}
+
+bool encodeVideo(EncodedVideo &out, int frames, bool closedGop)
+{
+    AVCodecContext *enc = openVideoEncoder(out.timeBase, closedGop, false);
+    if (!enc) return false;
+
+    AVFrame *frame = av_frame_alloc();
+    AVPacket *pkt = av_packet_alloc();
+    bool ok = allocVideoFrame(frame, enc);
+    for (int i = 0; ok && i < frames; ++i) {
+        ok = av_frame_make_writable(frame) >= 0;
+        if (!ok) break;
+        fillPicture(frame, i);
+        frame->pts = i;
+        ok = avcodec_send_frame(enc, frame) >= 0 && drain(enc, pkt, out.packets);
+    }
+    if (ok) ok = avcodec_send_frame(enc, nullptr) >= 0 && drain(enc, pkt, out.packets);
+    if (ok) {
+        out.par = avcodec_parameters_alloc();
+        ok = avcodec_parameters_from_context(out.par, enc) >= 0;
+    }
+
+    av_packet_free(&pkt);
+    av_frame_free(&frame);
+    avcodec_free_context(&enc);
+    return ok;
+}
+
+bool writeClip(const QString &path, int seconds)
+{
+    const QByteArray file = path.toUtf8();
+    AVFormatContext *fmt = nullptr;
+    if (avformat_alloc_output_context2(&fmt, nullptr, nullptr, file.constData()) < 0) return false;
+    const bool globalHeader = fmt->oformat->flags & AVFMT_GLOBALHEADER;
+
+    AVCodecContext *venc = openVideoEncoder(AVRational{1, 25}, false, globalHeader);
+    AVCodecContext *aenc = openAudioEncoder(globalHeader);
+    AVFrame *vframe = av_frame_alloc();
+    AVFrame *aframe = av_frame_alloc();
+    AVPacket *pkt = av_packet_alloc();
+    AVStream *vs = nullptr;
+    AVStream *as = nullptr;
+
+    bool ok = venc && aenc && allocVideoFrame(vframe, venc);
+    if (ok) {
+        aframe->format = aenc->sample_fmt;
+        aframe->nb_samples = aenc->frame_size;
+        aframe->sample_rate = aenc->sample_rate;
+        ok = av_channel_layout_copy(&aframe->ch_layout, &aenc->ch_layout) >= 0
+             && av_frame_get_buffer(aframe, 0) >= 0;
+    }
+    if (ok) {
+        vs = avformat_new_stream(fmt, nullptr);
+        as = avformat_new_stream(fmt, nullptr);
+        ok = vs && as && avcodec_parameters_from_context(vs->codecpar, venc) >= 0
+             && avcodec_parameters_from_context(as->codecpar, aenc) >= 0;
+    }
+    if (ok) {
+        vs->time_base = venc->time_base;
+        as->time_base = aenc->time_base;
+        ok = avio_open(&fmt->pb, file.constData(), AVIO_FLAG_WRITE) >= 0
+             && avformat_write_header(fmt, nullptr) >= 0;
+    }
+
+    auto writeOut = [&](AVCodecContext *enc, AVStream *st) {
+        int ret;
+        while ((ret = avcodec_receive_packet(enc, pkt)) == 0) {
+            av_packet_rescale_ts(pkt, enc->time_base, st->time_base);
+            pkt->stream_index = st->index;
+            if (av_interleaved_write_frame(fmt, pkt) < 0) return false;
+        }
+        return ret == AVERROR(EAGAIN) || ret == AVERROR_EOF;
+    };
+
+    // 每帧视频之后补齐到同一时刻的音频，交错写入
+    const int frames = seconds * 25;
+    int64_t samples = 0;
+    for (int i = 0; ok && i < frames; ++i) {
+        ok = av_frame_make_writable(vframe) >= 0;
+        if (!ok) break;
+        fillPicture(vframe, i);
+        vframe->pts = i;
+        ok = avcodec_send_frame(venc, vframe) >= 0 && writeOut(venc, vs);
+        while (ok && samples * 25 < int64_t(i + 1) * aenc->sample_rate) {
+            ok = av_frame_make_writable(aframe) >= 0;
+            if (!ok) break;
+            fillTone(aframe, samples);
+            aframe->pts = samples;
+            samples += aframe->nb_samples;
+            ok = avcodec_send_frame(aenc, aframe) >= 0 && writeOut(aenc, as);
+        }
+    }
+    if (ok) {
+        ok = avcodec_send_frame(venc, nullptr) >= 0 && writeOut(venc, vs)
+             && avcodec_send_frame(aenc, nullptr) >= 0 && writeOut(aenc, as);
+    }
+    if (ok) ok = av_write_trailer(fmt) >= 0;
+
+    if (fmt->pb) avio_closep(&fmt->pb);
+    avformat_free_context(fmt);
+    av_packet_free(&pkt);
+    av_frame_free(&aframe);
+    av_frame_free(&vframe);
+    avcodec_free_context(&aenc);
+    avcodec_free_context(&venc);
+    return ok;
+}
+
+QByteArray frameHash(const AVFrame *frame)
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(AVPixelFormat(frame->format));
+    if (!desc) return QByteArray();
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    for (int plane = 0; plane < 4 && frame->data[plane]; ++plane) {
+        const bool chroma = plane == 1 || plane == 2;
+        const int w = chroma ? AV_CEIL_RSHIFT(frame->width, desc->log2_chroma_w) : frame->width;
+        const int h = chroma ? AV_CEIL_RSHIFT(frame->height, desc->log2_chroma_h) : frame->height;
+        const int bytes = w * ((desc->comp[0].depth + 7) / 8);
+        for (int y = 0; y < h; ++y) {
+            hash.addData(QByteArray::fromRawData(
+                reinterpret_cast<const char*>(frame->data[plane] + y * frame->linesize[plane]), bytes));
+        }
+    }
+    return hash.result();
+}
+
+} // namespace TestMedia
@@ -0,0 +1,40 @@
+#ifndef TESTMEDIA_H
+#define TESTMEDIA_H
+
+#include <QByteArray>
+#include <QString>
+#include <vector>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+/**
+ * @brief 测试用的合成音视频，运行时用 FFmpeg 内置编码器生成
+ */
+namespace TestMedia {
+
+// 编码好的视频包（解码顺序），析构时释放
+struct EncodedVideo {
+    EncodedVideo() = default;
+    ~EncodedVideo();
+    EncodedVideo(const EncodedVideo &) = delete;
+    EncodedVideo &operator=(const EncodedVideo &) = delete;
+
+    AVCodecParameters *par = nullptr;
+    AVRational timeBase{1, 25};
+    std::vector<AVPacket*> packets;
+};
+
+// mpeg2video，320x240，GOP 12 帧、两个 B 帧；closedGop 为 false 时 B 帧跨 GOP 参考（开放 GOP）
+bool encodeVideo(EncodedVideo &out, int frames, bool closedGop);
+
+// 写一个可以播放的文件（容器按扩展名，例如 .mkv）：上面的视频流 25 fps，加 48 kHz 立体声 mp2 正弦音
+bool writeClip(const QString &path, int seconds);
+
+// 可见区域各平面逐行的 MD5，与行宽对齐填充无关
+QByteArray frameHash(const AVFrame *frame);
+
+} // namespace TestMedia
+
+#endif // TESTMEDIA_H
@@ -0,0 +1,247 @@
+#include <QtTest>
+#include <QCryptographicHash>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QTemporaryDir>
+#include <cstring>
+#include <memory>
+
+#include "mappedfileio.h"
+#include "prefetchio.h"
+#include "testmedia.h"
+
+extern "C" {
+#include <libavformat/avformat.h>
+}
+
+/**
+ * @brief 自定义 AVIOContext 与 FFmpeg 自带 file 协议逐字节一致，并记录各自的吞吐量
+ *
+ * 顺序读取按 32 KB 一次（与 file 协议的缓冲相同），随机读取每次先 seek；
+ * 解复用比较 av_read_frame 得到的全部包。吞吐量与读取统计写入测试日志。
+ * 预读线程另测一组限速（PLAYER_IO_THROTTLE）的情形，模拟慢盘并记录停顿。
+ */
+class TestFileIO : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void sequentialRead_data();
+    void sequentialRead();
+    void randomRead_data();
+    void randomRead();
+    void demux_data();
+    void demux();
+
+private:
+    // 按名字打开一种读取方式："file" 为 FFmpeg 自带协议，其余为播放器的自定义 I/O
+    struct Source {
+        Source(const QString &backend, const QString &path);
+        ~Source();
+        QString stats() const;
+
+        AVIOContext *ctx = nullptr;
+        AVIOContext *owned = nullptr;
+        std::unique_ptr<MappedFileIO> mapped;
+        std::unique_ptr<PrefetchIO> prefetch;
+    };
+
+    static void addBackends(bool throttled);
+    static QByteArray demuxHash(AVIOContext *pb, const QString &path, int *packets);
+
+    static constexpr qint64 kDataSize = 64LL * 1024 * 1024;
+    static constexpr int kChunk = 32 * 1024;
+
+    QTemporaryDir m_dir;
+    QString m_data;
+    QString m_clip;
+    QByteArray m_bytes;
+};
+
+TestFileIO::Source::Source(const QString &backend, const QString &path)
+{
+    if (backend == "mapped") {
+        mapped = std::make_unique<MappedFileIO>();
+        if (mapped->open(path)) ctx = mapped->context();
+    } else if (backend.startsWith("prefetch")) {
+        // 限速在 open 时读取：64 MB/s，每次读取另加 2 ms 延迟
+        const bool throttled = backend.endsWith("throttled");
+        if (throttled) qputenv("PLAYER_IO_THROTTLE", "65536,2");
+        prefetch = std::make_unique<PrefetchIO>();
+        if (prefetch->open(path, 8, AVIOInterruptCB{nullptr, nullptr})) ctx = prefetch->context();
+        if (throttled) qunsetenv("PLAYER_IO_THROTTLE");
+    } else if (avio_open(&owned, path.toUtf8().constData(), AVIO_FLAG_READ) >= 0) {
+        ctx = owned;
+    }
+}
+
+TestFileIO::Source::~Source()
+{
+    if (owned) avio_closep(&owned);
+}
+
+QString TestFileIO::Source::stats() const
+{
+    if (mapped) {
+        MappedFileIO::Stats st = mapped->stats();
+        return QString("reads %1, %2 MB, seeks %3, maps %4")
+            .arg(st.reads).arg(st.bytes / (1024.0 * 1024.0), 0, 'f', 1).arg(st.seeks).arg(st.remaps);
+    }
+    if (prefetch) {
+        PrefetchIO::Stats st = prefetch->stats();
+        return QString("stalls %1 (%2 ms), disk reads %3, %4 MB, retargets %5")
+            .arg(st.stalls).arg(st.stallUs / 1000.0, 0, 'f', 1).arg(st.diskReads)
+            .arg(st.diskBytes / (1024.0 * 1024.0), 0, 'f', 1).arg(st.retargets);
+    }
+    return QString();
+}
+
+void TestFileIO::initTestCase()
+{
+    QVERIFY(m_dir.isValid());
+
+    // 伪随机内容，任何错位都会在比较中暴露
+    m_bytes.resize(kDataSize);
+    QRandomGenerator rng(2024);
+    rng.fillRange(reinterpret_cast<quint32*>(m_bytes.data()), kDataSize / sizeof(quint32));
+    m_data = m_dir.filePath("data.bin");
+    QFile file(m_data);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    QCOMPARE(file.write(m_bytes), kDataSize);
+    file.close();
+
+    m_clip = m_dir.filePath("clip.mkv");
+    QVERIFY(TestMedia::writeClip(m_clip, 30));
+}
+
+// 随机读取每次跳转都让预读线程重新读一块，限速时太慢，不参与
+void TestFileIO::addBackends(bool throttled)
+{
+    QTest::addColumn<QString>("backend");
+    QTest::newRow("file") << QString("file");
+    QTest::newRow("mapped") << QString("mapped");
+    QTest::newRow("prefetch") << QString("prefetch");
+    if (throttled) QTest::newRow("prefetch, throttled") << QString("prefetch-throttled");
+}
+
+void TestFileIO::sequentialRead_data()
+{
+    addBackends(true);
+}
+
+void TestFileIO::sequentialRead()
+{
+    QFETCH(QString, backend);
+    Source src(backend, m_data);
+    QVERIFY(src.ctx);
+
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    std::vector<unsigned char> buf(kChunk);
+    qint64 total = 0;
+    QElapsedTimer timer;
+    timer.start();
+    int n;
+    while ((n = avio_read(src.ctx, buf.data(), kChunk)) > 0) {
+        hash.addData(QByteArray::fromRawData(reinterpret_cast<const char*>(buf.data()), n));
+        total += n;
+    }
+    const qint64 ns = qMax<qint64>(timer.nsecsElapsed(), 1);
+
+    QCOMPARE(total, kDataSize);
+    QCOMPARE(hash.result(), QCryptographicHash::hash(m_bytes, QCryptographicHash::Md5));
+    qInfo("%s: %.0f MB/s sequential %s", qPrintable(backend),
+          kDataSize / (1024.0 * 1024.0) / (ns / 1e9), qPrintable(src.stats()));
+
+    // 限速时读取必然追上预读线程，等待要计入停顿
+    if (src.prefetch && backend.endsWith("throttled")) {
+        PrefetchIO::Stats st = src.prefetch->stats();
+        QVERIFY(st.stalls > 0);
+        QVERIFY(st.stallUs > 0);
+        QCOMPARE(st.diskBytes, kDataSize);
+    }
+}
+
+void TestFileIO::randomRead_data()
+{
+    addBackends(false);
+}
+
+void TestFileIO::randomRead()
+{
+    QFETCH(QString, backend);
+    Source src(backend, m_data);
+    QVERIFY(src.ctx);
+
+    // 向前向后都有的随机跳转，每次读 4~64 KB
+    QRandomGenerator rng(7);
+    std::vector<unsigned char> buf(64 * 1024);
+    const int seeks = 2000;
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < seeks; ++i) {
+        const qint64 pos = rng.bounded(kDataSize - qint64(buf.size()));
+        const int size = 4096 + int(rng.bounded(60 * 1024));
+        QCOMPARE(qint64(avio_seek(src.ctx, pos, SEEK_SET)), pos);
+        QCOMPARE(avio_read(src.ctx, buf.data(), size), size);
+        if (std::memcmp(buf.data(), m_bytes.constData() + pos, size_t(size)) != 0)
+            QFAIL(qPrintable(QString("mismatch at %1").arg(pos)));
+    }
+    const qint64 ns = qMax<qint64>(timer.nsecsElapsed(), 1);
+    qInfo("%s: %.1f us per seek+read %s", qPrintable(backend), ns / 1e3 / seeks, qPrintable(src.stats()));
+}
+
+QByteArray TestFileIO::demuxHash(AVIOContext *pb, const QString &path, int *packets)
+{
+    AVFormatContext *fmt = avformat_alloc_context();
+    fmt->pb = pb;
+    fmt->flags |= AVFMT_FLAG_CUSTOM_IO;
+    if (avformat_open_input(&fmt, path.toUtf8().constData(), nullptr, nullptr) < 0) return QByteArray();
+
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    AVPacket *pkt = av_packet_alloc();
+    *packets = 0;
+    while (av_read_frame(fmt, pkt) >= 0) {
+        hash.addData(QByteArray::fromRawData(reinterpret_cast<const char*>(&pkt->pts), sizeof(pkt->pts)));
+        hash.addData(QByteArray::fromRawData(reinterpret_cast<const char*>(pkt->data), pkt->size));
+        ++*packets;
+        av_packet_unref(pkt);
+    }
+    av_packet_free(&pkt);
+    avformat_close_input(&fmt);
+    return hash.result();
+}
+
+void TestFileIO::demux_data()
+{
+    addBackends(true);
+}
+
+void TestFileIO::demux()
+{
+    QFETCH(QString, backend);
+
+    int expectedPackets = 0;
+    QByteArray expected;
+    {
+        Source reference("file", m_clip);
+        QVERIFY(reference.ctx);
+        expected = demuxHash(reference.ctx, m_clip, &expectedPackets);
+    }
+    QVERIFY(!expected.isEmpty());
+
+    Source src(backend, m_clip);
+    QVERIFY(src.ctx);
+    int packets = 0;
+    QElapsedTimer timer;
+    timer.start();
+    const QByteArray actual = demuxHash(src.ctx, m_clip, &packets);
+    const qint64 ns = qMax<qint64>(timer.nsecsElapsed(), 1);
+
+    QCOMPARE(packets, expectedPackets);
+    QCOMPARE(actual, expected);
+    qInfo("%s: %d packets in %.1f ms %s", qPrintable(backend), packets, ns / 1e6, qPrintable(src.stats()));
+}
+
+QTEST_GUILESS_MAIN(TestFileIO)
+#include "tst_fileio.moc"
@@ -0,0 +1,119 @@
+#include <QtTest>
+
+#include "gopdecoder.h"
+#include "testmedia.h"
+
+/**
+ * @brief GOP 并行解码的输出必须与单解码器顺序解码逐帧一致（内容、pts 与顺序），且每帧只输出一次
+ */
+class TestGopDecoder : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void matchesSequential_data();
+    void matchesSequential();
+
+private:
+    struct Decoded {
+        QList<QByteArray> hashes;
+        QList<qint64> pts;
+    };
+    static Decoded decodeSequential(const TestMedia::EncodedVideo &video);
+    static Decoded decodeParallel(const TestMedia::EncodedVideo &video, int workers);
+    static void append(Decoded &out, AVFrame *frame);
+};
+
+void TestGopDecoder::append(Decoded &out, AVFrame *frame)
+{
+    out.hashes << TestMedia::frameHash(frame);
+    out.pts << (frame->pts != AV_NOPTS_VALUE ? frame->pts : frame->best_effort_timestamp);
+}
+
+TestGopDecoder::Decoded TestGopDecoder::decodeSequential(const TestMedia::EncodedVideo &video)
+{
+    Decoded out;
+    const AVCodec *codec = avcodec_find_decoder(video.par->codec_id);
+    AVCodecContext *ctx = avcodec_alloc_context3(codec);
+    avcodec_parameters_to_context(ctx, video.par);
+    ctx->thread_count = 1;
+    ctx->pkt_timebase = video.timeBase;
+    if (avcodec_open2(ctx, codec, nullptr) < 0) {
+        avcodec_free_context(&ctx);
+        return out;
+    }
+    AVFrame *frame = av_frame_alloc();
+    auto receiveAll = [&]() {
+        while (avcodec_receive_frame(ctx, frame) == 0) {
+            append(out, frame);
+            av_frame_unref(frame);
+        }
+    };
+    for (const AVPacket *pkt : video.packets) {
+        avcodec_send_packet(ctx, pkt);
+        receiveAll();
+    }
+    avcodec_send_packet(ctx, nullptr);
+    receiveAll();
+    av_frame_free(&frame);
+    avcodec_free_context(&ctx);
+    return out;
+}
+
+TestGopDecoder::Decoded TestGopDecoder::decodeParallel(const TestMedia::EncodedVideo &video, int workers)
+{
+    Decoded out;
+    GopParallelDecoder gop(nullptr, workers);
+    if (!gop.open(video.par, video.timeBase)) return out;
+    for (const AVPacket *pkt : video.packets) gop.pushPacket(pkt);
+    gop.flush();
+    while (AVFrame *frame = gop.takeFrame(true)) {
+        append(out, frame);
+        av_frame_free(&frame);
+    }
+    return out;
+}
+
+void TestGopDecoder::matchesSequential_data()
+{
+    QTest::addColumn<bool>("closedGop");
+    QTest::addColumn<bool>("stripTimestamps");
+    QTest::addColumn<int>("workers");
+
+    QTest::newRow("open GOP") << false << false << 4;
+    QTest::newRow("closed GOP") << true << false << 4;
+    QTest::newRow("open GOP, one worker") << false << false << 1;
+    // 全部包都没有时间戳：下一个关键帧由两个任务重叠解码，只能按包归属
+    QTest::newRow("no timestamps") << true << true << 4;
+}
+
+void TestGopDecoder::matchesSequential()
+{
+    QFETCH(bool, closedGop);
+    QFETCH(bool, stripTimestamps);
+    QFETCH(int, workers);
+
+    TestMedia::EncodedVideo video;
+    QVERIFY(TestMedia::encodeVideo(video, 120, closedGop));
+    QVERIFY(video.packets.size() >= 120);
+    if (stripTimestamps) {
+        for (AVPacket *pkt : video.packets) {
+            pkt->pts = AV_NOPTS_VALUE;
+            pkt->dts = AV_NOPTS_VALUE;
+        }
+    }
+
+    const Decoded sequential = decodeSequential(video);
+    const Decoded parallel = decodeParallel(video, workers);
+    QCOMPARE(sequential.hashes.size(), 120);
+    QCOMPARE(parallel.hashes.size(), sequential.hashes.size());
+    for (int i = 0; i < sequential.hashes.size(); ++i) {
+        if (parallel.hashes[i] != sequential.hashes[i])
+            QFAIL(qPrintable(QString("frame %1 differs (pts %2 vs %3)")
+                                 .arg(i).arg(parallel.pts[i]).arg(sequential.pts[i])));
+    }
+    QCOMPARE(parallel.pts, sequential.pts);
+}
+
+QTEST_GUILESS_MAIN(TestGopDecoder)
+#include "tst_gopdecoder.moc"
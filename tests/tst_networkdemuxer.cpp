@@ -0,0 +1,370 @@
+#include <QtTest>
+#include <QCryptographicHash>
+#include <QElapsedTimer>
+#include <QRegularExpression>
+#include <QScopeGuard>
+#include <QSemaphore>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTemporaryDir>
+#include <QThread>
+#include <QTimer>
+#include <algorithm>
+#include <atomic>
+#include <list>
+#include <memory>
+
+#include "memorybudget.h"
+#include "networkdemuxer.h"
+#include "testmedia.h"
+
+/**
+ * @brief 本地限速 HTTP 服务器：支持 Range 请求，带宽可随时调整，可在发送到指定字节数时断开连接一次
+ *
+ * 在自己的线程里运行事件循环，每 10 ms 按带宽发送一批；带宽为 0 时停止发送（连接保持）。
+ */
+class ThrottledHttpServer : public QThread
+{
+public:
+    explicit ThrottledHttpServer(const QByteArray &body) : m_body(body) {}
+    ~ThrottledHttpServer() override { quit(); wait(); }
+
+    bool waitListening() { return m_ready.tryAcquire(1, 5000) && m_port != 0; }
+    QString url() const { return QString("http://127.0.0.1:%1/clip.mkv").arg(m_port); }
+    void setRate(qint64 bytesPerSec) { m_rate.store(bytesPerSec); }
+    void dropOnceAfter(qint64 bytes) { m_dropAt.store(m_sent.load() + bytes); }   // 再发送 bytes 字节后断开
+    int drops() const { return m_drops.load(); }
+    int requests() const { return m_requests.load(); }
+
+protected:
+    void run() override;
+
+private:
+    struct Connection {
+        QTcpSocket *socket;
+        QByteArray request;
+        qint64 pos = -1;                    // 未收到完整请求头时为 -1
+        qint64 end = 0;
+    };
+
+    void respond(Connection &c);
+    void send(Connection &c, double &credit);
+
+    static constexpr qint64 kSocketBacklog = 64 * 1024;     // 套接字待发送数据的上限，带宽才不被缓冲吞掉
+
+    const QByteArray m_body;
+    QSemaphore m_ready;
+    quint16 m_port = 0;
+    std::atomic<qint64> m_rate{0};
+    std::atomic<qint64> m_sent{0};
+    std::atomic<qint64> m_dropAt{-1};
+    std::atomic<int> m_drops{0};
+    std::atomic<int> m_requests{0};
+};
+
+void ThrottledHttpServer::run()
+{
+    QTcpServer server;
+    if (server.listen(QHostAddress::LocalHost, 0)) m_port = server.serverPort();
+    m_ready.release();
+    if (!m_port) return;
+
+    std::list<Connection> connections;
+    QObject::connect(&server, &QTcpServer::newConnection, [&]() {
+        while (QTcpSocket *socket = server.nextPendingConnection()) connections.push_back({socket});
+    });
+
+    QElapsedTimer clock;
+    clock.start();
+    double credit = 0.0;
+    QTimer timer;
+    QObject::connect(&timer, &QTimer::timeout, [&]() {
+        // 带宽额度按实际经过的时间累计，最多攒 100 ms
+        const qint64 rate = m_rate.load();
+        const qint64 ms = clock.restart();
+        credit = rate > 0 ? std::min(credit + rate * ms / 1000.0, rate * 0.1) : 0.0;
+        for (auto it = connections.begin(); it != connections.end();) {
+            Connection &c = *it;
+            if (c.socket->state() != QAbstractSocket::ConnectedState) {
+                c.socket->deleteLater();
+                it = connections.erase(it);
+                continue;
+            }
+            if (c.pos < 0) respond(c);
+            else if (c.pos < c.end) send(c, credit);
+            else if (c.socket->bytesToWrite() == 0) c.socket->disconnectFromHost();
+            ++it;
+        }
+    });
+    timer.start(10);
+    exec();
+}
+
+void ThrottledHttpServer::respond(Connection &c)
+{
+    c.request += c.socket->readAll();
+    const int headerEnd = c.request.indexOf("\r\n\r\n");
+    if (headerEnd < 0) return;
+    ++m_requests;
+
+    static const QRegularExpression rangeHeader("\\r\\nRange:\\s*bytes=(\\d+)-(\\d*)",
+                                                QRegularExpression::CaseInsensitiveOption);
+    const qint64 size = m_body.size();
+    qint64 from = 0, to = size - 1;
+    const QRegularExpressionMatch range = rangeHeader.match(QString::fromLatin1(c.request.left(headerEnd)));
+    if (range.hasMatch()) {
+        from = range.captured(1).toLongLong();
+        if (!range.captured(2).isEmpty()) to = std::min(to, range.captured(2).toLongLong());
+    }
+
+    QByteArray head;
+    if (from >= size) {
+        head = "HTTP/1.1 416 Range Not Satisfiable\r\nContent-Range: bytes */" + QByteArray::number(size)
+               + "\r\nContent-Length: 0\r\n";
+        c.pos = c.end = 0;
+    } else {
+        head = range.hasMatch()
+                   ? "HTTP/1.1 206 Partial Content\r\nContent-Range: bytes " + QByteArray::number(from) + "-"
+                         + QByteArray::number(to) + "/" + QByteArray::number(size) + "\r\n"
+                   : QByteArray("HTTP/1.1 200 OK\r\n");
+        head += "Content-Length: " + QByteArray::number(to - from + 1)
+                + "\r\nAccept-Ranges: bytes\r\nContent-Type: video/x-matroska\r\n";
+        c.pos = from;
+        c.end = to + 1;
+    }
+    c.socket->write(head + "Connection: close\r\n\r\n");
+}
+
+void ThrottledHttpServer::send(Connection &c, double &credit)
+{
+    while (c.pos < c.end && credit >= 1.0 && c.socket->bytesToWrite() < kSocketBacklog) {
+        qint64 n = std::min({c.end - c.pos, qint64(credit), qint64(16 * 1024)});
+        const qint64 dropAt = m_dropAt.load();
+        const bool drop = dropAt >= 0 && m_sent.load() + n >= dropAt;
+        if (drop) n = std::max<qint64>(dropAt - m_sent.load(), 0);
+
+        c.socket->write(m_body.constData() + c.pos, n);
+        c.pos += n;
+        m_sent += n;
+        credit -= double(n);
+        if (drop) {
+            // 已写出的部分尽量发出去，再以 RST 断开，客户端看到的是传输中途断线
+            c.socket->flush();
+            c.socket->abort();
+            m_dropAt.store(-1);
+            ++m_drops;
+            return;
+        }
+    }
+}
+
+/**
+ * @brief 网络流解复用线程：缓冲水位的状态转换、服务器中途断开后的恢复与重连后的去重
+ *
+ * 片段由 testmedia 生成（30 秒 mkv），经本地限速 HTTP 服务器播放；参考结果是本地文件直接解复用的包序列。
+ */
+class TestNetworkDemuxer : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void watermarks();
+    void reconnect_data();
+    void reconnect();
+
+private:
+    // 打开一路 HTTP 播放，析构时按播放器的顺序先置停止标志再停读取线程
+    struct HttpSession {
+        ~HttpSession();
+        bool open(const QString &url, bool ffmpegReconnect);
+        static int interrupt(void *opaque);
+
+        AVFormatContext *fmt = nullptr;
+        std::unique_ptr<NetworkDemuxer> demuxer;
+        MemoryBudget budget;
+        std::atomic<bool> stop{false};
+    };
+
+    static QString describe(const AVPacket *pkt);
+    static int readPacket(NetworkDemuxer *demuxer, AVPacket *pkt, bool honorWatermarks, int timeoutMs);
+
+    QTemporaryDir m_dir;
+    QByteArray m_clip;
+    QStringList m_expected;                 // 本地解复用的全部包
+};
+
+TestNetworkDemuxer::HttpSession::~HttpSession()
+{
+    stop.store(true);
+    demuxer.reset();
+    avformat_close_input(&fmt);
+}
+
+int TestNetworkDemuxer::HttpSession::interrupt(void *opaque)
+{
+    auto *session = static_cast<HttpSession*>(opaque);
+    return session->stop.load() || (session->demuxer && session->demuxer->interruptRequested()) ? 1 : 0;
+}
+
+bool TestNetworkDemuxer::HttpSession::open(const QString &url, bool ffmpegReconnect)
+{
+    fmt = avformat_alloc_context();
+    fmt->interrupt_callback.callback = &HttpSession::interrupt;
+    fmt->interrupt_callback.opaque = this;
+
+    // 关掉 http 协议自己的重连，断线交给 NetworkDemuxer 处理
+    AVDictionary *opts = NetworkDemuxer::openOptions();
+    if (!ffmpegReconnect) {
+        av_dict_set(&opts, "reconnect", "0", 0);
+        av_dict_set(&opts, "reconnect_streamed", "0", 0);
+        av_dict_set(&opts, "reconnect_on_network_error", "0", 0);
+    }
+    int ret = avformat_open_input(&fmt, url.toUtf8().constData(), nullptr, &opts);
+    av_dict_free(&opts);
+    if (ret < 0 || avformat_find_stream_info(fmt, nullptr) < 0) return false;
+
+    const int video = av_find_best_stream(fmt, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+    if (video < 0) return false;
+    demuxer = std::make_unique<NetworkDemuxer>(fmt, video, stop);
+    demuxer->start(&budget);
+    return true;
+}
+
+QString TestNetworkDemuxer::describe(const AVPacket *pkt)
+{
+    // dts 可能由 libavformat 推算，seek 之后推算结果不一定相同，只比较容器给出的 pts 与数据
+    const QByteArray md5 = QCryptographicHash::hash(
+        QByteArray::fromRawData(reinterpret_cast<const char*>(pkt->data), pkt->size), QCryptographicHash::Md5);
+    return QString("%1:%2:%3:%4").arg(pkt->stream_index).arg(pkt->pts).arg(pkt->size).arg(QString(md5.toHex()));
+}
+
+// 读一个包，缓冲中时等待数据，直到超时；返回 read() 最后的结果
+int TestNetworkDemuxer::readPacket(NetworkDemuxer *demuxer, AVPacket *pkt, bool honorWatermarks, int timeoutMs)
+{
+    QElapsedTimer timer;
+    timer.start();
+    int ret;
+    while ((ret = demuxer->read(pkt, honorWatermarks)) == AVERROR(EAGAIN) && !timer.hasExpired(timeoutMs))
+        demuxer->waitForData(50);
+    return ret;
+}
+
+void TestNetworkDemuxer::initTestCase()
+{
+    avformat_network_init();
+    if (!avio_find_protocol_name("http://127.0.0.1/")) QSKIP("FFmpeg built without the http protocol");
+
+    QVERIFY(m_dir.isValid());
+    const QString path = m_dir.filePath("clip.mkv");
+    QVERIFY(TestMedia::writeClip(path, 30));
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    m_clip = file.readAll();
+
+    AVFormatContext *fmt = nullptr;
+    QVERIFY(avformat_open_input(&fmt, path.toUtf8().constData(), nullptr, nullptr) >= 0);
+    QVERIFY(avformat_find_stream_info(fmt, nullptr) >= 0);      // 与播放时相同，包序列才可比
+    AVPacket *pkt = av_packet_alloc();
+    while (av_read_frame(fmt, pkt) >= 0) {
+        m_expected << describe(pkt);
+        av_packet_unref(pkt);
+    }
+    av_packet_free(&pkt);
+    avformat_close_input(&fmt);
+    QVERIFY(m_expected.size() > 30 * 25);
+    qInfo("clip: %.1f MB, %lld packets", m_clip.size() / (1024.0 * 1024.0), qlonglong(m_expected.size()));
+}
+
+void TestNetworkDemuxer::watermarks()
+{
+    ThrottledHttpServer server(m_clip);
+    server.start();
+    QVERIFY(server.waitListening());
+    server.setRate(512 * 1024);            // 约为片段码率的两倍
+
+    HttpSession session;
+    QVERIFY(session.open(server.url(), true));
+    NetworkDemuxer *demuxer = session.demuxer.get();
+    AVPacket *pkt = av_packet_alloc();
+    auto cleanup = qScopeGuard([&]() { av_packet_free(&pkt); });
+
+    // 起播：缓冲到 START_WATERMARK_SEC 才出第一个包
+    QVERIFY(demuxer->isBuffering());
+    QCOMPARE(readPacket(demuxer, pkt, true, 10000), 0);
+    av_packet_unref(pkt);
+    QVERIFY(!demuxer->isBuffering());
+    QVERIFY2(demuxer->stats().bufferedSec >= NetworkDemuxer::START_WATERMARK_SEC - 0.1,
+             qPrintable(QString("started at %1 s").arg(demuxer->stats().bufferedSec)));
+
+    // 服务器停止发送：取空到低水位以下即进入缓冲，不再出包
+    server.setRate(0);
+    QElapsedTimer timer;
+    timer.start();
+    int ret;
+    while ((ret = demuxer->read(pkt, true)) == 0 && !timer.hasExpired(10000)) av_packet_unref(pkt);
+    QCOMPARE(ret, AVERROR(EAGAIN));
+    QVERIFY(demuxer->isBuffering());
+    QCOMPARE(demuxer->stats().rebuffers, qint64(1));
+    QVERIFY(demuxer->stats().bufferedSec < NetworkDemuxer::LOW_WATERMARK_SEC);
+    QTest::qWait(300);
+    QCOMPARE(demuxer->read(pkt, true), AVERROR(EAGAIN));
+    QVERIFY(demuxer->bufferingPercent() < 100);
+
+    // 恢复发送：这次要攒够 HIGH_WATERMARK_SEC 才恢复出包
+    server.setRate(4 * 1024 * 1024);
+    QCOMPARE(readPacket(demuxer, pkt, true, 10000), 0);
+    av_packet_unref(pkt);
+    QVERIFY(!demuxer->isBuffering());
+    QVERIFY2(demuxer->stats().bufferedSec >= NetworkDemuxer::HIGH_WATERMARK_SEC - 0.1,
+             qPrintable(QString("resumed at %1 s").arg(demuxer->stats().bufferedSec)));
+    QCOMPARE(demuxer->stats().rebuffers, qint64(1));
+}
+
+void TestNetworkDemuxer::reconnect_data()
+{
+    QTest::addColumn<bool>("ffmpegReconnect");
+    QTest::newRow("ffmpeg reconnect") << true;
+    QTest::newRow("demuxer reconnect") << false;
+}
+
+void TestNetworkDemuxer::reconnect()
+{
+    QFETCH(bool, ffmpegReconnect);
+
+    ThrottledHttpServer server(m_clip);
+    server.start();
+    QVERIFY(server.waitListening());
+    server.setRate(8 * 1024 * 1024);
+
+    HttpSession session;
+    QVERIFY(session.open(server.url(), ffmpegReconnect));
+    NetworkDemuxer *demuxer = session.demuxer.get();
+    server.dropOnceAfter(m_clip.size() / 3);
+
+    // 断开后读取必须继续，直到正常读到流尾
+    QStringList actual;
+    AVPacket *pkt = av_packet_alloc();
+    auto cleanup = qScopeGuard([&]() { av_packet_free(&pkt); });
+    int ret;
+    while ((ret = readPacket(demuxer, pkt, false, 15000)) == 0) {
+        actual << describe(pkt);
+        av_packet_unref(pkt);
+    }
+    QCOMPARE(ret, AVERROR_EOF);
+    QCOMPARE(server.drops(), 1);
+    QVERIFY(server.requests() >= 2);
+    if (!ffmpegReconnect) QVERIFY(demuxer->stats().reconnects >= 1);
+
+    // 重连前后不重复、不缺包：与本地解复用逐包一致
+    for (int i = 0; i < std::min(actual.size(), m_expected.size()); ++i) {
+        if (actual[i] != m_expected[i])
+            QFAIL(qPrintable(QString("packet %1: got %2, expected %3").arg(i).arg(actual[i], m_expected[i])));
+    }
+    QCOMPARE(actual.size(), m_expected.size());
+    qInfo("%s: %lld packets, %d requests, %lld demuxer reconnects", QTest::currentDataTag(),
+          qlonglong(actual.size()), server.requests(), qlonglong(demuxer->stats().reconnects));
+}
+
+QTEST_GUILESS_MAIN(TestNetworkDemuxer)
+#include "tst_networkdemuxer.moc"
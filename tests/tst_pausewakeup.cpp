@@ -0,0 +1,103 @@
+#include <QtTest>
+#include <QRegularExpression>
+#include <QTemporaryDir>
+
+#include "videoplayer.h"
+#include "testmedia.h"
+
+/**
+ * @brief 用生成的片段驱动完整的 VideoPlayer：
+ * 暂停期间解码线程阻塞在命令等待上、音频刷新定时器停止，两个线程都不应被周期性唤醒；
+ * 起播耗时报告包含从打开到首帧显示的全部阶段（总耗时写入测试日志，便于发现退化）
+ */
+class TestPauseWakeup : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void pausedPlayerStaysIdle();
+    void startupReportCoversAllPhases_data();
+    void startupReportCoversAllPhases();
+
+private:
+    QTemporaryDir m_dir;
+    QString m_clip;
+};
+
+void TestPauseWakeup::initTestCase()
+{
+    QVERIFY(m_dir.isValid());
+    m_clip = m_dir.filePath("clip.mkv");
+    QVERIFY(TestMedia::writeClip(m_clip, 10));
+}
+
+void TestPauseWakeup::pausedPlayerStaysIdle()
+{
+    VideoPlayer player;
+    QVERIFY(player.openFile(m_clip));
+    player.setRenderSize(320, 240);
+
+    QSignalSpy frames(&player, &VideoPlayer::frameReady);
+    player.play();
+    QVERIFY(frames.wait(5000));
+    QTest::qWait(300);
+
+    player.pause();
+    QTest::qWait(200);      // 解码线程执行 Pause 命令并进入等待
+    const quint64 before = player.decodeWakeups();
+    QTest::qWait(1000);
+    const quint64 woken = player.decodeWakeups() - before;
+    QVERIFY2(woken <= 1, qPrintable(QString("decode loop woke %1 times while paused").arg(woken)));
+    QVERIFY(!player.audioFlushActive());
+
+    // 恢复播放不能丢失唤醒
+    frames.clear();
+    player.play();
+    QVERIFY(frames.wait(2000));
+    player.stop();
+}
+
+void TestPauseWakeup::startupReportCoversAllPhases_data()
+{
+    QTest::addColumn<bool>("async");
+    QTest::newRow("openFile") << false;
+    QTest::newRow("openFileAsync") << true;
+}
+
+void TestPauseWakeup::startupReportCoversAllPhases()
+{
+    QFETCH(bool, async);
+
+    VideoPlayer player;
+    player.setRenderSize(320, 240);
+    QSignalSpy frames(&player, &VideoPlayer::frameReady);
+    if (async) {
+        QSignalSpy opened(&player, &VideoPlayer::openFinished);
+        player.openFileAsync(m_clip);
+        QVERIFY(opened.wait(5000));
+        QVERIFY(opened.first().first().toBool());
+    } else {
+        QVERIFY(player.openFile(m_clip));
+    }
+    player.play();
+    QVERIFY(frames.wait(5000));
+
+    // "total 42.1 ms | stop 0.3 | open 5.2 | ..."：阶段按发生顺序排列
+    const QString report = player.startupReport();
+    const QStringList parts = report.split(" | ");
+    QStringList phases;
+    for (int i = 1; i < parts.size(); ++i) phases << parts[i].section(' ', 0, 0);
+    const QStringList expected{"stop", "open", "probe", "codecs", "install", "play",
+                               "thread", "decode", "convert", "present"};
+    if (phases.size() > 2 && phases[2] == "probe(snapshot)") phases[2] = "probe";     // 列表加载时已探测过
+    QVERIFY2(phases == expected, qPrintable(report));
+
+    const QRegularExpressionMatch total = QRegularExpression("^total ([0-9.]+) ms").match(report);
+    QVERIFY2(total.hasMatch(), qPrintable(report));
+    qInfo("time to first frame %s ms (%s)", qPrintable(total.captured(1)), qPrintable(report));
+    player.stop();
+}
+
+QTEST_MAIN(TestPauseWakeup)
+#include "tst_pausewakeup.moc"
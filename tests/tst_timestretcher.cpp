@@ -0,0 +1,122 @@
+#include <QtTest>
+#include <QElapsedTimer>
+#include <cmath>
+
+#include "timestretcher.h"
+
+/**
+ * @brief 内置 WSOLA 时间伸缩：输出长度、音高、1.0x 透明以及处理速度
+ *
+ * 输入为 10 秒 48 kHz 立体声 440 Hz 正弦，按 1024 帧一块推入（与解码线程的块大小相当）。
+ */
+class TestTimeStretcher : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void stretch_data();
+    void stretch();
+    void unityRateIsTransparent();
+
+private:
+    static constexpr int kRate = 48000;
+    static constexpr int kChannels = 2;
+    static constexpr int kFrames = kRate * 10;
+    static constexpr double kTone = 440.0;
+
+    std::vector<int16_t> run(double rate, qint64 *elapsedNs = nullptr) const;
+    static double toneFrequency(const std::vector<int16_t> &out);
+
+    std::vector<float> m_input;
+};
+
+void TestTimeStretcher::initTestCase()
+{
+    m_input.resize(size_t(kFrames) * kChannels);
+    for (int i = 0; i < kFrames; ++i) {
+        float v = float(0.5 * std::sin(2.0 * 3.14159265358979323846 * kTone * i / kRate));
+        for (int c = 0; c < kChannels; ++c) m_input[size_t(i) * kChannels + c] = v;
+    }
+}
+
+std::vector<int16_t> TestTimeStretcher::run(double rate, qint64 *elapsedNs) const
+{
+    TimeStretcher ts;
+    ts.configure(kRate, kChannels);
+    ts.setRate(rate);
+
+    std::vector<int16_t> out;
+    std::vector<int16_t> buf(size_t(4096) * kChannels);
+    auto drain = [&]() {
+        int n;
+        while ((n = ts.read(buf.data(), 4096)) > 0)
+            out.insert(out.end(), buf.begin(), buf.begin() + size_t(n) * kChannels);
+    };
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int pos = 0; pos < kFrames; pos += 1024) {
+        ts.push(m_input.data() + size_t(pos) * kChannels, std::min(1024, kFrames - pos));
+        drain();
+    }
+    ts.flush();
+    drain();
+    if (elapsedNs) *elapsedNs = timer.nsecsElapsed();
+    return out;
+}
+
+// 中间一半的过零次数估计频率，避开开头结尾的补齐静音
+double TestTimeStretcher::toneFrequency(const std::vector<int16_t> &out)
+{
+    const size_t frames = out.size() / kChannels;
+    const size_t from = frames / 4, to = frames * 3 / 4;
+    int crossings = 0;
+    for (size_t i = from + 1; i < to; ++i) {
+        if ((out[(i - 1) * kChannels] < 0) != (out[i * kChannels] < 0)) ++crossings;
+    }
+    return crossings / 2.0 / (double(to - from) / kRate);
+}
+
+void TestTimeStretcher::stretch_data()
+{
+    QTest::addColumn<double>("rate");
+    for (double rate : {0.25, 0.5, 0.75, 1.0, 1.25, 1.5, 2.0, 3.0, 4.0})
+        QTest::newRow(qPrintable(QString::number(rate) + "x")) << rate;
+}
+
+void TestTimeStretcher::stretch()
+{
+    QFETCH(double, rate);
+
+    qint64 ns = 0;
+    const std::vector<int16_t> out = run(rate, &ns);
+
+    // flush 后输出长度严格等于输入时长除以倍速
+    QCOMPARE(qint64(out.size() / kChannels), qint64(std::llround(kFrames / rate)));
+
+    // 变速不变调
+    const double freq = toneFrequency(out);
+    QVERIFY2(std::abs(freq - kTone) < kTone * 0.01, qPrintable(QString("tone %1 Hz").arg(freq)));
+
+    // 速度以实时倍数记录；至少要能实时处理
+    const double realtime = 10.0 / (double(qMax<qint64>(ns, 1)) / 1e9);
+    qInfo("%.2fx: %.0fx realtime (%.1f ms for 10 s)", rate, realtime, ns / 1e6);
+    QVERIFY(realtime > 1.0);
+}
+
+void TestTimeStretcher::unityRateIsTransparent()
+{
+    // 1.0x 时每段都选中名义位置，Hann 窗 50% 重叠相加恰好还原输入
+    const std::vector<int16_t> out = run(1.0);
+    QCOMPARE(out.size(), m_input.size());
+    int maxDiff = 0;
+    for (size_t i = 0; i < out.size(); ++i) {
+        const int expected = int(std::lrint(m_input[i] * 32767.0f));
+        maxDiff = qMax(maxDiff, std::abs(out[i] - expected));
+    }
+    QVERIFY2(maxDiff <= 1, qPrintable(QString("max difference %1").arg(maxDiff)));
+}
+
+QTEST_GUILESS_MAIN(TestTimeStretcher)
+#include "tst_timestretcher.moc"
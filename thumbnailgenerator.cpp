@@ -0,0 +1,165 @@
+#include "thumbnailgenerator.h"
+#include "probesnapshot.h"
+#include "mappedfileio.h"
+#include <QDebug>
+#include <QFileInfo>
+#include <QRunnable>
+#include <QThread>
+#include <algorithm>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libswscale/swscale.h>
+}
+
+ThumbnailGenerator::ThumbnailGenerator(QObject *parent)
+    : QObject(parent)
+    , m_store(std::make_unique<ThumbnailStore>(ThumbnailStore::defaultPath()))
+{
+    // 缩略图不能和播放争 CPU/磁盘：线程数取核数的四分之一，线程本身也降到最低优先级
+    m_pool.setMaxThreadCount(std::clamp(QThread::idealThreadCount() / 4, 1, 4));
+}
+
+ThumbnailGenerator::~ThumbnailGenerator()
+{
+    cancel();
+    m_pool.waitForDone();
+}
+
+qint64 ThumbnailGenerator::fileMtime(const QString &path)
+{
+    return QFileInfo(path).lastModified().toMSecsSinceEpoch();
+}
+
+QImage ThumbnailGenerator::cached(const QString &path) const
+{
+    return m_store->lookup(path, fileMtime(path));
+}
+
+void ThumbnailGenerator::request(const QStringList &paths)
+{
+    cancel();
+    const quint64 generation = m_generation.load();
+    for (const QString &path : paths) {
+        if (!cached(path).isNull()) continue;
+        m_pool.start(QRunnable::create([this, path, generation]() {
+            if (m_generation.load() != generation) return;
+            QThread::currentThread()->setPriority(QThread::LowestPriority);
+            QImage img = generate(path, QSize(THUMB_WIDTH, THUMB_HEIGHT));
+            if (img.isNull()) return;
+            m_store->insert(path, fileMtime(path), img);
+            if (m_generation.load() == generation) emit thumbnailReady(path, img);
+        }));
+    }
+}
+
+void ThumbnailGenerator::cancel()
+{
+    ++m_generation;
+    m_pool.clear();
+}
+
+/**
+ * @brief 解码一个关键帧作为缩略图：跳到时长 10% 处（避开片头黑屏），只送关键帧给解码器
+ */
+QImage ThumbnailGenerator::generate(const QString &path, const QSize &maxSize)
+{
+    MappedFileIO io;
+    AVFormatContext *fmt = avformat_alloc_context();
+    if (fmt && MappedFileIO::isLocalFile(path) && io.open(path)) {
+        fmt->pb = io.context();
+        fmt->flags |= AVFMT_FLAG_CUSTOM_IO;
+    }
+    if (avformat_open_input(&fmt, path.toUtf8().constData(), nullptr, nullptr) != 0) return QImage();
+    std::shared_ptr<const ProbeSnapshot> snapshot = ProbeSnapshot::lookup(path);
+    if (!(snapshot && snapshot->applyTo(fmt)) && avformat_find_stream_info(fmt, nullptr) < 0) {
+        avformat_close_input(&fmt);
+        return QImage();
+    }
+
+    const AVCodec *codec = nullptr;
+    int index = av_find_best_stream(fmt, AVMEDIA_TYPE_VIDEO, -1, -1, &codec, 0);
+    if (index < 0 || !codec) {
+        avformat_close_input(&fmt);
+        return QImage();
+    }
+    for (unsigned i = 0; i < fmt->nb_streams; ++i) {
+        fmt->streams[i]->discard = int(i) == index ? AVDISCARD_DEFAULT : AVDISCARD_ALL;
+    }
+    AVStream *st = fmt->streams[index];
+
+    AVCodecContext *ctx = avcodec_alloc_context3(codec);
+    avcodec_parameters_to_context(ctx, st->codecpar);
+    ctx->thread_count = 1;
+    ctx->skip_frame = AVDISCARD_NONKEY;
+    ctx->skip_loop_filter = AVDISCARD_ALL;
+    ctx->flags2 |= AV_CODEC_FLAG2_FAST;
+    // 支持 lowres 的解码器（MPEG-2/4、MJPEG 等）直接输出缩小的图像，仍保留两倍余量供缩放
+    int lowres = 0;
+    while (lowres < codec->max_lowres && (st->codecpar->width >> (lowres + 1)) >= maxSize.width() * 2) ++lowres;
+    ctx->lowres = lowres;
+    if (avcodec_open2(ctx, codec, nullptr) < 0) {
+        avcodec_free_context(&ctx);
+        avformat_close_input(&fmt);
+        return QImage();
+    }
+
+    if (!(st->disposition & AV_DISPOSITION_ATTACHED_PIC) && fmt->duration > 0) {
+        int64_t ts = av_rescale_q(fmt->duration / 10, AVRational{1, AV_TIME_BASE}, st->time_base);
+        if (st->start_time != AV_NOPTS_VALUE) ts += st->start_time;
+        av_seek_frame(fmt, index, ts, AVSEEK_FLAG_BACKWARD);
+    }
+
+    AVPacket *pkt = av_packet_alloc();
+    AVFrame *frame = av_frame_alloc();
+    bool got = false;
+    // 最多读 300 个包：关键帧间隔很长或解码失败的文件直接放弃
+    for (int n = 0; n < 300 && !got; ++n) {
+        int ret = av_read_frame(fmt, pkt);
+        if (ret < 0) {
+            avcodec_send_packet(ctx, nullptr);
+        } else if (pkt->stream_index != index) {
+            av_packet_unref(pkt);
+            continue;
+        } else {
+            avcodec_send_packet(ctx, pkt);
+            av_packet_unref(pkt);
+        }
+        got = avcodec_receive_frame(ctx, frame) == 0;
+        if (ret < 0) break;
+    }
+
+    QImage img;
+    if (got && frame->width > 0 && frame->height > 0) {
+        // 按显示宽高比（考虑像素宽高比）缩放到不超过 maxSize
+        double dar = double(frame->width) / frame->height;
+        if (frame->sample_aspect_ratio.num > 0 && frame->sample_aspect_ratio.den > 0) dar *= av_q2d(frame->sample_aspect_ratio);
+        int w = maxSize.width();
+        int h = qRound(w / dar);
+        if (h > maxSize.height()) {
+            h = maxSize.height();
+            w = qRound(h * dar);
+        }
+        w = std::max(2, w);
+        h = std::max(2, h);
+
+        SwsContext *sws = sws_getContext(frame->width, frame->height, AVPixelFormat(frame->format),
+                                         w, h, AV_PIX_FMT_RGB24, SWS_AREA, nullptr, nullptr, nullptr);
+        if (sws) {
+            img = QImage(w, h, QImage::Format_RGB888);
+            uint8_t *dst[4] = { img.bits(), nullptr, nullptr, nullptr };
+            int dstLinesize[4] = { static_cast<int>(img.bytesPerLine()), 0, 0, 0 };
+            sws_scale(sws, frame->data, frame->linesize, 0, frame->height, dst, dstLinesize);
+            sws_freeContext(sws);
+        }
+    } else {
+        qDebug() << "Thumbnail: no keyframe decoded for" << path;
+    }
+
+    av_frame_free(&frame);
+    av_packet_free(&pkt);
+    avcodec_free_context(&ctx);
+    avformat_close_input(&fmt);
+    return img;
+}
@@ -0,0 +1,48 @@
+#ifndef THUMBNAILGENERATOR_H
+#define THUMBNAILGENERATOR_H
+
+#include <QImage>
+#include <QObject>
+#include <QSize>
+#include <QStringList>
+#include <QThreadPool>
+#include <atomic>
+#include <memory>
+
+#include "thumbnailstore.h"
+
+/**
+ * @brief 视频列表缩略图
+ *
+ * 先查 ThumbnailStore，未命中的文件交给低优先级线程池：每个文件只解码一个关键帧，
+ * 解码器开启 lowres 并跳过环路滤波，缩放到 THUMB_SIZE 后写入存储并发出 thumbnailReady。
+ * 切换文件夹时 request() 会丢弃上一批尚未开始的任务。
+ */
+class ThumbnailGenerator : public QObject
+{
+    Q_OBJECT
+public:
+    static constexpr int THUMB_WIDTH = 128;
+    static constexpr int THUMB_HEIGHT = 72;
+
+    explicit ThumbnailGenerator(QObject *parent = nullptr);
+    ~ThumbnailGenerator();
+
+    QImage cached(const QString &path) const;       // 已有缩略图（文件修改过则视为没有）
+    void request(const QStringList &paths);         // 为没有缩略图的文件排队生成
+    void cancel();
+
+    static QImage generate(const QString &path, const QSize &maxSize);
+
+signals:
+    void thumbnailReady(const QString &path, const QImage &image);   // 在工作线程中发出
+
+private:
+    static qint64 fileMtime(const QString &path);
+
+    std::unique_ptr<ThumbnailStore> m_store;
+    QThreadPool m_pool;
+    std::atomic<quint64> m_generation{0};   // 每次 request/cancel 递增，旧任务开始前发现不一致即放弃
+};
+
+#endif // THUMBNAILGENERATOR_H
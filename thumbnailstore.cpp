@@ -0,0 +1,195 @@
+#include "thumbnailstore.h"
+#include <QDebug>
+#include <QDir>
+#include <QMutexLocker>
+#include <QStandardPaths>
+#include <cstring>
+
+namespace {
+constexpr quint32 FILE_MAGIC = 0x4D485450;      // "PTHM"
+constexpr quint32 FILE_VERSION = 1;
+constexpr quint32 RECORD_MAGIC = 0x424D4854;    // "THMB"
+constexpr qint64 MAX_FILE_SIZE = 512LL * 1024 * 1024;   // 超过后整体重建，避免无限增长
+
+struct FileHeader {
+    quint32 magic;
+    quint32 version;
+};
+
+struct RecordHeader {
+    quint32 magic;
+    quint32 keyBytes;
+    qint64 mtimeMs;
+    quint16 width;
+    quint16 height;
+    quint32 bytesPerLine;
+    quint32 dataBytes;
+    quint32 reserved;
+};
+static_assert(sizeof(FileHeader) == 8, "FileHeader layout");
+static_assert(sizeof(RecordHeader) == 32, "RecordHeader layout");
+
+inline qint64 align8(qint64 n) { return (n + 7) & ~qint64(7); }
+}
+
+ThumbnailStore::ThumbnailStore(const QString &filePath)
+    : m_file(filePath)
+{
+    open();
+}
+
+ThumbnailStore::~ThumbnailStore()
+{
+    if (m_map) m_file.unmap(m_map);
+}
+
+QString ThumbnailStore::defaultPath()
+{
+    QString dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    QDir().mkpath(dir);
+    return QDir(dir).filePath("thumbnails.bin");
+}
+
+/**
+ * @brief 打开并映射缩略图文件，扫描记录建立索引；文件损坏或版本不符时清空重建
+ */
+void ThumbnailStore::open()
+{
+    if (!m_file.open(QIODevice::ReadWrite)) {
+        qWarning() << "Thumbnail store unavailable:" << m_file.fileName() << m_file.errorString();
+        return;
+    }
+    m_writable = true;
+
+    FileHeader fh{};
+    bool valid = m_file.size() >= qint64(sizeof(fh)) && m_file.size() <= MAX_FILE_SIZE
+                 && m_file.read(reinterpret_cast<char*>(&fh), sizeof(fh)) == qint64(sizeof(fh))
+                 && fh.magic == FILE_MAGIC && fh.version == FILE_VERSION;
+    if (!valid) {
+        fh = {FILE_MAGIC, FILE_VERSION};
+        m_file.resize(0);
+        m_file.seek(0);
+        m_file.write(reinterpret_cast<const char*>(&fh), sizeof(fh));
+        m_file.flush();
+        m_validSize = sizeof(fh);
+        return;
+    }
+
+    qint64 size = m_file.size();
+    m_map = m_file.map(0, size);
+    if (!m_map) {
+        qWarning() << "Thumbnail store map failed:" << m_file.errorString();
+        m_validSize = size;
+        return;
+    }
+    m_validSize = scan(m_map, size);
+
+    // 末尾有残缺记录（上次写入中途退出）：解除映射、截掉残缺部分后重新映射并建立索引
+    if (m_validSize < size) {
+        m_index.clear();
+        m_file.unmap(m_map);
+        m_file.resize(m_validSize);
+        m_map = m_file.map(0, m_validSize);
+        if (m_map) scan(m_map, m_validSize);
+    }
+    qDebug() << "Thumbnail store:" << m_index.size() << "entries," << m_validSize / 1024 << "KB";
+}
+
+qint64 ThumbnailStore::scan(const uchar *data, qint64 size)
+{
+    qint64 pos = sizeof(FileHeader);
+    while (pos + qint64(sizeof(RecordHeader)) <= size) {
+        RecordHeader rh;
+        std::memcpy(&rh, data + pos, sizeof(rh));
+        if (rh.magic != RECORD_MAGIC || rh.width == 0 || rh.height == 0
+            || rh.bytesPerLine < rh.width * 3u || rh.dataBytes != rh.bytesPerLine * rh.height) {
+            break;
+        }
+        qint64 keyPos = pos + sizeof(RecordHeader);
+        qint64 dataPos = keyPos + align8(rh.keyBytes);
+        qint64 end = dataPos + align8(rh.dataBytes);
+        if (end > size) break;
+
+        // 同一路径后写入的记录覆盖先前的
+        Entry e;
+        e.mtimeMs = rh.mtimeMs;
+        e.pixels = data + dataPos;
+        e.width = rh.width;
+        e.height = rh.height;
+        e.bytesPerLine = int(rh.bytesPerLine);
+        m_index.insert(QString::fromUtf8(reinterpret_cast<const char*>(data + keyPos), rh.keyBytes), e);
+        pos = end;
+    }
+    return pos;
+}
+
+QImage ThumbnailStore::lookup(const QString &path, qint64 mtimeMs) const
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_index.constFind(path);
+    if (it == m_index.constEnd() || it->mtimeMs != mtimeMs) return QImage();
+    if (!it->pixels) return it->image;
+    return QImage(it->pixels, it->width, it->height, it->bytesPerLine, QImage::Format_RGB888);
+}
+
+/**
+ * @brief 追加一条缩略图记录并更新索引，返回是否已写入文件
+ */
+bool ThumbnailStore::insert(const QString &path, qint64 mtimeMs, const QImage &image)
+{
+    if (image.isNull()) return false;
+    QImage img = image.format() == QImage::Format_RGB888 ? image : image.convertToFormat(QImage::Format_RGB888);
+
+    QMutexLocker locker(&m_mutex);
+    if (ensureWritable()) {
+        const QByteArray key = path.toUtf8();
+        RecordHeader rh{};
+        rh.magic = RECORD_MAGIC;
+        rh.keyBytes = quint32(key.size());
+        rh.mtimeMs = mtimeMs;
+        rh.width = quint16(img.width());
+        rh.height = quint16(img.height());
+        rh.bytesPerLine = quint32(img.bytesPerLine());
+        rh.dataBytes = rh.bytesPerLine * rh.height;
+
+        QByteArray record(int(sizeof(rh) + align8(rh.keyBytes) + align8(rh.dataBytes)), '\0');
+        char *p = record.data();
+        std::memcpy(p, &rh, sizeof(rh));
+        std::memcpy(p + sizeof(rh), key.constData(), key.size());
+        std::memcpy(p + sizeof(rh) + align8(rh.keyBytes), img.constBits(), rh.dataBytes);
+
+        if (m_file.seek(m_validSize) && m_file.write(record) == record.size()) {
+            m_file.flush();
+            m_validSize += record.size();
+        } else {
+            qWarning() << "Thumbnail store write failed:" << m_file.errorString();
+            m_writable = false;
+        }
+    }
+
+    // 写盘失败时仍保留在内存中，本次运行内可用
+    Entry e;
+    e.mtimeMs = mtimeMs;
+    e.width = img.width();
+    e.height = img.height();
+    e.bytesPerLine = int(img.bytesPerLine());
+    e.image = img;
+    m_index.insert(path, e);
+    return m_writable;
+}
+
+bool ThumbnailStore::ensureWritable()
+{
+    if (!m_writable) return false;
+    if (m_validSize + (1 << 20) > MAX_FILE_SIZE) {
+        qWarning() << "Thumbnail store full, new thumbnails are kept in memory only";
+        m_writable = false;
+    }
+    return m_writable;
+}
+
+int ThumbnailStore::count() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_index.size();
+}
@@ -0,0 +1,56 @@
+#ifndef THUMBNAILSTORE_H
+#define THUMBNAILSTORE_H
+
+#include <QFile>
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QString>
+
+/**
+ * @brief 缩略图持久化存储
+ *
+ * 所有缩略图追加写入同一个文件，打开时整体内存映射并扫描一遍建立索引，
+ * 键为（绝对路径，修改时间），文件被修改后旧记录自然失效。
+ * 查询直接返回指向映射内存的 QImage，不解码、不拷贝；本次运行新增的缩略图保存在内存中，
+ * 下次打开时随文件一起映射。线程安全。
+ *
+ * 记录格式：RecordHeader | 路径 UTF-8（补齐到 8 字节） | RGB888 像素（每行补齐到 4 字节）
+ */
+class ThumbnailStore
+{
+public:
+    explicit ThumbnailStore(const QString &filePath);
+    ~ThumbnailStore();
+
+    // 命中时返回缩略图；映射内存中的图像在本对象存活期间有效，长期持有请 copy()
+    QImage lookup(const QString &path, qint64 mtimeMs) const;
+    bool insert(const QString &path, qint64 mtimeMs, const QImage &image);
+
+    int count() const;
+
+    static QString defaultPath();     // 缓存目录下的 thumbnails.bin
+
+private:
+    struct Entry {
+        qint64 mtimeMs = 0;
+        const uchar *pixels = nullptr;  // 指向映射区；为空时使用 image
+        int width = 0;
+        int height = 0;
+        int bytesPerLine = 0;
+        QImage image;                   // 本次运行新写入的缩略图
+    };
+
+    void open();
+    qint64 scan(const uchar *data, qint64 size);   // 返回最后一条完整记录的结尾
+    bool ensureWritable();
+
+    mutable QMutex m_mutex;
+    QFile m_file;
+    uchar *m_map = nullptr;
+    qint64 m_validSize = 0;             // 文件中完整记录的总长度，之后的残缺数据在写入前截掉
+    bool m_writable = false;
+    QHash<QString, Entry> m_index;
+};
+
+#endif // THUMBNAILSTORE_H
@@ -0,0 +1,248 @@
+#include "timestretcher.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define TIMESTRETCH_SSE 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define TIMESTRETCH_NEON 1
+#endif
+
+namespace {
+constexpr double kFrameSec = 0.020;     // 段长
+constexpr double kSearchSec = 0.010;    // 搜索半径
+constexpr int kCoarseStep = 4;          // 粗搜索步长，之后在最优点 ±3 内细搜
+constexpr double kPi = 3.14159265358979323846;
+
+// 一次遍历同时求 a·b 与 b·b
+void correlate(const float *a, const float *b, int n, float &dot, float &energy)
+{
+    int i = 0;
+    dot = 0.0f;
+    energy = 0.0f;
+#if defined(TIMESTRETCH_SSE)
+    __m128 d = _mm_setzero_ps();
+    __m128 e = _mm_setzero_ps();
+    for (; i + 4 <= n; i += 4) {
+        __m128 va = _mm_loadu_ps(a + i);
+        __m128 vb = _mm_loadu_ps(b + i);
+        d = _mm_add_ps(d, _mm_mul_ps(va, vb));
+        e = _mm_add_ps(e, _mm_mul_ps(vb, vb));
+    }
+    float td[4], te[4];
+    _mm_storeu_ps(td, d);
+    _mm_storeu_ps(te, e);
+    dot = (td[0] + td[1]) + (td[2] + td[3]);
+    energy = (te[0] + te[1]) + (te[2] + te[3]);
+#elif defined(TIMESTRETCH_NEON)
+    float32x4_t d = vdupq_n_f32(0.0f);
+    float32x4_t e = vdupq_n_f32(0.0f);
+    for (; i + 4 <= n; i += 4) {
+        float32x4_t va = vld1q_f32(a + i);
+        float32x4_t vb = vld1q_f32(b + i);
+        d = vmlaq_f32(d, va, vb);
+        e = vmlaq_f32(e, vb, vb);
+    }
+    float td[4], te[4];
+    vst1q_f32(td, d);
+    vst1q_f32(te, e);
+    dot = (td[0] + td[1]) + (td[2] + td[3]);
+    energy = (te[0] + te[1]) + (te[2] + te[3]);
+#endif
+    for (; i < n; ++i) {
+        dot += a[i] * b[i];
+        energy += b[i] * b[i];
+    }
+}
+}
+
+void TimeStretcher::configure(int sampleRate, int channels)
+{
+    m_sampleRate = sampleRate > 0 ? sampleRate : 48000;
+    m_channels = channels > 0 ? channels : 2;
+
+    m_hop = std::max(64, int(m_sampleRate * kFrameSec / 2));
+    m_frameLen = m_hop * 2;
+    m_search = std::max(kCoarseStep, int(m_sampleRate * kSearchSec) / kCoarseStep * kCoarseStep);
+
+    // 周期 Hann 窗：步长 N/2 时相邻两段的窗之和恒为 1
+    m_window.resize(size_t(m_frameLen));
+    for (int i = 0; i < m_frameLen; ++i)
+        m_window[size_t(i)] = float(0.5 - 0.5 * std::cos(2.0 * kPi * i / m_frameLen));
+
+    reset();
+}
+
+void TimeStretcher::setRate(double rate)
+{
+    m_rate = std::clamp(rate, 0.1, 8.0);
+}
+
+void TimeStretcher::reset()
+{
+    // 开头预置 m_hop 帧静音，首段从 -m_hop 开始，第一块输出恰好从输入第 0 帧对齐
+    m_input.assign(size_t(m_hop) * m_channels, 0.0f);
+    m_mono.assign(size_t(m_hop), 0.0f);
+    m_inputStart = -m_hop;
+    m_realEnd = 0;
+
+    m_inPos = double(-m_hop);
+    m_prevPos = 0;
+    m_hasPrev = false;
+
+    m_accum.assign(size_t(m_frameLen) * m_channels, 0.0f);
+    m_output.clear();
+    m_outRead = 0;
+    m_skip = m_hop;
+    m_outFrames = 0;
+    m_outLimit = -1;
+}
+
+void TimeStretcher::push(const float *samples, int frames)
+{
+    if (frames <= 0 || m_channels <= 0) return;
+    m_input.insert(m_input.end(), samples, samples + size_t(frames) * m_channels);
+    size_t base = m_mono.size();
+    m_mono.resize(base + size_t(frames));
+    float scale = 1.0f / m_channels;
+    for (int i = 0; i < frames; ++i) {
+        float sum = 0.0f;
+        for (int c = 0; c < m_channels; ++c) sum += samples[size_t(i) * m_channels + c];
+        m_mono[base + size_t(i)] = sum * scale;
+    }
+    m_realEnd += frames;
+    process();
+}
+
+void TimeStretcher::flush()
+{
+    if (m_channels <= 0 || m_outLimit >= 0) return;
+
+    // 已输出部分对应的输入位置；剩余输入按当前倍速换算成还应输出的帧数
+    double covered = m_hasPrev ? m_inPos - m_hop * m_rate + m_hop : 0.0;
+    double remaining = std::max(0.0, (m_realEnd - covered) / m_rate);
+    m_outLimit = m_outFrames + qint64(std::llround(remaining));
+
+    // 补静音推动最后几段完成
+    std::vector<float> silence(size_t(m_frameLen) * m_channels, 0.0f);
+    int guard = int(remaining * m_rate / m_frameLen) + 4;
+    while (m_outFrames < m_outLimit && guard-- > 0) {
+        qint64 realEnd = m_realEnd;
+        push(silence.data(), m_frameLen);
+        m_realEnd = realEnd;
+    }
+}
+
+int TimeStretcher::available() const
+{
+    return m_channels > 0 ? int((m_output.size() - m_outRead) / size_t(m_channels)) : 0;
+}
+
+int TimeStretcher::read(int16_t *dst, int maxFrames)
+{
+    int frames = std::min(available(), maxFrames);
+    if (frames <= 0) return 0;
+    size_t count = size_t(frames) * m_channels;
+    std::memcpy(dst, m_output.data() + m_outRead, count * sizeof(int16_t));
+    m_outRead += count;
+    if (m_outRead == m_output.size()) {
+        m_output.clear();
+        m_outRead = 0;
+    }
+    return frames;
+}
+
+void TimeStretcher::process()
+{
+    qint64 inputEnd = m_inputStart + qint64(m_mono.size());
+    while (m_outLimit < 0 || m_outFrames < m_outLimit) {
+        qint64 nominal = std::llround(m_inPos);
+        qint64 lo = std::max(nominal - m_search, m_inputStart);
+        qint64 hi = m_hasPrev ? nominal + m_search : nominal;
+        if (hi + m_frameLen > inputEnd) break;
+
+        // 模板是上一段的自然延续：与它最相似的位置拼接后波形连续
+        qint64 pos = m_hasPrev ? bestMatch(m_prevPos + m_hop, lo, hi) : nominal;
+        overlapAdd(pos);
+        m_prevPos = pos;
+        m_hasPrev = true;
+        m_inPos += m_hop * m_rate;
+        compactInput();
+    }
+}
+
+qint64 TimeStretcher::bestMatch(qint64 templatePos, qint64 lo, qint64 hi) const
+{
+    const float *tmpl = m_mono.data() + (templatePos - m_inputStart);
+    qint64 best = lo;
+    float bestScore = -1e30f;
+    auto score = [&](qint64 pos) {
+        float dot, energy;
+        correlate(tmpl, m_mono.data() + (pos - m_inputStart), m_hop, dot, energy);
+        float s = dot / std::sqrt(energy + 1e-9f);
+        if (s > bestScore) {
+            bestScore = s;
+            best = pos;
+        }
+    };
+
+    // 粗搜索网格以模板位置为中心，模板在搜索窗内时（如倍速 1.0）必然被选中
+    qint64 center = std::clamp(templatePos, lo, hi);
+    for (qint64 p = center; p >= lo; p -= kCoarseStep) score(p);
+    for (qint64 p = center + kCoarseStep; p <= hi; p += kCoarseStep) score(p);
+
+    qint64 coarse = best;
+    for (qint64 p = std::max(lo, coarse - kCoarseStep + 1); p <= std::min(hi, coarse + kCoarseStep - 1); ++p) {
+        if (p != coarse) score(p);
+    }
+    return best;
+}
+
+void TimeStretcher::overlapAdd(qint64 pos)
+{
+    const int ch = m_channels;
+    const float *src = m_input.data() + size_t(pos - m_inputStart) * ch;
+    float *acc = m_accum.data();
+    for (int i = 0; i < m_frameLen; ++i) {
+        float w = m_window[size_t(i)];
+        for (int c = 0; c < ch; ++c) acc[i * ch + c] += w * src[i * ch + c];
+    }
+
+    // 前 m_hop 帧已经叠加完整，转换为 s16 输出
+    int frames = m_hop;
+    int offset = 0;
+    if (m_skip > 0) {
+        offset = std::min(m_skip, frames);
+        m_skip -= offset;
+    }
+    int emit = frames - offset;
+    if (m_outLimit >= 0) emit = int(std::min<qint64>(emit, std::max<qint64>(0, m_outLimit - m_outFrames)));
+    if (emit > 0) {
+        size_t base = m_output.size();
+        m_output.resize(base + size_t(emit) * ch);
+        const float *in = acc + size_t(offset) * ch;
+        int16_t *out = m_output.data() + base;
+        for (size_t i = 0; i < size_t(emit) * ch; ++i) {
+            float v = std::clamp(in[i], -1.0f, 1.0f);
+            out[i] = int16_t(std::lrint(v * 32767.0f));
+        }
+        m_outFrames += emit;
+    }
+
+    std::memmove(acc, acc + size_t(m_hop) * ch, size_t(m_frameLen - m_hop) * ch * sizeof(float));
+    std::fill(acc + size_t(m_frameLen - m_hop) * ch, acc + size_t(m_frameLen) * ch, 0.0f);
+}
+
+void TimeStretcher::compactInput()
+{
+    // 保留下一次模板与搜索窗需要的部分，攒够几段再整体前移，摊薄拷贝开销
+    qint64 keep = std::min(m_prevPos + m_hop, std::llround(m_inPos) - m_search);
+    qint64 drop = keep - m_inputStart;
+    if (drop < 4 * qint64(m_frameLen)) return;
+    m_input.erase(m_input.begin(), m_input.begin() + size_t(drop) * m_channels);
+    m_mono.erase(m_mono.begin(), m_mono.begin() + size_t(drop));
+    m_inputStart = keep;
+}
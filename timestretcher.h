@@ -0,0 +1,68 @@
+#ifndef TIMESTRETCHER_H
+#define TIMESTRETCHER_H
+
+#include <QtGlobal>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief 内置 WSOLA 时间伸缩（变速不变调）
+ *
+ * 输入交错 float 样本，输出交错 s16。每段长 20ms、Hann 窗、50% 重叠相加；
+ * 下一段在名义位置 ±10ms 内搜索与上一段自然延续最相似的位置（归一化互相关，
+ * 单声道下混上做 SSE/NEON 向量化，先粗后细两级搜索）。
+ * 单级即可覆盖 0.25x~4x，倍速可随时修改，从下一段开始生效。
+ *
+ * 不是线程安全的，只在解码线程使用。
+ */
+class TimeStretcher
+{
+public:
+    TimeStretcher() = default;
+
+    void configure(int sampleRate, int channels);   // 重新配置并 reset
+    void setRate(double rate);
+    double rate() const { return m_rate; }
+
+    void reset();                                   // seek：丢弃全部缓冲
+    void push(const float *samples, int frames);    // 追加交错 float 输入并处理
+    void flush();                                   // 输入结束：输出剩余样本，之后需 reset
+
+    int available() const;                          // 可取出的输出帧数
+    int read(int16_t *dst, int maxFrames);          // 取出交错 s16，返回帧数
+
+private:
+    void process();
+    qint64 bestMatch(qint64 templatePos, qint64 lo, qint64 hi) const;
+    void overlapAdd(qint64 pos);
+    void compactInput();
+
+    int m_sampleRate = 0;
+    int m_channels = 0;
+    double m_rate = 1.0;
+
+    int m_frameLen = 0;     // 段长 N
+    int m_hop = 0;          // 合成步长 N/2，同时是重叠区长度
+    int m_search = 0;       // 搜索半径
+    std::vector<float> m_window;
+
+    // 输入按绝对帧号索引，m_inputStart 为 m_input 第一帧的帧号（开头预置 m_hop 帧静音）
+    std::vector<float> m_input;     // 交错
+    std::vector<float> m_mono;      // 相关搜索用的单声道下混
+    qint64 m_inputStart = 0;
+    qint64 m_realEnd = 0;           // 真实输入的结束帧号（不含 flush 补的静音）
+
+    double m_inPos = 0.0;           // 下一段的名义输入位置
+    qint64 m_prevPos = 0;           // 上一段实际选取的位置
+    bool m_hasPrev = false;
+
+    std::vector<float> m_accum;     // 重叠相加累加器，N 帧
+    std::vector<int16_t> m_output;  // 已完成的输出
+    size_t m_outRead = 0;
+    int m_skip = 0;                 // 开头静音预置对应的输出，需丢弃
+    qint64 m_outFrames = 0;         // 已产生的输出帧数
+    qint64 m_outLimit = -1;         // flush 后输出总帧数上限
+};
+
+#endif // TIMESTRETCHER_H
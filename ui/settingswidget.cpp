@@ -13,6 +13,8 @@ SettingsWidget::SettingsWidget(QWidget *parent)
             ui->stackedWidget, &QStackedWidget::setCurrentIndex);
 
     playQualityInit();  // 第一项设置初始化
+    decodeInit();       // 第二项设置初始化
+    audioInit();        // 第三项设置初始化
 
     // 如果你在 Designer 已经为 list 添加了 items，它们会存在
     if (ui->listWidget->count() > 0)
@@ -40,3 +42,62 @@ void SettingsWidget::playQualityInit(){
         emit scalingAlgorithmChanged(id); // 只发信号
     });
 }
+
+/**
+ * @brief 设置 2 解码选项
+ */
+void SettingsWidget::decodeInit(){
+    ui->checkBoxGopParallel->setChecked(false);
+
+    connect(ui->checkBoxGopParallel, &QCheckBox::toggled, this, [=](bool checked){
+        emit gopParallelChanged(checked);
+    });
+
+    connect(ui->spinBoxMemoryLimit, &QSpinBox::valueChanged, this, [=](int mb){
+        emit memoryLimitChanged(mb);
+    });
+
+    connect(ui->checkBoxReadAhead, &QCheckBox::toggled, this, [=](bool checked){
+        emit readAheadAlwaysChanged(checked);
+    });
+
+    connect(ui->spinBoxReadAhead, &QSpinBox::valueChanged, this, [=](int mb){
+        emit readAheadWindowChanged(mb);
+    });
+
+    connect(ui->spinBoxRewindCache, &QSpinBox::valueChanged, this, [=](int sec){
+        emit rewindCacheChanged(sec);
+    });
+
+    connect(ui->checkBoxSkipPrefetch, &QCheckBox::toggled, this, [=](bool checked){
+        emit skipPrefetchChanged(checked);
+    });
+
+    ui->comboBoxDeinterlace->setCurrentIndex(1);
+    connect(ui->comboBoxDeinterlace, &QComboBox::currentIndexChanged, this, [=](int index){
+        emit deinterlaceChanged(index);
+    });
+
+    connect(ui->checkBoxAutoRotate, &QCheckBox::toggled, this, [=](bool checked){
+        emit autoRotateChanged(checked);
+    });
+
+    connect(ui->checkBoxAutoCrop, &QCheckBox::toggled, this, [=](bool checked){
+        emit autoCropChanged(checked);
+    });
+}
+
+/**
+ * @brief 设置 3 变速音频引擎
+ */
+void SettingsWidget::audioInit(){
+    ui->comboBoxTimeStretch->setCurrentIndex(0);
+
+    connect(ui->comboBoxTimeStretch, &QComboBox::currentIndexChanged, this, [=](int index){
+        emit timeStretchEngineChanged(index);
+    });
+
+    connect(ui->checkBoxAudioOnly, &QCheckBox::toggled, this, [=](bool checked){
+        emit audioOnlyChanged(checked);
+    });
+}
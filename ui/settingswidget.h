@@ -14,9 +14,22 @@ public:
 
 private:
     void playQualityInit();
+    void decodeInit();
+    void audioInit();
 
 signals:
     void scalingAlgorithmChanged(int algo);
+    void gopParallelChanged(bool enabled);
+    void memoryLimitChanged(int megabytes);
+    void readAheadAlwaysChanged(bool enabled);
+    void readAheadWindowChanged(int megabytes);
+    void rewindCacheChanged(int seconds);
+    void skipPrefetchChanged(bool enabled);
+    void deinterlaceChanged(int mode);
+    void autoRotateChanged(bool enabled);
+    void autoCropChanged(bool enabled);
+    void timeStretchEngineChanged(int engine);
+    void audioOnlyChanged(bool enabled);
 
 private:
     Ui::SettingsWidget *ui;   // ← 必须有
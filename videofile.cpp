@@ -1,4 +1,6 @@
 #include "videofile.h"
+#include "probesnapshot.h"
+#include "mappedfileio.h"
 #include <QFileInfo>
 
 // FFmpeg 头文件
@@ -54,7 +56,13 @@ QDateTime VideoFile::lastChanged() const {
  */
 void VideoFile::Init()
 {
-    AVFormatContext *fmtCtx = nullptr;
+    // 本地文件通过内存映射读取，io 在 avformat_close_input 之后才析构
+    MappedFileIO io;
+    AVFormatContext *fmtCtx = avformat_alloc_context();
+    if (fmtCtx && MappedFileIO::isLocalFile(m_path) && io.open(m_path)) {
+        fmtCtx->pb = io.context();
+        fmtCtx->flags |= AVFMT_FLAG_CUSTOM_IO;
+    }
     if (avformat_open_input(&fmtCtx, m_path.toStdString().c_str(), nullptr, nullptr) != 0) {
         qWarning() << "无法打开视频文件:" << m_path;
         return;
@@ -106,6 +114,8 @@ void VideoFile::Init()
             __channels = par->ch_layout.nb_channels;
         }
     }
+    // 保存探测结果，播放器打开同一文件时可跳过 avformat_find_stream_info
+    ProbeSnapshot::remember(m_path, ProbeSnapshot::capture(fmtCtx, m_path));
     avformat_close_input(&fmtCtx);
 }
 
@@ -0,0 +1,311 @@
+#include "videofilter.h"
+#include <QDebug>
+#include <QStringList>
+#include <QThread>
+#include <algorithm>
+#include <cmath>
+
+extern "C" {
+#include <libavfilter/buffersink.h>
+#include <libavfilter/buffersrc.h>
+#include <libavutil/display.h>
+}
+
+void VideoFilter::Graph::free()
+{
+    if (graph) avfilter_graph_free(&graph);
+    src = nullptr;
+    sink = nullptr;
+    passthrough = true;
+    width = 0;
+    height = 0;
+    format = -1;
+    outTimeBase = AVRational{0, 1};
+    eof = false;
+}
+
+VideoFilter::~VideoFilter()
+{
+    m_main.free();
+    m_still.free();
+}
+
+void VideoFilter::setConfig(const Config &config)
+{
+    if (config.deinterlace == m_config.deinterlace && config.autoRotate == m_config.autoRotate
+        && config.crop == m_config.crop) return;
+    m_config = config;
+    // 下一帧按新配置重建；去隔行滞留的帧随旧图丢弃
+    m_main.free();
+    m_still.free();
+    m_deinterlacing = false;
+    m_discarding = 0;
+}
+
+void VideoFilter::setStreamInfo(const AVStream *st)
+{
+    m_timeBase = st->time_base;
+    m_fieldOrder = st->codecpar->field_order;
+
+    const int32_t *matrix = nullptr;
+#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(60, 31, 102)
+    const AVPacketSideData *sd = av_packet_side_data_get(st->codecpar->coded_side_data,
+                                                         st->codecpar->nb_coded_side_data,
+                                                         AV_PKT_DATA_DISPLAYMATRIX);
+    if (sd && size_t(sd->size) >= 9 * sizeof(int32_t)) matrix = reinterpret_cast<const int32_t*>(sd->data);
+#else
+    matrix = reinterpret_cast<const int32_t*>(av_stream_get_side_data(st, AV_PKT_DATA_DISPLAYMATRIX, nullptr));
+#endif
+    m_streamRotation = matrix ? displayRotation(matrix) : 0.0;
+}
+
+/**
+ * @brief 显示矩阵换算为顺时针旋转角度，归一化到 [0, 360)
+ */
+double VideoFilter::displayRotation(const int32_t *matrix)
+{
+    double theta = -std::round(av_display_rotation_get(matrix));
+    if (std::isnan(theta)) return 0.0;
+    theta -= 360.0 * std::floor(theta / 360.0 + 0.9 / 360.0);
+    return theta;
+}
+
+QSize VideoFilter::outputSize(QSize decoded, const Config &config, double rotation)
+{
+    QSize size = decoded;
+    QRect crop = config.crop.intersected(QRect(QPoint(0, 0), decoded));
+    if (!crop.isEmpty()) size = crop.size();
+    if (config.autoRotate && (std::abs(rotation - 90.0) < 1.0 || std::abs(rotation - 270.0) < 1.0)) size.transpose();
+    return size;
+}
+
+int VideoFilter::filterThreads()
+{
+    // 解码器自己也是多线程，滤镜只用一半核心
+    return std::clamp(QThread::idealThreadCount() / 2, 1, 8);
+}
+
+double VideoFilter::frameRotation(const AVFrame *in) const
+{
+    if (!m_config.autoRotate) return 0.0;
+    // 帧上的显示矩阵（来自 SEI 或由解码器转发的流信息）优先于流级别的
+    if (const AVFrameSideData *sd = av_frame_get_side_data(in, AV_FRAME_DATA_DISPLAYMATRIX)) {
+        if (size_t(sd->size) >= 9 * sizeof(int32_t)) return displayRotation(reinterpret_cast<const int32_t*>(sd->data));
+    }
+    return m_streamRotation;
+}
+
+bool VideoFilter::wantsDeinterlace(const AVFrame *in) const
+{
+    switch (m_config.deinterlace) {
+    case DeinterlaceAlways:
+        return true;
+    case DeinterlaceAuto: {
+#if LIBAVUTIL_VERSION_INT >= AV_VERSION_INT(58, 7, 100)
+        bool interlaced = in->flags & AV_FRAME_FLAG_INTERLACED;
+#else
+        bool interlaced = in->interlaced_frame;
+#endif
+        return interlaced || m_fieldOrder == AV_FIELD_TT || m_fieldOrder == AV_FIELD_BB
+               || m_fieldOrder == AV_FIELD_TB || m_fieldOrder == AV_FIELD_BT;
+    }
+    default:
+        return false;
+    }
+}
+
+bool VideoFilter::matches(const Graph &g, const AVFrame *in, bool deinterlace) const
+{
+    return !g.eof && g.width == in->width && g.height == in->height && g.format == in->format
+           && av_cmp_q(g.sar, in->sample_aspect_ratio) == 0 && g.deinterlace == deinterlace
+           && std::abs(g.rotation - frameRotation(in)) < 0.5;
+}
+
+/**
+ * @brief 滤镜链：先去隔行（必须在原始场结构上进行），再在解码尺寸下裁剪，最后旋转
+ */
+QString VideoFilter::describe(const AVFrame *in, bool deinterlace, double rotation) const
+{
+    QStringList chain;
+    if (deinterlace) {
+        // bwdif 画质更好，旧版本 FFmpeg 没有时退回 yadif；send_frame 保持帧率，
+        // 但输出时间基是输入的一半，pts 在 toStreamTimeBase 中换回
+        const char *name = avfilter_get_by_name("bwdif") ? "bwdif" : "yadif";
+        chain << QString("%1=mode=send_frame:parity=auto:deint=%2")
+                     .arg(name, m_config.deinterlace == DeinterlaceAlways ? "all" : "interlaced");
+    }
+
+    QRect crop = m_config.crop.intersected(QRect(0, 0, in->width, in->height));
+    if (!crop.isEmpty() && crop.size() != QSize(in->width, in->height)) {
+        chain << QString("crop=%1:%2:%3:%4").arg(crop.width()).arg(crop.height()).arg(crop.x()).arg(crop.y());
+    }
+
+    if (std::abs(rotation - 90.0) < 1.0) {
+        chain << "transpose=clock";
+    } else if (std::abs(rotation - 180.0) < 1.0) {
+        chain << "hflip" << "vflip";
+    } else if (std::abs(rotation - 270.0) < 1.0) {
+        chain << "transpose=cclock";
+    } else if (std::abs(rotation) > 1.0) {
+        chain << QString("rotate=%1*PI/180").arg(rotation, 0, 'f', 3);
+    }
+    return chain.join(',');
+}
+
+/**
+ * @brief 按帧的格式建图；不需要任何滤镜或建图失败时标记为直通，同样的输入不再重试
+ */
+void VideoFilter::build(Graph &g, const AVFrame *in, bool deinterlace)
+{
+    g.free();
+    g.width = in->width;
+    g.height = in->height;
+    g.format = in->format;
+    g.sar = in->sample_aspect_ratio;
+    g.deinterlace = deinterlace;
+    g.rotation = frameRotation(in);
+
+    const QString desc = describe(in, deinterlace, g.rotation);
+    if (desc.isEmpty()) return;
+
+    auto fail = [&](const char *what, int ret) {
+        char errbuf[128]; av_strerror(ret, errbuf, sizeof(errbuf));
+        qWarning() << "Video filter" << what << "failed:" << errbuf << ", desc:" << desc;
+        if (g.graph) avfilter_graph_free(&g.graph);
+        g.src = nullptr;
+        g.sink = nullptr;
+    };
+
+    g.graph = avfilter_graph_alloc();
+    if (!g.graph) return;
+    // 去隔行等支持 slice 线程的滤镜按行分片并行
+    g.graph->nb_threads = filterThreads();
+    g.graph->thread_type = AVFILTER_THREAD_SLICE;
+
+    AVRational sar = g.sar.num > 0 ? g.sar : AVRational{1, 1};
+    char args[256];
+    snprintf(args, sizeof(args), "video_size=%dx%d:pix_fmt=%d:time_base=%d/%d:pixel_aspect=%d/%d",
+             in->width, in->height, in->format, m_timeBase.num, m_timeBase.den, sar.num, sar.den);
+
+    int ret = avfilter_graph_create_filter(&g.src, avfilter_get_by_name("buffer"), "in", args, nullptr, g.graph);
+    if (ret < 0) return fail("buffer", ret);
+    ret = avfilter_graph_create_filter(&g.sink, avfilter_get_by_name("buffersink"), "out", nullptr, nullptr, g.graph);
+    if (ret < 0) return fail("buffersink", ret);
+
+    AVFilterInOut *outputs = avfilter_inout_alloc();
+    AVFilterInOut *inputs = avfilter_inout_alloc();
+    if (!inputs || !outputs) {
+        avfilter_inout_free(&inputs);
+        avfilter_inout_free(&outputs);
+        return fail("inout alloc", AVERROR(ENOMEM));
+    }
+    outputs->name = av_strdup("in");
+    outputs->filter_ctx = g.src;
+    outputs->pad_idx = 0;
+    outputs->next = nullptr;
+    inputs->name = av_strdup("out");
+    inputs->filter_ctx = g.sink;
+    inputs->pad_idx = 0;
+    inputs->next = nullptr;
+
+    ret = avfilter_graph_parse_ptr(g.graph, desc.toUtf8().constData(), &inputs, &outputs, nullptr);
+    avfilter_inout_free(&inputs);
+    avfilter_inout_free(&outputs);
+    if (ret < 0) return fail("parse", ret);
+    ret = avfilter_graph_config(g.graph, nullptr);
+    if (ret < 0) return fail("config", ret);
+
+    g.outTimeBase = av_buffersink_get_time_base(g.sink);
+    g.passthrough = false;
+    qDebug() << "Video filter:" << desc << "threads" << g.graph->nb_threads;
+}
+
+bool VideoFilter::push(const AVFrame *in)
+{
+    // 自动去隔行：遇到第一帧隔行画面后保持开启，混合内容不会来回重建
+    const bool deinterlace = (m_config.deinterlace == DeinterlaceAuto && m_deinterlacing) || wantsDeinterlace(in);
+    if (!matches(m_main, in, deinterlace)) {
+        build(m_main, in, deinterlace);
+        m_deinterlacing = deinterlace && !m_main.passthrough;
+        m_resync = false;
+        m_discarding = 0;
+    }
+    if (m_main.passthrough) return false;
+
+    if (m_resync) {
+        m_resync = false;
+        m_resyncPts = in->pts;
+        m_discarding = m_deinterlacing && in->pts != AV_NOPTS_VALUE ? MAX_DISCARD : 0;
+    }
+
+    // 保留调用者的引用：解码循环复用同一个 AVFrame
+    int ret = av_buffersrc_add_frame_flags(m_main.src, const_cast<AVFrame*>(in), AV_BUFFERSRC_FLAG_KEEP_REF);
+    if (ret < 0) {
+        char errbuf[128]; av_strerror(ret, errbuf, sizeof(errbuf));
+        qWarning() << "Error feeding video filter:" << errbuf;
+        return false;
+    }
+    return true;
+}
+
+AVFrame *VideoFilter::pull()
+{
+    if (m_main.passthrough || !m_main.sink) return nullptr;
+    AVFrame *out = av_frame_alloc();
+    if (!out) return nullptr;
+    while (av_buffersink_get_frame(m_main.sink, out) >= 0) {
+        toStreamTimeBase(m_main, out);
+        // seek 前滞留在去隔行滤镜中的帧
+        if (m_discarding > 0) {
+            if (out->pts != m_resyncPts) {
+                --m_discarding;
+                av_frame_unref(out);
+                continue;
+            }
+            m_discarding = 0;
+        }
+        return out;
+    }
+    av_frame_free(&out);
+    return nullptr;
+}
+
+void VideoFilter::reset()
+{
+    // 只有去隔行会跨帧滞留；旋转与裁剪一进一出，不需要处理
+    if (m_deinterlacing && !m_main.passthrough) m_resync = true;
+}
+
+void VideoFilter::flush()
+{
+    if (m_main.passthrough || m_main.eof || !m_main.src) return;
+    av_buffersrc_add_frame_flags(m_main.src, nullptr, 0);
+    m_main.eof = true;
+    m_resync = false;
+    m_discarding = 0;
+}
+
+AVFrame *VideoFilter::filterStill(const AVFrame *in)
+{
+    if (!matches(m_still, in, false)) build(m_still, in, false);
+    if (m_still.passthrough) return nullptr;
+    if (av_buffersrc_add_frame_flags(m_still.src, const_cast<AVFrame*>(in), AV_BUFFERSRC_FLAG_KEEP_REF) < 0) return nullptr;
+    AVFrame *out = av_frame_alloc();
+    if (out && av_buffersink_get_frame(m_still.sink, out) >= 0) {
+        toStreamTimeBase(m_still, out);
+        return out;
+    }
+    av_frame_free(&out);
+    return nullptr;
+}
+
+/**
+ * @brief 解码循环、快退缓存与 seek 丢帧比较都按流时间基解释 pts
+ */
+void VideoFilter::toStreamTimeBase(const Graph &g, AVFrame *out) const
+{
+    if (g.outTimeBase.num <= 0 || av_cmp_q(g.outTimeBase, m_timeBase) == 0 || out->pts == AV_NOPTS_VALUE) return;
+    out->pts = av_rescale_q(out->pts, g.outTimeBase, m_timeBase);
+    // best_effort_timestamp 由 av_frame_copy_props 原样带过滤镜，仍是输入时间基，与 pts 保持一致即可
+    out->best_effort_timestamp = out->pts;
+}
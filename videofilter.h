@@ -0,0 +1,96 @@
+#ifndef VIDEOFILTER_H
+#define VIDEOFILTER_H
+
+#include <QRect>
+#include <QSize>
+#include <QString>
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavfilter/avfilter.h>
+}
+
+/**
+ * @brief 解码与缩放之间的视频滤镜阶段：去隔行、按显示矩阵自动旋转、裁剪
+ *
+ * 用到的滤镜都关闭时不建图，帧原样交给缩放器。连续播放的帧走完整滤镜链（bwdif/yadif 启用
+ * slice 多线程，输出比输入晚一帧）；逐帧、拖动预览、快进等不连续的帧走只含旋转与裁剪的
+ * 无状态滤镜链，一进一出。滤镜图只在配置或输入格式变化、文件尾冲洗后重建，
+ * seek 时调用 reset()，去隔行滞留的旧位置的帧在输出端丢弃。只在解码线程使用。
+ */
+class VideoFilter
+{
+public:
+    enum Deinterlace { DeinterlaceOff = 0, DeinterlaceAuto = 1, DeinterlaceAlways = 2 };
+
+    struct Config {
+        int deinterlace = DeinterlaceAuto;  // 自动：流或帧标记为隔行时才插入去隔行滤镜
+        bool autoRotate = true;
+        QRect crop;                         // 解码尺寸下的裁剪区域，空为不裁剪
+    };
+
+    VideoFilter() = default;
+    ~VideoFilter();
+    VideoFilter(const VideoFilter &) = delete;
+    VideoFilter &operator=(const VideoFilter &) = delete;
+
+    void setConfig(const Config &config);
+    Config config() const { return m_config; }
+    void setStreamInfo(const AVStream *st);     // 打开文件后调用：时间基、场序与显示矩阵
+
+    // 连续播放：push 之后用 pull 取出全部输出，调用者负责 av_frame_free；
+    // 不需要滤镜或送入失败时返回 false，调用者直接显示原帧
+    bool push(const AVFrame *in);
+    AVFrame *pull();
+    void reset();                               // seek：丢弃去隔行滞留的旧帧，不重建滤镜图
+    void flush();                               // 文件尾：冲出滞留的帧，之后的 push 重建滤镜图
+
+    // 不连续的单帧：只做旋转与裁剪，不需要时返回 nullptr（直接使用 in）
+    AVFrame *filterStill(const AVFrame *in);
+
+    // 静态旋转角度（度，顺时针 0/90/180/270，其他角度按任意角旋转）
+    double streamRotation() const { return m_streamRotation; }
+    static double displayRotation(const int32_t *matrix);
+    // 滤镜输出的尺寸（不含帧级旋转信息），供界面按显示比例计算渲染尺寸
+    static QSize outputSize(QSize decoded, const Config &config, double rotation);
+
+private:
+    struct Graph {
+        AVFilterGraph *graph = nullptr;
+        AVFilterContext *src = nullptr;
+        AVFilterContext *sink = nullptr;
+        bool passthrough = true;            // 没有需要的滤镜
+        int width = 0, height = 0, format = -1;
+        AVRational sar{0, 1};
+        bool deinterlace = false;
+        double rotation = 0.0;
+        AVRational outTimeBase{0, 1};       // buffersink 的时间基，去隔行滤镜会把它减半
+        bool eof = false;
+        void free();
+    };
+
+    bool matches(const Graph &g, const AVFrame *in, bool deinterlace) const;
+    void build(Graph &g, const AVFrame *in, bool deinterlace);
+    QString describe(const AVFrame *in, bool deinterlace, double rotation) const;
+    bool wantsDeinterlace(const AVFrame *in) const;
+    double frameRotation(const AVFrame *in) const;
+    void toStreamTimeBase(const Graph &g, AVFrame *out) const;     // 输出时间戳换回流时间基
+    static int filterThreads();
+
+    // seek 后去隔行输出的前一帧属于旧位置：丢弃直到输出 pts 与 seek 后第一个输入相同
+    static constexpr int MAX_DISCARD = 4;
+
+    Config m_config;
+    AVRational m_timeBase{1, 25};
+    AVFieldOrder m_fieldOrder = AV_FIELD_UNKNOWN;
+    double m_streamRotation = 0.0;
+
+    Graph m_main;                           // 连续播放
+    Graph m_still;                          // 单帧，无去隔行
+    bool m_deinterlacing = false;           // m_main 中插入了去隔行滤镜
+    bool m_resync = false;                  // reset() 之后尚未送入新帧
+    int64_t m_resyncPts = AV_NOPTS_VALUE;
+    int m_discarding = 0;                   // 还允许丢弃的输出帧数
+};
+
+#endif // VIDEOFILTER_H
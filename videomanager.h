@@ -21,9 +21,21 @@ public:
     int getVideoListSize() const;
 
     int selected = -1;  //表示当前选中播放的行下标
-    const QList<double> speedList = {0.25,0.5,0.75,1.0,1.25,1.5,2.0,3.0};   //播放速度表
+    //播放速度表，8x 及以上为仅关键帧快进，负数为快退
+    const QList<double> speedList = {0.25,0.5,0.75,1.0,1.25,1.5,2.0,3.0,8.0,16.0,32.0,-8.0,-16.0,-32.0};
     double playSpeed = 1.0; //当前播放速度，默认一倍速
     int m_scalingAlgo = 1;  //当前缩放算法选择,默认平衡算法为1
+    bool m_gopParallel = false; //是否启用 GOP 并行解码
+    int m_memoryLimitMB = 256;  //播放器缓冲内存上限（MB）
+    bool m_readAheadAlways = false; //本地文件是否也使用预读 I/O（机械硬盘）
+    int m_readAheadMB = 32;     //预读窗口（MB）
+    int m_rewindCacheSec = 6;   //快退缓存保留的秒数，0 为关闭
+    bool m_skipPrefetch = true; //是否提前解码 +10 秒处的画面（预判快进）
+    int m_deinterlace = 1;      //去隔行，0 关闭，1 自动，2 始终
+    bool m_autoRotate = true;   //是否按旋转信息自动旋转画面
+    bool m_autoCrop = true;     //是否自动裁掉黑边
+    int m_stretchEngine = 0;    //变速音频引擎，0 为 atempo，1 为 WSOLA
+    bool m_audioOnly = false;   //仅播放音频，不解码视频
 
 signals:
     void videosUpdated(); // 当列表更新时通知 UI
@@ -2,7 +2,11 @@
 #include <QThread>
 #include <QMutexLocker>
 #include <QDebug>
+#include <QDir>
+#include <QFileInfo>
 #include <cmath>
+#include <algorithm>
+#include <memory>
 
 // ---------------- constructor / destructor ----------------
 VideoPlayer::VideoPlayer(QObject *parent)
@@ -11,43 +15,123 @@ VideoPlayer::VideoPlayer(QObject *parent)
     av_log_set_level(AV_LOG_QUIET);
     // 在新版 FFmpeg 中一般不再需要显式注册，但调用无害
     // avfilter_register_all();
+    m_reaper.setMaxThreadCount(1);
+
+    m_scrubTimer = new QTimer(this);
+    m_scrubTimer->setSingleShot(true);
+    connect(m_scrubTimer, &QTimer::timeout, this, [this]() {
+        if (m_scrubbing && m_scrubTarget != m_scrubSent) sendScrub();
+    });
+
+    m_positionTimer = new QTimer(this);
+    m_positionTimer->setInterval(int(POSITION_INTERVAL_SEC * 1000));
+    connect(m_positionTimer, &QTimer::timeout, this, [this]() {
+        if (m_session && m_session->thread && !m_paused.load()) emit positionChanged(currentPosition());
+    });
 }
 
 VideoPlayer::~VideoPlayer()
 {
     stop();
+    // 等待已取消的打开线程退出（中断回调使其很快返回）
+    for (QThread *t : m_openThreads) {
+        t->wait();
+        delete t;
+    }
+    m_openThreads.clear();
+    // 旧解码线程可能仍在访问 this，必须等回收完成
+    m_reaper.waitForDone();
+}
+
+// ---------------- MediaSession ----------------
+VideoPlayer::MediaSession::MediaSession()
+    : exited(exitPromise.get_future().share())
+{
+}
+
+VideoPlayer::MediaSession::~MediaSession()
+{
+    requestStop();
+    if (thread) {
+        thread->wait();
+        delete thread;
+    }
+    demuxer.reset();
+    if (packet) av_packet_free(&packet);
+    if (frame) av_frame_free(&frame);
+    if (audioFrame) av_frame_free(&audioFrame);
+    if (filteredFrame) av_frame_free(&filteredFrame);
+    if (swsCtx) sws_freeContext(swsCtx);
+    if (audioFilterGraph) avfilter_graph_free(&audioFilterGraph);
+    if (codecCtx) avcodec_free_context(&codecCtx);
+    if (audioCodecCtx) avcodec_free_context(&audioCodecCtx);
+    if (subtitleCodecCtx) avcodec_free_context(&subtitleCodecCtx);
+    for (AVPacket *p : deferredAudio) av_packet_free(&p);
+    if (fmtCtx) avformat_close_input(&fmtCtx);
+}
+
+void VideoPlayer::MediaSession::requestStop()
+{
+    QMutexLocker locker(&m_wakeMutex);
+    stop.store(true);
+    m_wakeCond.wakeAll();
+    // 唤醒阻塞在 takeFrame 的解码线程
+    if (m_gop) m_gop->reset();
+}
+
+void VideoPlayer::MediaSession::sleepFor(int ms)
+{
+    QMutexLocker locker(&m_wakeMutex);
+    if (!stop.load()) m_wakeCond.wait(&m_wakeMutex, ms);
+}
+
+void VideoPlayer::MediaSession::waitForCommand()
+{
+    // 命令先入队再 wake()，这里持锁检查队列，不会丢失唤醒
+    QMutexLocker locker(&m_wakeMutex);
+    while (!stop.load() && commands.empty()) m_wakeCond.wait(&m_wakeMutex);
+}
+
+void VideoPlayer::MediaSession::wake()
+{
+    QMutexLocker locker(&m_wakeMutex);
+    m_wakeCond.wakeAll();
+}
+
+void VideoPlayer::MediaSession::setGopDecoder(GopParallelDecoder *gop)
+{
+    QMutexLocker locker(&m_wakeMutex);
+    m_gop = gop;
 }
 
 // ---------------- helpers ----------------
-double VideoPlayer::videoPtsToSeconds(AVFrame *vframe)
+double VideoPlayer::videoPtsToSeconds(const MediaSession &s, AVFrame *vframe)
 {
-    if (!vframe || videoStreamIndex < 0 || !fmtCtx) return 0.0;
-    AVRational tb = fmtCtx->streams[videoStreamIndex]->time_base;
+    if (!vframe || s.videoStreamIndex < 0 || !s.fmtCtx) return 0.0;
+    AVRational tb = s.fmtCtx->streams[s.videoStreamIndex]->time_base;
     if (vframe->pts != AV_NOPTS_VALUE) return vframe->pts * av_q2d(tb);
     if (vframe->best_effort_timestamp != AV_NOPTS_VALUE) return vframe->best_effort_timestamp * av_q2d(tb);
     return 0.0;
 }
 
 // ---------------- audio filter init / cleanup ----------------
-bool VideoPlayer::initAudioFilter(double rate)
+bool VideoPlayer::initAudioFilter(MediaSession &s, double rate)
 {
-    // 必须在调用之前持有 m_audioFilterMutex
-    if (audioFilterGraph) {
-        avfilter_graph_free(&audioFilterGraph);
-        audioFilterGraph = nullptr;
-        audioBufferSrcCtx = nullptr;
-        audioBufferSinkCtx = nullptr;
-    }
+    // 只在解码线程调用
+    cleanupAudioFilter(s);
+    s.audioFilterEof = false;
 
-    if (!audioCodecCtx) {
+    if (!s.audioCodecCtx) {
         qWarning() << "No audio codec context";
         return false;
     }
 
     if (rate <= 0.0) rate = 1.0;
+    s.audioFilterRate = rate;   // 失败时也记录，避免每个包都重试
+    s.audioFilterEngine = s.stretchEngine;
 
-    audioFilterGraph = avfilter_graph_alloc();
-    if (!audioFilterGraph) {
+    s.audioFilterGraph = avfilter_graph_alloc();
+    if (!s.audioFilterGraph) {
         qWarning() << "Failed to allocate audio filter graph";
         return false;
     }
@@ -56,63 +140,61 @@ bool VideoPlayer::initAudioFilter(double rate)
     const AVFilter *abuffersink = avfilter_get_by_name("abuffersink");
     if (!abuffer || !abuffersink) {
         qWarning() << "Audio filters (abuffer/abuffersink) not found";
-        cleanupAudioFilter();
+        cleanupAudioFilter(s);
         return false;
     }
 
     // prepare abuffer args: sample_fmt name, sample_rate, channel_layout, time_base
     char channel_layout_str[128];
-    av_channel_layout_describe(&audioCodecCtx->ch_layout, channel_layout_str, sizeof(channel_layout_str));
+    av_channel_layout_describe(&s.audioCodecCtx->ch_layout, channel_layout_str, sizeof(channel_layout_str));
 
     char args[512];
     // Use audioTimeBase (from stream) and codec sample info
     snprintf(args, sizeof(args),
              "time_base=%d/%d:sample_rate=%d:sample_fmt=%s:channel_layout=%s",
-             audioTimeBase.num, audioTimeBase.den,
-             audioCodecCtx->sample_rate,
-             av_get_sample_fmt_name(audioCodecCtx->sample_fmt),
+             s.audioTimeBase.num, s.audioTimeBase.den,
+             s.audioCodecCtx->sample_rate,
+             av_get_sample_fmt_name(s.audioCodecCtx->sample_fmt),
              channel_layout_str);
 
-    int ret = avfilter_graph_create_filter(&audioBufferSrcCtx, abuffer, "in", args, nullptr, audioFilterGraph);
+    int ret = avfilter_graph_create_filter(&s.audioBufferSrcCtx, abuffer, "in", args, nullptr, s.audioFilterGraph);
     if (ret < 0) {
         char errbuf[128]; av_strerror(ret, errbuf, sizeof(errbuf));
         qWarning() << "avfilter_graph_create_filter abuffer failed:" << errbuf;
-        cleanupAudioFilter();
+        cleanupAudioFilter(s);
         return false;
     }
 
-    ret = avfilter_graph_create_filter(&audioBufferSinkCtx, abuffersink, "out", nullptr, nullptr, audioFilterGraph);
+    ret = avfilter_graph_create_filter(&s.audioBufferSinkCtx, abuffersink, "out", nullptr, nullptr, s.audioFilterGraph);
     if (ret < 0) {
         char errbuf[128]; av_strerror(ret, errbuf, sizeof(errbuf));
         qWarning() << "avfilter_graph_create_filter abuffersink failed:" << errbuf;
-        cleanupAudioFilter();
+        cleanupAudioFilter(s);
         return false;
     }
 
-    // build atempo chain with aformat to force s16 stereo at original sample rate
     QString filterDesc;
-    double remaining = rate;
+    if (s.audioFilterEngine == StretchWsola) {
+        // WSOLA 引擎：filter 只负责转换为 float 立体声，变速由 TimeStretcher 单级完成
+        filterDesc = QString("aformat=sample_fmts=flt:channel_layouts=stereo:sample_rates=%1")
+                         .arg(s.audioOutRate);
+        s.stretcher.configure(s.audioOutRate, 2);
+        s.stretcher.setRate(rate);
+        s.stretchOut.resize(4096 * 2);
+    } else {
+        // build a fixed atempo chain with aformat to force s16 stereo at original sample rate.
+        // 级数固定、实例具名，变速时只需 avfilter_graph_send_command 修改 tempo，无需重建
+        double tempo[AUDIO_TEMPO_STAGES];
+        splitTempo(rate, tempo);
+        for (int i = 0; i < AUDIO_TEMPO_STAGES; ++i) {
+            if (!filterDesc.isEmpty()) filterDesc += ",";
+            filterDesc += QString("atempo@tempo%1=tempo=%2").arg(i).arg(tempo[i], 0, 'f', 6);
+        }
 
-    // atempo supports 0.5..2.0; chain multiple filters as needed
-    while (remaining > 2.0 + 1e-6) {
-        if (!filterDesc.isEmpty()) filterDesc += ",";
-        filterDesc += "atempo=2.0";
-        remaining /= 2.0;
-    }
-    while (remaining < 0.5 - 1e-6) {
-        if (!filterDesc.isEmpty()) filterDesc += ",";
-        filterDesc += "atempo=0.5";
-        remaining /= 0.5;
+        // force output to s16, stereo, and the output sample rate
+        filterDesc += QString(",aformat=sample_fmts=s16:channel_layouts=stereo:sample_rates=%1")
+                          .arg(s.audioOutRate);
     }
-    if (std::abs(remaining - 1.0) > 0.01) {
-        if (!filterDesc.isEmpty()) filterDesc += ",";
-        filterDesc += QString("atempo=%1").arg(remaining, 0, 'f', 6);
-    }
-    if (filterDesc.isEmpty()) filterDesc = "anull";
-
-    // force output to s16, stereo, and original sample rate
-    filterDesc += QString(",aformat=sample_fmts=s16:channel_layouts=stereo:sample_rates=%1")
-                      .arg(audioCodecCtx->sample_rate);
 
     qDebug() << "initAudioFilter desc:" << filterDesc;
 
@@ -122,21 +204,21 @@ bool VideoPlayer::initAudioFilter(double rate)
         qWarning() << "failed to alloc filter inputs/outputs";
         avfilter_inout_free(&inputs);
         avfilter_inout_free(&outputs);
-        cleanupAudioFilter();
+        cleanupAudioFilter(s);
         return false;
     }
 
     outputs->name = av_strdup("in");
-    outputs->filter_ctx = audioBufferSrcCtx;
+    outputs->filter_ctx = s.audioBufferSrcCtx;
     outputs->pad_idx = 0;
     outputs->next = nullptr;
 
     inputs->name = av_strdup("out");
-    inputs->filter_ctx = audioBufferSinkCtx;
+    inputs->filter_ctx = s.audioBufferSinkCtx;
     inputs->pad_idx = 0;
     inputs->next = nullptr;
 
-    ret = avfilter_graph_parse_ptr(audioFilterGraph, filterDesc.toUtf8().constData(), &inputs, &outputs, nullptr);
+    ret = avfilter_graph_parse_ptr(s.audioFilterGraph, filterDesc.toUtf8().constData(), &inputs, &outputs, nullptr);
 
     avfilter_inout_free(&inputs);
     avfilter_inout_free(&outputs);
@@ -144,245 +226,860 @@ bool VideoPlayer::initAudioFilter(double rate)
     if (ret < 0) {
         char errbuf[128]; av_strerror(ret, errbuf, sizeof(errbuf));
         qWarning() << "avfilter_graph_parse_ptr failed:" << errbuf;
-        cleanupAudioFilter();
+        cleanupAudioFilter(s);
         return false;
     }
 
-    ret = avfilter_graph_config(audioFilterGraph, nullptr);
+    ret = avfilter_graph_config(s.audioFilterGraph, nullptr);
     if (ret < 0) {
         char errbuf[128]; av_strerror(ret, errbuf, sizeof(errbuf));
         qWarning() << "avfilter_graph_config failed:" << errbuf;
-        cleanupAudioFilter();
+        cleanupAudioFilter(s);
         return false;
     }
 
-    // after graph configured, output will be s16/stereo at codec sample rate
-    m_audioSampleRate = audioCodecCtx->sample_rate;
-    m_audioOutChannels = 2;
+    // 输出固定为 audioOutRate 的立体声；主线程的声卡参数在 installMedia/startAudioOutput 中设置
+    return true;
+}
+
+/**
+ * @brief 把倍速拆到固定的几级 atempo 上：每级限制在 [0.5, 2.0]，覆盖 0.25x~4x
+ */
+void VideoPlayer::splitTempo(double rate, double (&tempo)[AUDIO_TEMPO_STAGES])
+{
+    double remaining = rate;
+    for (int i = 0; i < AUDIO_TEMPO_STAGES; ++i) {
+        double t = std::clamp(remaining, 0.5, 2.0);
+        tempo[i] = t;
+        remaining /= t;
+    }
+}
+
+/**
+ * @brief 运行时修改现有 atempo 链的速率，保留 filter 内部缓冲，切换无断音
+ */
+bool VideoPlayer::setAudioFilterTempo(MediaSession &s, double rate)
+{
+    if (!s.audioFilterGraph) return false;
+    if (std::abs(s.audioFilterRate - rate) < 1e-6) return true;
+    if (s.audioFilterEngine == StretchWsola) {
+        s.stretcher.setRate(rate);
+        s.audioFilterRate = rate;
+        return true;
+    }
 
+    double tempo[AUDIO_TEMPO_STAGES];
+    splitTempo(rate, tempo);
+    for (int i = 0; i < AUDIO_TEMPO_STAGES; ++i) {
+        char target[16];
+        char arg[32];
+        char res[128] = {0};
+        snprintf(target, sizeof(target), "tempo%d", i);
+        snprintf(arg, sizeof(arg), "%.6f", tempo[i]);
+        int ret = avfilter_graph_send_command(s.audioFilterGraph, target, "tempo", arg, res, sizeof(res), 0);
+        if (ret < 0) {
+            char errbuf[128]; av_strerror(ret, errbuf, sizeof(errbuf));
+            qWarning() << "atempo send_command failed:" << errbuf;
+            return false;
+        }
+    }
+    s.audioFilterRate = rate;
     return true;
 }
 
-void VideoPlayer::cleanupAudioFilter()
+/**
+ * @brief seek 后复用 filter：丢弃已经可以取出的旧输出
+ */
+void VideoPlayer::flushAudioFilter(MediaSession &s)
+{
+    if (!s.audioBufferSinkCtx) return;
+    AVFrame *f = av_frame_alloc();
+    while (av_buffersink_get_frame(s.audioBufferSinkCtx, f) >= 0) av_frame_unref(f);
+    av_frame_free(&f);
+    if (s.audioFilterEngine == StretchWsola) s.stretcher.reset();
+}
+
+/**
+ * @brief 把一帧解码音频送入 filter，取出全部输出直接拷入 PCM 环形缓冲。
+ * in 为 nullptr 时冲洗 filter（之后 buffersrc 关闭，seek 时需重建）
+ */
+void VideoPlayer::filterAudioFrame(MediaSession &s, AVFrame *in)
+{
+    if (!s.audioBufferSrcCtx || !s.audioBufferSinkCtx) {
+        if (in) av_frame_unref(in);
+        return;
+    }
+
+    double apts = -1.0;
+    if (in) {
+        if (in->pts != AV_NOPTS_VALUE)
+            apts = in->pts * av_q2d(s.audioTimeBase);
+        else if (in->best_effort_timestamp != AV_NOPTS_VALUE)
+            apts = in->best_effort_timestamp * av_q2d(s.audioTimeBase);
+    }
+
+    // 缓存帧回放：视频从缓存帧的位置开始计时，早于它的音频直接丢弃
+    if (in && s.audioSyncPending && apts >= 0.0) {
+        if (apts < trickTargetPos(s)) {
+            av_frame_unref(in);
+            return;
+        }
+        s.audioSyncPending = false;
+    }
+
+    // 不保留引用：buffersrc 接管 in 的数据并把它重置为空帧，可直接用于下一次解码
+    int ret = av_buffersrc_add_frame_flags(s.audioBufferSrcCtx, in, 0);
+    if (ret < 0) {
+        char errbuf[128]; av_strerror(ret, errbuf, sizeof(errbuf));
+        qWarning() << "Error feeding audio filter:" << errbuf;
+        if (in) av_frame_unref(in);
+        return;
+    }
+
+    // 已有更新的 seek/停止：这批输出已过期，不再入队
+    auto writePcm = [&](const uint8_t *data, int bytes) {
+        if (bytes <= 0 || !data || s.outputSerial != m_flushSerial.load()) return;
+        // 先记账再入队：主线程取出或丢弃后才释放，记账始终不小于缓冲中的实际字节数
+        m_memory.acquire(MemoryBudget::AudioPcm, bytes);
+        m_audioRing.write(data, bytes, s.outputSerial);
+
+        if (apts >= 0.0 && m_audioBasePts.load() < 0.0) {
+            m_audioBasePts.store(apts);
+            m_audioPlayedSamples.store(0);
+            qDebug() << "Audio base PTS set to:" << apts;
+        }
+    };
+    // WSOLA：取出已完成的 s16 立体声输出
+    const bool wsola = s.audioFilterEngine == StretchWsola;
+    auto drainStretcher = [&]() {
+        int frames;
+        while ((frames = s.stretcher.read(s.stretchOut.data(), int(s.stretchOut.size() / 2))) > 0)
+            writePcm(reinterpret_cast<const uint8_t*>(s.stretchOut.data()), frames * 2 * int(sizeof(int16_t)));
+    };
+
+    AVFrame *out = s.filteredFrame;
+    while (av_buffersink_get_frame(s.audioBufferSinkCtx, out) >= 0) {
+        if (wsola) {
+            // aformat 保证交错 float 立体声
+            if (out->data[0]) s.stretcher.push(reinterpret_cast<const float*>(out->data[0]), out->nb_samples);
+            drainStretcher();
+            av_frame_unref(out);
+            continue;
+        }
+
+        int outChannels = 0;
+#if LIBAVUTIL_VERSION_INT >= AV_VERSION_INT(57, 17, 0)
+        outChannels = out->ch_layout.nb_channels;
+#else
+        outChannels = out->nb_channels;
+#endif
+        if (outChannels <= 0) outChannels = 2;     // filter 输出固定为立体声
+
+        int bytes = av_samples_get_buffer_size(nullptr, outChannels, out->nb_samples, AV_SAMPLE_FMT_S16, 1);
+        writePcm(out->data[0], bytes);
+        av_frame_unref(out);
+    }
+
+    // 文件尾：WSOLA 中剩余的样本一并写出
+    if (!in && wsola) {
+        s.stretcher.flush();
+        drainStretcher();
+    }
+}
+
+void VideoPlayer::cleanupAudioFilter(MediaSession &s)
 {
-    // 必须持有 m_audioFilterMutex
-    if (audioFilterGraph) {
-        avfilter_graph_free(&audioFilterGraph);
-        audioFilterGraph = nullptr;
-        audioBufferSrcCtx = nullptr;
-        audioBufferSinkCtx = nullptr;
+    if (s.audioFilterGraph) {
+        avfilter_graph_free(&s.audioFilterGraph);
+        s.audioFilterGraph = nullptr;
+        s.audioBufferSrcCtx = nullptr;
+        s.audioBufferSinkCtx = nullptr;
     }
 }
 
 // ---------------- openFile ----------------
-bool VideoPlayer::openFile(const QString &filePath)
+int VideoPlayer::interruptCallback(void *opaque)
 {
-    m_filePath = filePath;
-    stop();
+    auto *session = static_cast<MediaSession*>(opaque);
+    if (!session) return 0;
+    // 网络流有 seek 等待时打断阻塞的读取，让读取线程尽快执行 seek
+    return session->stop.load() || (session->demuxer && session->demuxer->interruptRequested()) ? 1 : 0;
+}
+
+int VideoPlayer::readInput(MediaSession &s, AVPacket *pkt, bool honorWatermarks)
+{
+    return s.demuxer ? s.demuxer->read(pkt, honorWatermarks) : av_read_frame(s.fmtCtx, pkt);
+}
+
+int VideoPlayer::seekInput(MediaSession &s, int streamIndex, int64_t ts, int flags)
+{
+    return s.demuxer ? s.demuxer->seek(streamIndex, ts, flags) : av_seek_frame(s.fmtCtx, streamIndex, ts, flags);
+}
+
+/**
+ * @brief 打开文件、探测流并打开解码器；只操作 s，不访问播放器成员，可在工作线程执行
+ */
+bool VideoPlayer::openMedia(MediaSession &s)
+{
+    const QString &filePath = s.path;
+
+    s.fmtCtx = avformat_alloc_context();
+    if (!s.fmtCtx) return false;
+    // 阻塞的 open/probe/read 会周期性回调，stop 置位后立即返回 AVERROR_EXIT
+    s.fmtCtx->interrupt_callback.callback = &VideoPlayer::interruptCallback;
+    s.fmtCtx->interrupt_callback.opaque = &s;
+
+    // 本地文件走内存映射 I/O；网络挂载和机械硬盘改用预读线程，缺页不会阻塞解码线程。
+    // 都打开失败时退回 FFmpeg 自带的 file 协议。URL 由 FFmpeg 的网络协议读取，连接断开时自动重连
+    AVDictionary *openOpts = nullptr;
+    s.network = NetworkDemuxer::isNetworkUrl(filePath);
+    if (s.network) {
+        openOpts = NetworkDemuxer::openOptions();
+    } else if (MappedFileIO::isLocalFile(filePath)) {
+        if (s.readAheadAlways || PrefetchIO::throttled() || PrefetchIO::isNetworkPath(filePath)) {
+            auto prefetch = std::make_unique<PrefetchIO>();
+            if (prefetch->open(filePath, s.readAheadMB, s.fmtCtx->interrupt_callback)) {
+                s.fmtCtx->pb = prefetch->context();
+                s.fmtCtx->flags |= AVFMT_FLAG_CUSTOM_IO;
+                s.prefetch = std::move(prefetch);
+            }
+        }
+        if (!s.prefetch) {
+            auto io = std::make_unique<MappedFileIO>();
+            if (io->open(filePath)) {
+                s.fmtCtx->pb = io->context();
+                s.fmtCtx->flags |= AVFMT_FLAG_CUSTOM_IO;
+                s.io = std::move(io);
+            }
+        }
+    }
 
-    if (avformat_open_input(&fmtCtx, filePath.toStdString().c_str(), nullptr, nullptr) < 0) {
+    int openRet = avformat_open_input(&s.fmtCtx, filePath.toStdString().c_str(), nullptr, &openOpts);
+    av_dict_free(&openOpts);
+    if (openRet < 0) {
         qWarning() << "无法打开视频文件:" << filePath;
         return false;
     }
-    if (avformat_find_stream_info(fmtCtx, nullptr) < 0) {
-        qWarning() << "无法读取流信息";
-        avformat_close_input(&fmtCtx);
-        fmtCtx = nullptr;
-        return false;
+    s.trace.mark("open");
+    // 列表加载时已探测过的文件直接套用快照；快照过期或流布局不一致时完整探测
+    std::shared_ptr<const ProbeSnapshot> snapshot = ProbeSnapshot::lookup(filePath);
+    s.probeReused = snapshot && snapshot->applyTo(s.fmtCtx);
+    if (!s.probeReused) {
+        if (snapshot) qDebug() << "Probe snapshot mismatch, probing" << filePath;
+        if (avformat_find_stream_info(s.fmtCtx, nullptr) < 0) {
+            qWarning() << "无法读取流信息";
+            return false;
+        }
     }
-
-    videoStreamIndex = -1;
-    audioStreamIndex = -1;
-    for (unsigned i = 0; i < fmtCtx->nb_streams; ++i) {
-        AVCodecParameters *p = fmtCtx->streams[i]->codecpar;
-        if (p->codec_type == AVMEDIA_TYPE_VIDEO && videoStreamIndex < 0) videoStreamIndex = int(i);
-        if (p->codec_type == AVMEDIA_TYPE_AUDIO && audioStreamIndex < 0) audioStreamIndex = int(i);
+    s.trace.mark(s.probeReused ? "probe(snapshot)" : "probe");
+
+    AVFormatContext *fmt = s.fmtCtx;
+    for (unsigned i = 0; i < fmt->nb_streams; ++i) {
+        const AVStream *st = fmt->streams[i];
+        AVCodecParameters *p = st->codecpar;
+        if (p->codec_type == AVMEDIA_TYPE_VIDEO && s.videoStreamIndex < 0) s.videoStreamIndex = int(i);
+        if (p->codec_type == AVMEDIA_TYPE_AUDIO) {
+            if (s.audioStreamIndex < 0) s.audioStreamIndex = int(i);
+            AudioTrack track;
+            track.streamIndex = int(i);
+            if (AVDictionaryEntry *e = av_dict_get(st->metadata, "language", nullptr, 0)) track.language = QString::fromUtf8(e->value);
+            if (AVDictionaryEntry *e = av_dict_get(st->metadata, "title", nullptr, 0)) track.title = QString::fromUtf8(e->value);
+            track.codec = QString::fromLatin1(avcodec_get_name(p->codec_id));
+            track.channels = p->ch_layout.nb_channels;
+            track.sampleRate = p->sample_rate;
+            s.audioTracks.append(track);
+        }
+        if (p->codec_type == AVMEDIA_TYPE_SUBTITLE) {
+            SubtitleStream sub;
+            sub.streamIndex = int(i);
+            if (AVDictionaryEntry *e = av_dict_get(st->metadata, "language", nullptr, 0)) sub.language = QString::fromUtf8(e->value);
+            if (AVDictionaryEntry *e = av_dict_get(st->metadata, "title", nullptr, 0)) sub.title = QString::fromUtf8(e->value);
+            sub.codec = QString::fromLatin1(avcodec_get_name(p->codec_id));
+            s.subtitleStreams.append(sub);
+        }
     }
-    if (videoStreamIndex < 0) {
+    if (s.videoStreamIndex < 0) {
         qWarning() << "没有找到视频流";
-        avformat_close_input(&fmtCtx);
-        fmtCtx = nullptr;
         return false;
     }
 
-    // 视频解码上下文
-    {
-        AVCodecParameters *vpar = fmtCtx->streams[videoStreamIndex]->codecpar;
+    // 视频解码上下文；套用快照后仍打不开说明快照不可信，完整探测后重试一次
+    for (;;) {
+        AVCodecParameters *vpar = fmt->streams[s.videoStreamIndex]->codecpar;
         const AVCodec *vcodec = avcodec_find_decoder(vpar->codec_id);
         if (!vcodec) { qWarning() << "未找到视频解码器"; return false; }
-        codecCtx = avcodec_alloc_context3(vcodec);
-        if (!codecCtx) { qWarning() << "无法分配视频 codecCtx"; return false; }
-        if (avcodec_parameters_to_context(codecCtx, vpar) < 0) {
-            qWarning() << "avcodec_parameters_to_context fail";
+        s.codecCtx = avcodec_alloc_context3(vcodec);
+        if (!s.codecCtx) { qWarning() << "无法分配视频 codecCtx"; return false; }
+        if (avcodec_parameters_to_context(s.codecCtx, vpar) >= 0 && avcodec_open2(s.codecCtx, vcodec, nullptr) >= 0) break;
+
+        avcodec_free_context(&s.codecCtx);
+        if (!s.probeReused) {
+            qWarning() << "视频解码器打开失败";
             return false;
         }
-        if (avcodec_open2(codecCtx, vcodec, nullptr) < 0) {
-            qWarning() << "视频解码器打开失败";
+        qDebug() << "Decoder rejected probe snapshot, probing" << filePath;
+        ProbeSnapshot::forget(filePath);
+        s.probeReused = false;
+        if (avformat_find_stream_info(fmt, nullptr) < 0) {
+            qWarning() << "无法读取流信息";
             return false;
         }
-        videoTimeBase = fmtCtx->streams[videoStreamIndex]->time_base;
-    }
-
-    // 音频解码上下文
-    if (audioStreamIndex >= 0) {
-        AVCodecParameters *apar = fmtCtx->streams[audioStreamIndex]->codecpar;
-        const AVCodec *acodec = avcodec_find_decoder(apar->codec_id);
-        if (acodec) {
-            audioCodecCtx = avcodec_alloc_context3(acodec);
-            if (audioCodecCtx && avcodec_parameters_to_context(audioCodecCtx, apar) >= 0) {
-                if (avcodec_open2(audioCodecCtx, acodec, nullptr) < 0) {
-                    qWarning() << "音频解码器打开失败，忽略音频";
-                    avcodec_free_context(&audioCodecCtx);
-                    audioCodecCtx = nullptr;
-                    audioStreamIndex = -1;
-                } else {
-                    audioTimeBase = fmtCtx->streams[audioStreamIndex]->time_base;
-                }
-            } else {
-                if (audioCodecCtx) avcodec_free_context(&audioCodecCtx);
-                audioCodecCtx = nullptr;
-                audioStreamIndex = -1;
+    }
+
+    // 音频解码上下文（失败时忽略音频）
+    if (s.audioStreamIndex >= 0) {
+        s.audioCodecCtx = openAudioDecoder(fmt->streams[s.audioStreamIndex]);
+        if (!s.audioCodecCtx) {
+            qWarning() << "音频解码器打开失败，忽略音频";
+            s.audioStreamIndex = -1;
+        }
+    }
+
+    s.videoTimeBase = fmt->streams[s.videoStreamIndex]->time_base;
+    s.videoFilter.setStreamInfo(fmt->streams[s.videoStreamIndex]);
+    s.videoRotation = s.videoFilter.streamRotation();
+    if (s.audioStreamIndex >= 0) {
+        s.audioTimeBase = fmt->streams[s.audioStreamIndex]->time_base;
+        s.audioOutRate = s.audioCodecCtx->sample_rate;
+    }
+
+    // 字幕：优先同名外挂字幕，其次标记为默认/强制的嵌入字幕流，否则不显示
+    QString sidecar = s.network ? QString() : findSidecarSubtitle(filePath);
+    if (!sidecar.isEmpty()) {
+        auto track = std::make_shared<SubtitleTrack>();
+        if (track->loadFile(sidecar)) {
+            s.externalSubtitle = track;
+            s.subtitles = track;
+            s.subtitleSelection = SUBTITLE_EXTERNAL;
+        }
+    }
+    if (!s.subtitles) {
+        for (const SubtitleStream &sub : s.subtitleStreams) {
+            int disposition = fmt->streams[sub.streamIndex]->disposition;
+            if ((disposition & (AV_DISPOSITION_DEFAULT | AV_DISPOSITION_FORCED)) && openSubtitleStream(s, sub.streamIndex)) {
+                s.subtitleSelection = sub.streamIndex;
+                break;
             }
-        } else {
-            audioStreamIndex = -1;
         }
     }
+    applyStreamDiscard(s);
+    if (s.network) s.demuxer = std::make_unique<NetworkDemuxer>(fmt, bufferReferenceStream(s), s.stop);
+    s.trace.mark("codecs");
+    s.frame = av_frame_alloc();
+    s.packet = av_packet_alloc();
+    s.audioFrame = av_frame_alloc();
+    s.filteredFrame = av_frame_alloc();
+    return s.frame && s.packet && s.audioFrame && s.filteredFrame;
+}
+
+AVCodecContext *VideoPlayer::openAudioDecoder(const AVStream *st)
+{
+    const AVCodec *acodec = avcodec_find_decoder(st->codecpar->codec_id);
+    if (!acodec) return nullptr;
+    AVCodecContext *ctx = avcodec_alloc_context3(acodec);
+    if (!ctx) return nullptr;
+    if (avcodec_parameters_to_context(ctx, st->codecpar) < 0 || avcodec_open2(ctx, acodec, nullptr) < 0) {
+        avcodec_free_context(&ctx);
+        return nullptr;
+    }
+    return ctx;
+}
+
+/**
+ * @brief 未使用的流（其他音轨、字幕、附件、数据流）标记 AVDISCARD_ALL，
+ * 解复用器直接跳过这些包，不再分配和返回。
+ * 网络流的 av_read_frame 在解复用线程中进行，discard 与缓冲参考流都交给它在两次读取之间修改
+ */
+void VideoPlayer::applyStreamDiscard(MediaSession &s)
+{
+    const bool videoUsed = !videoDiscarded(s);
+    std::vector<AVDiscard> discard(s.fmtCtx->nb_streams);
+    for (unsigned i = 0; i < s.fmtCtx->nb_streams; ++i) {
+        bool used = (int(i) == s.videoStreamIndex && videoUsed) || int(i) == s.audioStreamIndex
+                    || int(i) == s.subtitleStreamIndex;
+        discard[i] = used ? AVDISCARD_DEFAULT : AVDISCARD_ALL;
+    }
+    if (s.demuxer) {
+        s.demuxer->setStreamDiscard(discard);
+        s.demuxer->setReferenceStream(bufferReferenceStream(s));
+        return;
+    }
+    for (unsigned i = 0; i < s.fmtCtx->nb_streams; ++i) s.fmtCtx->streams[i]->discard = discard[i];
+}
+
+/**
+ * @brief 网络缓冲量按哪个流计算：视频被丢弃（纯音频）或没有视频时用音轨
+ */
+int VideoPlayer::bufferReferenceStream(const MediaSession &s)
+{
+    return videoDiscarded(s) || s.videoStreamIndex < 0 ? s.audioStreamIndex : s.videoStreamIndex;
+}
+
+/**
+ * @brief 纯音频模式且有音轨可播时丢弃视频流；快进/快退模式只靠关键帧画面，仍需要视频
+ */
+bool VideoPlayer::videoDiscarded(const MediaSession &s)
+{
+    return s.videoOutput == VideoOff && s.audioCodecCtx && !isTrickRate(s.playRate);
+}
+
+/**
+ * @brief 打开嵌入字幕流的解码器并新建字幕轨；ASS 流的样式表来自 subtitle_header
+ */
+bool VideoPlayer::openSubtitleStream(MediaSession &s, int streamIndex)
+{
+    const AVStream *st = s.fmtCtx->streams[streamIndex];
+    const AVCodec *codec = avcodec_find_decoder(st->codecpar->codec_id);
+    if (!codec) return false;
+    AVCodecContext *ctx = avcodec_alloc_context3(codec);
+    if (!ctx) return false;
+    ctx->pkt_timebase = st->time_base;
+    if (avcodec_parameters_to_context(ctx, st->codecpar) < 0 || avcodec_open2(ctx, codec, nullptr) < 0) {
+        avcodec_free_context(&ctx);
+        return false;
+    }
+
+    auto track = std::make_shared<SubtitleTrack>();
+    if (ctx->subtitle_header && ctx->subtitle_header_size > 0) {
+        track->parseAssHeader(QByteArray(reinterpret_cast<const char*>(ctx->subtitle_header), ctx->subtitle_header_size));
+    }
+    // 位图字幕的坐标以字幕流尺寸为准，缺省时由渲染器按视频尺寸换算
+    if (ctx->width > 0 && ctx->height > 0) track->setCanvasSize(QSize(ctx->width, ctx->height));
+
+    if (s.subtitleCodecCtx) avcodec_free_context(&s.subtitleCodecCtx);
+    s.subtitleCodecCtx = ctx;
+    s.subtitleStreamIndex = streamIndex;
+    s.subtitles = track;
+    return true;
+}
+
+/**
+ * @brief 视频旁同名的 .ass/.ssa/.srt，其次是 "视频名.语言.srt" 形式
+ */
+QString VideoPlayer::findSidecarSubtitle(const QString &videoPath)
+{
+    QFileInfo info(videoPath);
+    if (!info.exists()) return QString();
+    QDir dir = info.absoluteDir();
+    const QString base = info.completeBaseName();
+    const QStringList suffixes{"ass", "ssa", "srt"};
+    for (const QString &suffix : suffixes) {
+        QString candidate = dir.filePath(base + "." + suffix);
+        if (QFileInfo::exists(candidate)) return candidate;
+    }
+    QStringList patterns;
+    for (const QString &suffix : suffixes) patterns << base + ".*." + suffix;
+    const QStringList found = dir.entryList(patterns, QDir::Files, QDir::Name);
+    return found.isEmpty() ? QString() : dir.filePath(found.first());
+}
 
-    frame = av_frame_alloc();
-    packet = av_packet_alloc();
+/**
+ * @brief 把 openMedia 的结果设为当前文件（主线程）
+ */
+void VideoPlayer::installMedia(const std::shared_ptr<MediaSession> &s)
+{
+    m_session = s;
 
     m_audioBasePts.store(-1.0);
     m_audioPlayedSamples.store(0);
-    {
-        QMutexLocker locker(&m_audioQueueMutex);
-        m_audioQueue.clear();
-    }
+    clearAudioQueue();
+    m_memory.resetHighWater();
+
+    m_lastPresentedPts.store(0.0);
+
+    // 新文件开始新的输出序号，旧会话残留的帧、PCM 与通知随之作废；
+    // 主线程保存的设置作为解码线程的初始状态（线程启动前写入）
+    quint64 serial = m_commandSeq.fetch_add(1) + 1;
+    m_flushSerial.store(serial);
+    s->outputSerial = serial;
+    s->playRate = m_playRate;
+    s->renderWidth = m_renderWidth;
+    s->renderHeight = m_renderHeight;
+    s->scalingAlgo = m_scalingAlgo;
+    s->stretchEngine = m_stretchEngine;
+    s->videoOutput = m_videoOutput;
+    m_audioSampleRate = s->audioOutRate > 0 ? s->audioOutRate : 48000;
+    m_audioOutChannels = 2;
+    m_autoCropRect = QRect();
+    s->videoFilter.setConfig(effectiveFilterConfig());
+    m_audioTrack = s->audioStreamIndex;
+    m_subtitle = s->subtitleSelection;
+    m_externalSubtitle = s->externalSubtitle;
+    m_externalSubtitleName = s->externalSubtitle ? s->externalSubtitle->name() : QString();
+}
+
+/**
+ * @brief 旧会话交给回收线程：等待其解码线程退出，再关闭解码器和文件
+ */
+void VideoPlayer::reap(std::shared_ptr<MediaSession> s)
+{
+    if (!s) return;
+    s->requestStop();
+    m_reaper.start([s = std::move(s)]() mutable { s.reset(); });
+}
+
+bool VideoPlayer::openFile(const QString &filePath)
+{
+    auto s = std::make_shared<MediaSession>();
+    s->trace.start();
+    m_filePath = filePath;
+    stop();
+    s->trace.mark("stop");
 
-    m_finished.store(false);
-    m_seekRequested.store(false);
-    m_playStarted = false;
-    m_totalPausedMs.store(0);
-    m_pauseStartMs = 0;
+    s->path = filePath;
+    s->readAheadAlways = m_readAheadAlways;
+    s->readAheadMB = m_readAheadMB;
+    if (!openMedia(*s)) {
+        reap(s);
+        return false;
+    }
 
+    installMedia(s);
+    s->trace.mark("install");
     return true;
 }
 
+/**
+ * @brief 异步打开：探测在工作线程进行，主线程不阻塞；完成后发出 openFinished。
+ * 再次调用或 stop() 会通过中断回调取消尚未完成的请求。
+ */
+void VideoPlayer::openFileAsync(const QString &filePath)
+{
+    auto req = std::make_shared<OpenRequest>();
+    req->session = std::make_shared<MediaSession>();
+    req->session->trace.start();
+    m_filePath = filePath;
+    stop();     // 同时取消上一次未完成的打开
+    req->session->trace.mark("stop");
+
+    req->session->path = filePath;
+    req->session->readAheadAlways = m_readAheadAlways;
+    req->session->readAheadMB = m_readAheadMB;
+    m_pendingOpen = req;
+
+    QThread *t = QThread::create([req]() { req->ok = openMedia(*req->session); });
+    m_openThreads.append(t);
+    // finished 在工作线程发出，以 this 为上下文排队回到主线程处理
+    connect(t, &QThread::finished, this, [this, t, req]() {
+        m_openThreads.removeOne(t);
+        t->deleteLater();
+        if (req != m_pendingOpen || !req->ok) {
+            // 已被取消、被新请求取代或打开失败：资源交给回收线程
+            reap(std::move(req->session));
+            if (req != m_pendingOpen) return;
+        }
+        m_pendingOpen.reset();
+
+        if (req->ok) {
+            installMedia(req->session);
+            req->session->trace.mark("install");
+        }
+        emit openFinished(req->ok, m_filePath);
+    });
+    t->start();
+}
+
+void VideoPlayer::cancelOpen()
+{
+    if (!m_pendingOpen) return;
+    m_pendingOpen->session->requestStop();
+    m_pendingOpen.reset();
+}
+
+// ---------------- commands ----------------
+/**
+ * @brief 投递控制命令（主线程），返回命令序号；没有打开的文件时丢弃
+ */
+quint64 VideoPlayer::post(PlayerCommand cmd)
+{
+    if (!m_session) return 0;
+    cmd.seq = m_commandSeq.fetch_add(1) + 1;
+    // 先更新作废序号再入队：解码线程执行到该命令之前产生的输出都会被丢弃
+    if (cmd.flushesOutput()) m_flushSerial.store(cmd.seq);
+    m_session->commands.push(cmd);
+    m_session->wake();
+    return cmd.seq;
+}
+
+/**
+ * @brief 解码线程的检查点：按投递顺序执行全部命令，seek 只记录目标，由 decodeLoop 执行
+ */
+void VideoPlayer::drainCommands(MediaSession &s)
+{
+    PlayerCommand cmd;
+    while (s.commands.pop(cmd)) {
+        switch (cmd.type) {
+        case PlayerCommand::Play:
+            if (s.playStarted && s.pauseStartMs > 0) {
+                qint64 pausedMs = s.playTimer.elapsed() - s.pauseStartMs;
+                if (pausedMs > 0) s.totalPausedMs += pausedMs;
+            }
+            s.pauseStartMs = 0;
+            s.paused = false;
+            // 逐帧时只解码了视频：从停住的帧重新 seek，让音频和解码器重新对齐（之后又有 seek 时以它为准）
+            if (s.stepped) {
+                s.stepped = false;
+                clearStepWindow(s);
+                if (!s.seekPending) {
+                    s.seekPending = true;
+                    s.seekTarget = s.lastPts;
+                    s.seekResume = true;
+                }
+            }
+            break;
+        case PlayerCommand::Pause:
+            if (!s.paused) s.pauseStartMs = s.playStarted ? s.playTimer.elapsed() : 0;
+            s.paused = true;
+            break;
+        case PlayerCommand::Seek:
+            s.seekPending = true;
+            s.seekTarget = cmd.value;
+            s.seekResume = false;
+            s.seekExact = cmd.width != 0;
+            s.scrubbing = false;            // 松开进度条时的定位同时结束预览
+            s.scrubPending = false;
+            s.scrubKeyPts = AV_NOPTS_VALUE;
+            s.outputSerial = cmd.seq;
+            break;
+        case PlayerCommand::SetRate: {
+            // 从当前位置重新建立时间基，保证速率切换时视频等待平滑
+            double pos = s.lastPts >= 0.0 ? s.lastPts : s.playStartPts;
+            s.playRate = cmd.value;
+            s.playStartPts = pos;
+            s.playTimer.restart();
+            s.totalPausedMs = 0;
+            s.pauseStartMs = s.paused ? s.playTimer.elapsed() : 0;
+            s.playStarted = true;
+            break;
+        }
+        case PlayerCommand::Resize:
+            s.renderWidth = cmd.width;
+            s.renderHeight = cmd.height;
+            s.swsNeedReset = true;
+            m_rewindCache.clear();      // 缓存帧是按旧尺寸缩放的
+            break;
+        case PlayerCommand::ScalingAlgorithm:
+            s.scalingAlgo = cmd.width;
+            s.swsNeedReset = true;
+            break;
+        case PlayerCommand::TimeStretchEngine:
+            s.stretchEngine = cmd.width;    // decodeLoop 发现与当前 filter 不一致时重建
+            break;
+        case PlayerCommand::AudioTrack:
+            s.audioTrackRequest = cmd.width;
+            break;
+        case PlayerCommand::Subtitle:
+            s.subtitleRequestPending = true;
+            s.subtitleRequest = cmd.width;
+            s.subtitleRequestTrack = cmd.subtitle;
+            break;
+        case PlayerCommand::StepFrame:
+            s.stepRequest = std::clamp(s.stepRequest + cmd.width, -STEP_MAX_PENDING, STEP_MAX_PENDING);
+            s.outputSerial = cmd.seq;
+            break;
+        case PlayerCommand::Scrub:
+            s.scrubbing = true;
+            s.scrubPending = true;          // 只保留最新的预览位置
+            s.scrubTarget = cmd.value;
+            s.outputSerial = cmd.seq;
+            break;
+        case PlayerCommand::VideoOutput: {
+            const bool wasDiscarded = videoDiscarded(s);
+            s.videoOutput = cmd.width;
+            // 不可见期间没有缓存画面，快退缓存不再连续
+            if (s.videoOutput != VideoVisible) m_rewindCache.clear();
+            if (videoDiscarded(s) != wasDiscarded) applyStreamDiscard(s);
+            if (videoDiscarded(s)) s.fastStart = false;     // 不会再有首帧，暂存的音频立即解码
+            break;
+        }
+        case PlayerCommand::VideoFilter:
+            s.videoFilter.setConfig({cmd.width, cmd.height != 0, cmd.rect});
+            m_rewindCache.clear();      // 缓存帧是按旧的旋转/裁剪输出的
+            break;
+        }
+    }
+}
+
 // ---------------- play / pause / stop / seek ----------------
 void VideoPlayer::play()
 {
-    if (!fmtCtx || !codecCtx) return;
+    if (!m_session) return;
 
-    if (m_decodeThread) {
-        if (m_playStarted && m_pauseStartMs > 0) {
-            qint64 now = m_playTimer.elapsed();
-            qint64 pausedMs = now - m_pauseStartMs;
-            if (pausedMs > 0) m_totalPausedMs.fetch_add(pausedMs);
-            m_pauseStartMs = 0;
-        }
+    m_paused.store(false);
+    post({PlayerCommand::Play});
 
-        m_paused.store(false);
-        if (audioSink) audioSink->resume();
+    if (m_session->thread) {
+        if (m_audioOutputPending) startAudioOutput();
+        if (m_audioFlushTimer) m_audioFlushTimer->start();
+        if (audioSink && !m_trickPlay && !m_buffering) audioSink->resume();
         emit playingChanged(true);
         return;
     }
 
-    m_paused.store(false);
-    m_stopRequested.store(false);
     m_playing.store(true);
     emit playingChanged(true);
 
-    // 创建音频输出
-    if (audioStreamIndex >= 0 && audioCodecCtx) {
-        if (!m_audioFlushTimer) {
-            m_audioFlushTimer = new QTimer(this);
-            m_audioFlushTimer->setInterval(20);     // 刷新间隔
-            connect(m_audioFlushTimer, &QTimer::timeout, this, &VideoPlayer::flushAudioBuffer);
-            m_audioFlushTimer->start();
-        }
+    // 快速起播：先启动解码线程，声卡输出（创建 QAudioSink 可能要几十毫秒）推迟到首帧显示之后；
+    // 首帧迟迟不到时由定时器兜底
+    if (m_session->audioStreamIndex >= 0 && m_session->audioCodecCtx) {
+        m_audioOutputPending = true;
+        m_firstFrameClock.invalidate();
+        m_audioBasePts.store(-1.0);
+        m_audioPlayedSamples.store(0);
+        QTimer::singleShot(FAST_START_AUDIO_TIMEOUT_MS, this, [this]() {
+            if (m_audioOutputPending) startAudioOutput();
+        });
+    }
 
-        if (audioSink) {
-            audioSink->stop();
-            delete audioSink;
-            audioSink = nullptr;
-            audioIODevice = nullptr;
-        }
+    // 上一个文件的解码线程已被唤醒、很快退出；新线程先等它退出再开始，
+    // 而旧文件的解码器/文件关闭仍在回收线程中并行进行
+    MediaSession *s = m_session.get();
+    std::shared_future<void> prevExit = m_prevDecodeExit;
+    s->thread = QThread::create([this, s, prevExit]() {
+        if (prevExit.valid()) prevExit.wait();
+        if (!s->stop.load()) decodeLoop(*s);
+        s->exitPromise.set_value();
+    });
+    m_prevDecodeExit = s->exited;
+    s->thread->start();
+    s->trace.mark("play");
+}
 
-        // 初始化 audio filter（首次）
-        {
-            QMutexLocker filterLocker(&m_audioFilterMutex);
-            cleanupAudioFilter();
-            if (!initAudioFilter(m_playRate.load())) {
-                qWarning() << "Failed to initialize audio filter";
-            }
-        }
+/**
+ * @brief 创建声卡输出并开始从环形缓冲取 PCM（主线程）。
+ * 首帧显示后才创建时，跳过这段时间内本应已播出的 PCM，保持音画同步
+ */
+void VideoPlayer::startAudioOutput()
+{
+    m_audioOutputPending = false;
+    if (!m_session || m_session->audioStreamIndex < 0) return;
 
-        QAudioFormat fmt;
-        fmt.setSampleRate(audioCodecCtx->sample_rate);
-        fmt.setChannelCount(2);
-        fmt.setSampleFormat(QAudioFormat::Int16);
+    QElapsedTimer clock;
+    clock.start();
 
-        QAudioDevice device = QMediaDevices::defaultAudioOutput();
+    if (!m_audioFlushTimer) {
+        m_audioFlushTimer = new QTimer(this);
+        m_audioFlushTimer->setInterval(20);     // 刷新间隔
+        connect(m_audioFlushTimer, &QTimer::timeout, this, &VideoPlayer::flushAudioBuffer);
+    }
 
-        if (!device.isFormatSupported(fmt)) {
-            qWarning() << "Requested audio format not supported, trying fallback.";
-            fmt.setSampleRate(48000);
-            if (!device.isFormatSupported(fmt)) {
-                fmt.setSampleRate(44100);
-            }
-        }
+    if (audioSink) {
+        audioSink->stop();
+        delete audioSink;
+        audioSink = nullptr;
+        audioIODevice = nullptr;
+    }
 
-        audioSink = new QAudioSink(device, fmt, this);
-        audioIODevice = audioSink->start();
-        if (!audioIODevice) {
-            qWarning() << "audioSink start failed";
-            delete audioSink;
-            audioSink = nullptr;
-            audioIODevice = nullptr;
-        } else {
-            m_audioSampleRate = fmt.sampleRate();
-            m_audioOutChannels = fmt.channelCount();
+    QAudioFormat fmt;
+    fmt.setSampleRate(m_session->audioOutRate);
+    fmt.setChannelCount(2);
+    fmt.setSampleFormat(QAudioFormat::Int16);
+
+    QAudioDevice device = QMediaDevices::defaultAudioOutput();
+
+    if (!device.isFormatSupported(fmt)) {
+        qWarning() << "Requested audio format not supported, trying fallback.";
+        fmt.setSampleRate(48000);
+        if (!device.isFormatSupported(fmt)) {
+            fmt.setSampleRate(44100);
         }
+    }
 
-        m_audioBasePts.store(-1.0);
-        m_audioPlayedSamples.store(0);
+    audioSink = new QAudioSink(device, fmt, this);
+    audioIODevice = audioSink->start();
+    if (!audioIODevice) {
+        qWarning() << "audioSink start failed";
+        delete audioSink;
+        audioSink = nullptr;
+        audioIODevice = nullptr;
+        return;
+    }
+    m_audioSampleRate = fmt.sampleRate();
+    m_audioOutChannels = fmt.channelCount();
+    if (m_trickPlay || m_paused.load() || m_buffering) audioSink->suspend();   // 快进模式静音
+
+    // 画面已经走了一段：丢掉这段时间对应的 PCM，并计入已播放样本
+    if (m_firstFrameClock.isValid() && !m_trickPlay && !m_paused.load()) {
+        int frameBytes = 2 * m_audioOutChannels;
+        qint64 lateFrames = m_firstFrameClock.elapsed() * m_session->audioOutRate / 1000;
+        qint64 skipped = m_audioRing.skip(lateFrames * frameBytes);
+        m_memory.release(MemoryBudget::AudioPcm, skipped);
+        m_audioPlayedSamples.fetch_add(skipped / frameBytes);
     }
 
-    m_playStarted = false;
-    m_totalPausedMs.store(0);
-    m_pauseStartMs = 0;
-    m_decodeThread = QThread::create([this]() { decodeLoop(); });
-    m_decodeThread->start();
+    if (!m_paused.load()) m_audioFlushTimer->start();
+    qDebug() << "Audio output ready in" << clock.elapsed() << "ms";
 }
 
 void VideoPlayer::pause()
 {
-    if (m_playStarted) {
-        m_pauseStartMs = m_playTimer.elapsed();
-    } else {
-        m_pauseStartMs = 0;
-    }
-
     m_paused.store(true);
+    post({PlayerCommand::Pause});
+    // 暂停期间不再周期性唤醒主线程
+    if (m_audioFlushTimer) m_audioFlushTimer->stop();
     if (audioSink) audioSink->suspend();
     emit playingChanged(false);
 }
 
+void VideoPlayer::onPlaybackFinished(quint64 serial)
+{
+    // 之后又有 seek/换文件时，这是过期的通知
+    if (serial != m_flushSerial.load()) return;
+    pause();
+    emit finished();
+}
+
+/**
+ * @brief 停止播放，立即返回：解码线程被唤醒后自行退出，
+ * 解码器/文件的关闭在回收线程中完成，不阻塞主线程
+ */
 void VideoPlayer::stop()
 {
-    m_stopRequested.store(true);
+    cancelOpen();
     m_paused.store(false);
     m_playing.store(false);
-    m_finished.store(false);
-    m_seekRequested.store(false);
+    // 旧会话仍在途的帧、PCM 与通知全部作废
+    m_flushSerial.store(m_commandSeq.fetch_add(1) + 1);
 
     emit playingChanged(false);
 
-    if (m_decodeThread) {
-        m_decodeThread->quit();
-        m_decodeThread->wait();
-        delete m_decodeThread;
-        m_decodeThread = nullptr;
+    if (m_session) {
+        if (m_session->thread) {
+            qDebug().noquote() << m_memory.report();   // 各缓冲队列的高水位
+            DemuxStats d = demuxStats();
+            qDebug() << "Demux: packets" << d.packetBytesPerSec / 1024 << "KB/s, I/O" << d.ioBytesPerSec / 1024
+                     << "KB/s, streams" << d.activeStreams << "/" << d.totalStreams;
+            if (m_session->io) {
+                MappedFileIO::Stats io = m_session->io->stats();
+                qDebug() << "Mapped I/O: reads" << io.reads << "bytes" << io.bytes / 1024 << "KB, seeks" << io.seeks
+                         << ", maps" << io.remaps;
+            }
+            if (m_session->prefetch) {
+                PrefetchIO::Stats io = m_session->prefetch->stats();
+                qDebug() << "Read-ahead I/O: stalls" << io.stalls << "(" << io.stallUs / 1000 << "ms ), disk reads"
+                         << io.diskReads << "bytes" << io.diskBytes / 1024 << "KB, retargets" << io.retargets;
+            }
+            if (m_session->demuxer) {
+                qDebug() << "Network: buffered" << d.bufferedSec << "s, rebuffers" << d.rebuffers
+                         << ", reconnects" << d.reconnects;
+            }
+        }
+        reap(std::move(m_session));
     }
+    m_audioOutputPending = false;
+    if (m_buffering) {
+        m_buffering = false;
+        emit bufferingFinished();
+    }
+    m_audioTrack = -1;
+    m_subtitle = SUBTITLE_OFF;
+    m_externalSubtitle.reset();
+    m_externalSubtitleName.clear();
+    m_demuxPacketRate.store(0);
+    m_demuxIoRate.store(0);
+    m_rewindCache.clear();
+    m_scrubbing = false;
+    m_scrubTimer->stop();
 
     if (m_audioFlushTimer) {
         m_audioFlushTimer->stop();
@@ -390,30 +1087,67 @@ void VideoPlayer::stop()
         m_audioFlushTimer = nullptr;
     }
 
+    // QAudioSink 属于主线程，不能在回收线程析构：先挂起，回到事件循环后再释放
     if (audioSink) {
-        audioSink->stop();
-        delete audioSink;
+        audioSink->suspend();
+        audioSink->deleteLater();
         audioSink = nullptr;
         audioIODevice = nullptr;
     }
 
     clearQueue();
-    freeFFmpegResources();
 }
 
-void VideoPlayer::seek(double positionSec)
+void VideoPlayer::seek(double positionSec, bool exact)
 {
-    if (!fmtCtx) return;
+    if (!m_session) return;
 
-    {
-        QMutexLocker locker(&m_mutex);
-        m_frameQueue.clear();
-    }
+    post({PlayerCommand::Seek, 0, positionSec, exact ? 1 : 0});
+    m_lastPresentedPts.store(positionSec);   // 新帧到来前位置即为目标位置
+    restartAudioOutput();
+}
 
-    {
-        QMutexLocker aLocker(&m_audioQueueMutex);
-        m_audioQueue.clear();
+/**
+ * @brief 拖动进度条（主线程）：第一次调用时静音，之后按 SCRUB_INTERVAL_MS 限速投递预览位置，
+ * 间隔内的位置只保留最新一个，由定时器补发
+ */
+void VideoPlayer::scrubTo(double positionSec)
+{
+    if (!m_session || !m_session->thread || m_trickPlay || m_videoOutput == VideoOff) return;
+    const bool first = !m_scrubbing;
+    if (first) {
+        m_scrubbing = true;
+        m_scrubSent = -1.0;
     }
+    m_scrubTarget = positionSec;
+    if (!m_scrubTimer->isActive()) sendScrub();
+    // 预览命令已更新输出序号，之前的 PCM 按序号丢弃
+    if (first) {
+        restartAudioOutput();
+        if (audioSink) audioSink->suspend();
+    }
+}
+
+void VideoPlayer::sendScrub()
+{
+    post({PlayerCommand::Scrub, 0, m_scrubTarget});
+    m_scrubSent = m_scrubTarget;
+    m_scrubTimer->start(SCRUB_INTERVAL_MS);
+}
+
+/**
+ * @brief 松开进度条：精确定位到释放位置。解复用与文件缓存已停在预览的关键帧附近
+ */
+void VideoPlayer::endScrub(double positionSec)
+{
+    m_scrubbing = false;
+    m_scrubTimer->stop();
+    seek(positionSec, true);
+}
+
+void VideoPlayer::restartAudioOutput()
+{
+    dropStaleAudio();
 
     // 重置音频播放起点（在主线程中安全操作）
     m_audioBasePts.store(-1.0);
@@ -423,344 +1157,1236 @@ void VideoPlayer::seek(double positionSec)
     if (audioSink) {
         audioSink->stop();
         audioIODevice = audioSink->start();
+        if (m_trickPlay) audioSink->suspend();   // 快进模式保持静音
     }
+}
 
-    m_seekTargetSec = positionSec;
-    m_seekRequested.store(true);
-    m_finished.store(false);
-
-    m_playStarted = false;
-    m_totalPausedMs.store(0);
-    m_pauseStartMs = 0;
+/**
+ * @brief 逐帧（主线程）：播放中先暂停。声卡中已排队的声音作废，恢复播放时解码线程从停住的帧重新 seek
+ */
+void VideoPlayer::stepFrame(int direction)
+{
+    if (!m_session || !m_session->thread || m_trickPlay || m_videoOutput == VideoOff || direction == 0) return;
+    if (!m_paused.load()) pause();
+    post({PlayerCommand::StepFrame, 0, 0.0, direction > 0 ? 1 : -1});
+    restartAudioOutput();
 }
 
 // ---------------- decodeLoop ----------------
-void VideoPlayer::decodeLoop()
+void VideoPlayer::decodeLoop(MediaSession &s)
 {
-    swrCtx = nullptr;
-    // 用于缓冲音频帧，减少频繁的filter操作
-    std::vector<AVFrame*> audioFrameBatch;
-    const int AUDIO_BATCH_SIZE = 8;  // 批量处理音频帧
+    s.trace.mark("thread");
+    // 以纯音频模式起播：视频流在解复用线程开始读包前丢弃，缓冲量改按音轨计算
+    if (videoDiscarded(s)) {
+        applyStreamDiscard(s);
+        s.fastStart = false;
+    }
+    if (s.demuxer) s.demuxer->start(&m_memory);
+    drainCommands(s);
+    // 音频 filter 在首帧显示后由下面的倍速/引擎检查建立（audioFilterRate 初值为 0）
+    if (s.audioTrackRequest >= 0 && s.audioTrackRequest != s.audioStreamIndex) {
+        switchAudioTrack(s);
+    }
+
+    bool trickApplied = false;       // 解码器当前是否处于仅关键帧模式
 
-    while (!m_stopRequested.load()) {
-        if (m_paused.load()) {
-            QThread::msleep(10);
+    // GOP 并行解码引擎：开关只在起播和 seek 点生效（两种解码方式都从关键帧重新开始）
+    std::unique_ptr<GopParallelDecoder> gopDecoder;
+    auto syncGopDecoder = [&]() {
+        bool want = m_gopParallel.load();
+        if (want == bool(gopDecoder)) {
+            if (gopDecoder) gopDecoder->reset();
+            return;
+        }
+        s.setGopDecoder(nullptr);
+        if (!want) {
+            gopDecoder.reset();
+            return;
+        }
+        gopDecoder = std::make_unique<GopParallelDecoder>(&m_memory);
+        if (!gopDecoder->open(s.fmtCtx->streams[s.videoStreamIndex]->codecpar, s.videoTimeBase)) {
+            qWarning() << "GOP parallel decoder unavailable, fallback to sequential decoding";
+            gopDecoder.reset();
+        }
+        s.setGopDecoder(gopDecoder.get());
+    };
+    syncGopDecoder();
+    // 上一个文件的解码线程已经退出，它在 stop() 之后可能还缓存了画面
+    m_rewindCache.clear();
+
+    while (!s.stop.load()) {
+        s.wakeups.fetch_add(1, std::memory_order_relaxed);
+        // 检查点：执行主线程投递的全部控制命令
+        drainCommands(s);
+
+        // 拖动进度条：暂停与否都只处理最新的预览位置，没有新位置时阻塞等待
+        if (s.scrubbing) {
+            if (s.scrubPending) {
+                if (gopDecoder) gopDecoder->reset();
+                scrubStep(s);
+            } else {
+                s.waitForCommand();
+            }
             continue;
         }
 
-        // 处理跳转
-        if (m_seekRequested.load()) {
-            m_seekRequested.store(false);
-
-            int64_t ts = static_cast<int64_t>(m_seekTargetSec * AV_TIME_BASE);
-            int seekRet = av_seek_frame(fmtCtx, -1, ts, AVSEEK_FLAG_BACKWARD);
+        // 暂停：阻塞到下一条命令或 stop，期间不占用 CPU；逐帧命令在暂停状态下执行
+        if (s.paused) {
+            // 暂停中松开进度条：借逐帧窗口显示目标处的帧，恢复播放时从这一帧继续
+            if (s.seekPending && s.seekExact && s.stepRequest == 0 && !videoDiscarded(s)) {
+                s.seekExact = false;
+                s.seekTarget -= 2e-3;       // 向前一帧会显示第一个晚于起点的帧，即目标处的帧
+                s.stepRequest = 1;
+            }
+            if (s.stepRequest != 0) {
+                if (gopDecoder) gopDecoder->reset();
+                executeStep(s);
+                continue;
+            }
+            s.waitForCommand();
+            continue;
+        }
+
+        // 切换音轨：主线程随后投递的 seek 负责在当前位置重新同步
+        if (s.audioTrackRequest >= 0 && s.audioTrackRequest != s.audioStreamIndex) {
+            switchAudioTrack(s);
+        }
+        if (s.subtitleRequestPending) applySubtitleRequest(s);
+
+        // 处理跳转（连续多次 seek 只执行最后一次）
+        if (s.seekPending) {
+            s.seekPending = false;
+            s.finished = false;
+            // 目标落在快退缓存内时先回放缓存帧；否则缓存与新位置不再连续
+            const bool resume = s.seekResume;
+            const bool exact = s.seekExact && !isTrickRate(s.playRate);
+            s.seekResume = false;
+            s.seekExact = false;
+            const bool replay = !resume && !isTrickRate(s.playRate) && m_rewindCache.covers(s.seekTarget);
+            if (!replay) m_rewindCache.clear();
+            s.replaying = false;
+            s.audioSyncPending = false;
+
+            int64_t ts = static_cast<int64_t>(s.seekTarget * AV_TIME_BASE);
+            int seekRet = seekInput(s, -1, ts, AVSEEK_FLAG_BACKWARD);
             if (seekRet < 0) {
                 qWarning() << "Seek failed, trying AVSEEK_FLAG_ANY";
-                seekRet = av_seek_frame(fmtCtx, -1, ts, AVSEEK_FLAG_ANY);
+                seekRet = seekInput(s, -1, ts, AVSEEK_FLAG_ANY);
             }
 
-            if (codecCtx) avcodec_flush_buffers(codecCtx);
-            if (audioCodecCtx) avcodec_flush_buffers(audioCodecCtx);
+            if (s.codecCtx) avcodec_flush_buffers(s.codecCtx);
+            if (s.audioCodecCtx) avcodec_flush_buffers(s.audioCodecCtx);
+            if (s.subtitleCodecCtx) avcodec_flush_buffers(s.subtitleCodecCtx);
+            s.videoFilter.reset();
+            syncGopDecoder();
+
+            // 旧位置的 PCM 由主线程按序号丢弃（restartAudioOutput / flushAudioBuffer），解码线程不清空环形缓冲
+            for (AVPacket *p : s.deferredAudio) av_packet_free(&p);
+            s.deferredAudio.clear();
+
+            // 复用 audio filter，只丢弃旧输出；没有 filter 或已在文件尾冲洗关闭时才新建
+            if (s.audioFilterGraph && !s.audioFilterEof) {
+                flushAudioFilter(s);
+            } else if (s.audioCodecCtx && !initAudioFilter(s, s.playRate)) {
+                qWarning() << "Failed to init audio filter after seek";
+            }
 
-            {
-                QMutexLocker locker(&m_mutex);
-                m_frameQueue.clear();
+            s.playStartPts = s.seekTarget;   // 快退模式据此计算首个目标位置
+            s.playStarted = false;
+            s.totalPausedMs = 0;
+            s.pauseStartMs = 0;
+            s.lastPts = s.seekTarget;
+            if (resume) startReplayClock(s, s.seekTarget);
+            else if (replay && !startRewindReplay(s)) m_rewindCache.clear();
+            if (!s.replaying) startSkipReplay(s);
+            if (!s.replaying && exact) {
+                // 精确定位：从关键帧解码到目标，之前的帧不缩放也不显示，时钟从第一个显示的帧开始；
+                // 纯音频时只丢弃目标之前的声音
+                s.replaying = !videoDiscarded(s);
+                s.replayPts = s.seekTarget - 2e-3;
+                s.audioSyncPending = s.audioCodecCtx != nullptr;
             }
-            {
-                QMutexLocker aLocker(&m_audioQueueMutex);
-                m_audioQueue.clear();
+
+            continue;
+        }
+
+        // 文件尾：阻塞到下一条命令（seek 才会离开这个状态）或 stop
+        if (s.finished) {
+            s.waitForCommand();
+            continue;
+        }
+
+        // 切换快进/快退模式：只解码关键帧
+        bool trick = isTrickRate(s.playRate);
+        if (trick != trickApplied) {
+            s.codecCtx->skip_frame = trick ? AVDISCARD_NONKEY : AVDISCARD_DEFAULT;
+            avcodec_flush_buffers(s.codecCtx);
+            if (gopDecoder) gopDecoder->reset();
+            s.videoFilter.reset();
+            trickApplied = trick;
+            m_rewindCache.clear();
+            s.replaying = false;
+            s.audioSyncPending = false;
+            if (s.videoOutput == VideoOff) applyStreamDiscard(s);     // 纯音频下快进仍需要关键帧
+        }
+
+        // 画面不可见：只解码参考帧，解码器状态保持完整，恢复可见后下一帧即可正常显示
+        if (!trickApplied && s.codecCtx) {
+            AVDiscard skip = s.videoOutput == VideoHidden && s.firstFrameShown ? AVDISCARD_NONREF : AVDISCARD_DEFAULT;
+            if (s.codecCtx->skip_frame != skip) s.codecCtx->skip_frame = skip;
+        }
+
+        // 快退：按关键帧逐个向前跳
+        if (trickApplied && s.playRate < 0.0) {
+            reverseTrickStep(s);
+            continue;
+        }
+
+        // 切换时间伸缩引擎：两种引擎的 filter 输出格式不同，只能重建
+        if (!trickApplied && !s.fastStart && s.audioCodecCtx && s.audioFilterEngine != s.stretchEngine) {
+            if (!initAudioFilter(s, s.playRate)) qWarning() << "Failed to reinit audio filter on engine change";
+        }
+
+        // 速率变化（来自 SetRate 命令）：原地修改 atempo / WSOLA 倍速，失败时才重建 filter
+        if (!trickApplied && !s.fastStart && s.audioCodecCtx && std::abs(s.audioFilterRate - s.playRate) > 1e-6) {
+            if (!setAudioFilterTempo(s, s.playRate) && !initAudioFilter(s, s.playRate)) {
+                qWarning() << "Failed to reinit audio filter on rate change";
             }
+        }
 
-            // 清空音频帧缓冲
-            for (auto f : audioFrameBatch) av_frame_free(&f);
-            audioFrameBatch.clear();
+        // 首帧已显示：补解码起播期间暂存的音频包
+        if (!s.fastStart && !s.deferredAudio.empty()) {
+            decodeDeferredAudio(s);
+            continue;
+        }
+
+        if (s.replaying) pumpRewind(s);
+
+        // PCM 队列超出配额：等声卡消耗后再读包（声卡暂停时按超时轮询，保证能响应 stop/seek）
+        if (!m_memory.hasRoom(MemoryBudget::AudioPcm)) {
+            m_memory.waitForRoom(MemoryBudget::AudioPcm, 50);
+            continue;
+        }
+        // 纯音频：没有视频帧按时钟等待，PCM 超前声卡 AUDIO_ONLY_AHEAD_SEC 后暂停读包，避免过早读到文件尾
+        if (videoDiscarded(s)
+            && m_memory.used(MemoryBudget::AudioPcm) > qint64(AUDIO_ONLY_AHEAD_SEC * s.audioOutRate) * 4) {
+            s.sleepFor(20);
+            continue;
+        }
 
-            // 重建 audio filter（解码线程内）
-            if (audioCodecCtx) {
-                QMutexLocker filterLocker(&m_audioFilterMutex);
-                cleanupAudioFilter();
-                if (!initAudioFilter(m_playRate.load())) {
-                    qWarning() << "Failed to reinit audio filter after seek";
+        int ret = readInput(s, s.packet, !trickApplied);
+        if (ret == AVERROR(EAGAIN) && s.demuxer) {
+            // 网络流低于水位：冻结时钟、通知界面，等缓冲回到高水位再继续（期间照常响应命令）
+            setBuffering(s, true);
+            s.demuxer->waitForData(50);
+            continue;
+        }
+        if (s.buffering) setBuffering(s, false);
+        if (ret >= 0) updateDemuxStats(s, s.packet->size);
+        if (ret < 0 && s.fastStart) {
+            // 首帧之前就到了文件尾：结束起播阶段，先把暂存的音频解码出来
+            s.fastStart = false;
+            continue;
+        }
+        if (ret < 0) {
+            // GOP 并行引擎：提交最后的 GOP，先把剩余帧显示完
+            if (gopDecoder && !trickApplied && gopDecoder->hasPending()) {
+                gopDecoder->flush();
+                if (AVFrame *gf = gopDecoder->takeFrame(true)) {
+                    presentVideoFrame(s, gf);
+                    av_frame_free(&gf);
                 }
+                continue;
             }
 
-            m_audioBasePts.store(-1.0);
-            m_audioPlayedSamples.store(0);
-            m_playStarted = false;
-            m_totalPausedMs.store(0);
-            m_pauseStartMs = 0;
+            if (!trickApplied) flushVideoFilter(s);
+
+            // 冲洗 audio filter，把 atempo 中剩余的样本写出
+            if (!trickApplied && !s.audioFilterEof && s.audioBufferSrcCtx) {
+                filterAudioFrame(s, nullptr);
+                s.audioFilterEof = true;
+            }
+            // 纯音频：等声卡取走排队的 PCM 再结束，否则结尾的声音会被暂停截掉
+            if (videoDiscarded(s) && m_memory.used(MemoryBudget::AudioPcm) > 0) {
+                s.sleepFor(20);
+                continue;
+            }
+
+            // 文件尾：暂停与 finished 通知交给主线程，解码线程在循环顶部阻塞到 seek/stop
+            s.finished = true;
+            quint64 serial = s.outputSerial;
+            QMetaObject::invokeMethod(this, [this, serial]() { onPlaybackFinished(serial); }, Qt::QueuedConnection);
+            continue;
+        }
 
+        // 快进模式下静音：音频包直接丢弃
+        if (trickApplied && s.packet->stream_index == s.audioStreamIndex) {
+            av_packet_unref(s.packet);
             continue;
         }
 
-        // 检查是否需要重置 audio filter（来自 setPlayRate）
-        if (m_audioFilterNeedReset.load()) {
-            m_audioFilterNeedReset.store(false);
-            QMutexLocker filterLocker(&m_audioFilterMutex);
-            cleanupAudioFilter();
-            if (audioCodecCtx) {
-                if (!initAudioFilter(m_playRate.load())) {
-                    qWarning() << "Failed to reinit audio filter on rate change";
+        // 处理音频帧：每解码一帧立即过滤并写入 PCM 缓冲，帧对象在会话内复用
+        if (s.audioStreamIndex >= 0 && s.packet->stream_index == s.audioStreamIndex && s.audioCodecCtx) {
+            // 起播阶段只暂存，不让音频解码和 filter 初始化挡在首帧前面；暂存过多时提前结束起播阶段
+            if (s.fastStart) {
+                AVPacket *p = av_packet_alloc();
+                av_packet_move_ref(p, s.packet);
+                s.deferredAudio.push_back(p);
+                if (int(s.deferredAudio.size()) >= FAST_START_MAX_AUDIO_PACKETS) s.fastStart = false;
+                continue;
+            }
+            if (avcodec_send_packet(s.audioCodecCtx, s.packet) == 0) {
+                while (avcodec_receive_frame(s.audioCodecCtx, s.audioFrame) == 0) {
+                    filterAudioFrame(s, s.audioFrame);
                 }
             }
-            // we continue; loop will read next packets
+            av_packet_unref(s.packet);
+            continue;
         }
 
-        int ret = av_read_frame(fmtCtx, packet);
-        if (ret < 0) {
-            // 处理剩余的音频帧
-            if (!audioFrameBatch.empty() && audioCodecCtx) {
-                QMutexLocker filterLocker(&m_audioFilterMutex);
-                if (audioBufferSrcCtx && audioBufferSinkCtx) {
-                    for (AVFrame *aframe : audioFrameBatch) {
-                        int addRet = av_buffersrc_add_frame_flags(audioBufferSrcCtx, aframe, AV_BUFFERSRC_FLAG_KEEP_REF);
-                        if (addRet < 0) {
-                            char errbuf[128]; av_strerror(addRet, errbuf, sizeof(errbuf));
-                            qWarning() << "Error feeding audio filter on EOF:" << errbuf;
-                        }
-                        av_frame_unref(aframe);
-                    }
-                    // 最后冲洗filter
-                    int flushRet = av_buffersrc_add_frame_flags(audioBufferSrcCtx, nullptr, 0);
-                    if (flushRet < 0) {
-                        char errbuf[128]; av_strerror(flushRet, errbuf, sizeof(errbuf));
-                        qWarning() << "Error flushing audio filter:" << errbuf;
-                    }
-                    // 读取所有剩余帧
-                    while (true) {
-                        AVFrame *filteredFrame = av_frame_alloc();
-                        if (av_buffersink_get_frame(audioBufferSinkCtx, filteredFrame) < 0) {
-                            av_frame_free(&filteredFrame);
+        // 字幕包：解码后加入字幕轨的时间索引，显示时按帧 pts 查找
+        if (s.subtitleCodecCtx && s.packet->stream_index == s.subtitleStreamIndex) {
+            decodeSubtitlePacket(s);
+            av_packet_unref(s.packet);
+            continue;
+        }
+
+        // 处理视频帧
+        if (s.packet->stream_index == s.videoStreamIndex) {
+            // 切换到纯音频前已读入缓冲的视频包
+            if (videoDiscarded(s)) {
+                av_packet_unref(s.packet);
+                continue;
+            }
+            // GOP 并行解码：读包与显示交错进行，在途 GOP 达到上限时阻塞取帧
+            if (gopDecoder && !trickApplied) {
+                gopDecoder->pushPacket(s.packet);
+                av_packet_unref(s.packet);
+                if (AVFrame *gf = gopDecoder->takeFrame(gopDecoder->saturated())) {
+                    presentVideoFrame(s, gf);
+                    av_frame_free(&gf);
+                }
+                continue;
+            }
+            // 快进模式下非关键帧直接丢弃，连送入解码器的开销也省掉
+            if (trickApplied && !(s.packet->flags & AV_PKT_FLAG_KEY)) {
+                av_packet_unref(s.packet);
+                continue;
+            }
+            if (avcodec_send_packet(s.codecCtx, s.packet) == 0) {
+                while (avcodec_receive_frame(s.codecCtx, s.frame) == 0) {
+                    double vpts = presentVideoFrame(s, s.frame);
+                    // 快进模式下解码跟不上墙钟时，直接跳到目标位置附近的关键帧
+                    if (trickApplied) {
+                        double target = trickTargetPos(s);
+                        if (target - vpts > TRICK_CATCHUP_SEC) {
+                            int64_t ts = static_cast<int64_t>(target / av_q2d(s.videoTimeBase));
+                            seekInput(s, s.videoStreamIndex, ts, AVSEEK_FLAG_BACKWARD);
+                            avcodec_flush_buffers(s.codecCtx);
                             break;
                         }
-                        // ... 处理 filteredFrame ...
-                        av_frame_free(&filteredFrame);
                     }
                 }
-                for (auto f : audioFrameBatch) av_frame_free(&f);
-                audioFrameBatch.clear();
             }
+        }
+
+        av_packet_unref(s.packet);
+    }
+
+    // 缩放器、filter 与解码器随会话在回收线程释放
+    s.setGopDecoder(nullptr);
+    clearStepWindow(s);
+    if (s.skipPrefetch) {
+        SkipPrefetcher::Stats st = s.skipPrefetch->stats();
+        qDebug() << "Skip prefetch: hits" << st.hits << ", misses" << st.misses << ", reseeks" << st.reseeks
+                 << ", backoffs" << st.backoffs;
+        s.skipPrefetch.reset();
+    }
+    s.barDetector.reset();
+}
 
-            if (!m_finished.load()) {
-                m_finished.store(true);
-                pause();
-                emit finished();
+/**
+ * @brief 起播阶段结束后，按原顺序解码暂存的音频包
+ */
+void VideoPlayer::decodeDeferredAudio(MediaSession &s)
+{
+    // filter 未建立（快进模式或初始化失败）时直接丢弃
+    for (AVPacket *p : s.deferredAudio) {
+        if (s.audioBufferSrcCtx && s.audioCodecCtx && p->stream_index == s.audioStreamIndex
+            && avcodec_send_packet(s.audioCodecCtx, p) == 0) {
+            while (avcodec_receive_frame(s.audioCodecCtx, s.audioFrame) == 0) {
+                filterAudioFrame(s, s.audioFrame);
             }
-            QThread::msleep(20);
-            continue;
         }
+        av_packet_free(&p);
+    }
+    s.deferredAudio.clear();
+}
 
-        // 处理音频帧（批量处理模式）
-        if (audioStreamIndex >= 0 && packet->stream_index == audioStreamIndex && audioCodecCtx) {
-            if (avcodec_send_packet(audioCodecCtx, packet) == 0) {
-                AVFrame *aframe = av_frame_alloc();
-                while (avcodec_receive_frame(audioCodecCtx, aframe) == 0) {
-                    // 缓冲音频帧而不是立即处理
-                    AVFrame *frameClone = av_frame_clone(aframe);
-                    if (frameClone) {
-                        audioFrameBatch.push_back(frameClone);
-                    }
+/**
+ * @brief 解码线程中切换音轨：打开新解码器、更新丢弃标记并重建 filter。
+ * 新解码器打开失败时保留原音轨
+ */
+void VideoPlayer::switchAudioTrack(MediaSession &s)
+{
+    int index = s.audioTrackRequest;
+    s.audioTrackRequest = -1;
+    if (index < 0 || index >= int(s.fmtCtx->nb_streams)
+        || s.fmtCtx->streams[index]->codecpar->codec_type != AVMEDIA_TYPE_AUDIO) return;
+
+    AVCodecContext *ctx = openAudioDecoder(s.fmtCtx->streams[index]);
+    if (!ctx) {
+        qWarning() << "Failed to open audio decoder for stream" << index << ", keep current track";
+        if (s.audioCodecCtx && !s.audioFilterGraph) initAudioFilter(s, s.playRate);
+        return;
+    }
 
-                    // 当缓冲满或需要处理时，批量通过filter
-                    if (audioFrameBatch.size() >= AUDIO_BATCH_SIZE) {
-                        QMutexLocker filterLocker(&m_audioFilterMutex);
-                        if (audioBufferSrcCtx && audioBufferSinkCtx) {
-                            for (AVFrame *batchFrame : audioFrameBatch) {
-                                int addRet = av_buffersrc_add_frame_flags(audioBufferSrcCtx, batchFrame, AV_BUFFERSRC_FLAG_KEEP_REF);
-                                if (addRet < 0) {
-                                    char errbuf[128]; av_strerror(addRet, errbuf, sizeof(errbuf));
-                                    qWarning() << "Error feeding audio filter (batch):" << errbuf;
-                                    av_frame_unref(batchFrame);
-                                    continue;
-                                }
-
-                                double apts = 0.0;
-                                if (batchFrame->pts != AV_NOPTS_VALUE)
-                                    apts = batchFrame->pts * av_q2d(audioTimeBase);
-                                else if (batchFrame->best_effort_timestamp != AV_NOPTS_VALUE)
-                                    apts = batchFrame->best_effort_timestamp * av_q2d(audioTimeBase);
-
-                                // 从 filter 读取处理后的帧
-                                while (true) {
-                                    AVFrame *filteredFrame = av_frame_alloc();
-                                    ret = av_buffersink_get_frame(audioBufferSinkCtx, filteredFrame);
-                                    if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
-                                        av_frame_free(&filteredFrame);
-                                        break;
-                                    }
-                                    if (ret < 0) {
-                                        av_frame_free(&filteredFrame);
-                                        break;
-                                    }
-
-                                    int outChannels = 0;
-#if LIBAVUTIL_VERSION_INT >= AV_VERSION_INT(57, 17, 0)
-                                    outChannels = filteredFrame->ch_layout.nb_channels;
-#else
-                                    outChannels = filteredFrame->nb_channels;
-#endif
-                                    if (outChannels <= 0) {
-                                        outChannels = m_audioOutChannels > 0 ? m_audioOutChannels : 2;
-                                    }
-
-                                    int bytesPerSample = av_get_bytes_per_sample(AV_SAMPLE_FMT_S16);
-                                    if (bytesPerSample <= 0) bytesPerSample = 2;
-
-                                    int bytes = av_samples_get_buffer_size(nullptr,
-                                                                           outChannels,
-                                                                           filteredFrame->nb_samples,
-                                                                           AV_SAMPLE_FMT_S16, 1);
-                                    if (bytes > 0 && filteredFrame->data[0]) {
-                                        QByteArray chunk(reinterpret_cast<const char*>(filteredFrame->data[0]), bytes);
-                                        {
-                                            QMutexLocker aLocker(&m_audioQueueMutex);
-                                            m_audioQueue.push_back(chunk);
-                                        }
-
-                                        double base = m_audioBasePts.load();
-                                        if (base < 0.0) {
-                                            m_audioBasePts.store(apts);
-                                            m_audioPlayedSamples.store(0);
-                                            qDebug() << "Audio base PTS set to:" << apts;
-                                        }
-                                    }
-
-                                    av_frame_free(&filteredFrame);
-                                }
-                                av_frame_unref(batchFrame);
-                            }
-                        }
-                        for (auto f : audioFrameBatch) av_frame_free(&f);
-                        audioFrameBatch.clear();
-                    }
-                }
-                av_frame_free(&aframe);
+    if (s.audioCodecCtx) avcodec_free_context(&s.audioCodecCtx);
+    s.audioCodecCtx = ctx;
+    s.audioStreamIndex = index;
+    s.audioTimeBase = s.fmtCtx->streams[index]->time_base;
+    applyStreamDiscard(s);
+
+    // 采样率可能不同：filter 统一重采样到声卡打开时的输出采样率
+    if (!initAudioFilter(s, s.playRate)) qWarning() << "Failed to init audio filter for new track";
+    qDebug() << "Audio track switched to stream" << index;
+}
+
+/**
+ * @brief 解码线程中切换字幕：关闭旧的嵌入字幕解码器，换成外挂字幕或新的嵌入流
+ */
+void VideoPlayer::applySubtitleRequest(MediaSession &s)
+{
+    s.subtitleRequestPending = false;
+    std::shared_ptr<SubtitleTrack> external = std::move(s.subtitleRequestTrack);
+
+    if (s.subtitleCodecCtx) avcodec_free_context(&s.subtitleCodecCtx);
+    s.subtitleStreamIndex = -1;
+    s.subtitles.reset();
+    s.subtitleRenderer.clear();
+
+    if (s.subtitleRequest == SUBTITLE_EXTERNAL) {
+        s.subtitles = std::move(external);
+    } else if (s.subtitleRequest >= 0 && s.subtitleRequest < int(s.fmtCtx->nb_streams)) {
+        if (!openSubtitleStream(s, s.subtitleRequest)) qWarning() << "Failed to open subtitle stream" << s.subtitleRequest;
+    }
+    applyStreamDiscard(s);
+}
+
+/**
+ * @brief 解码一个字幕包：文本/ASS 事件解析为文本 cue，位图字幕转为预乘 ARGB 图像
+ */
+void VideoPlayer::decodeSubtitlePacket(MediaSession &s)
+{
+    AVSubtitle sub;
+    int got = 0;
+    if (avcodec_decode_subtitle2(s.subtitleCodecCtx, &sub, &got, s.packet) < 0 || !got) return;
+
+    AVRational tb = s.fmtCtx->streams[s.subtitleStreamIndex]->time_base;
+    qint64 baseMs = 0;
+    if (sub.pts != AV_NOPTS_VALUE) baseMs = sub.pts / 1000;     // AV_TIME_BASE
+    else if (s.packet->pts != AV_NOPTS_VALUE) baseMs = qint64(s.packet->pts * av_q2d(tb) * 1000.0);
+    qint64 startMs = baseMs + sub.start_display_time;
+    qint64 endMs = SubtitleCue::OPEN_END;
+    if (sub.end_display_time > sub.start_display_time && sub.end_display_time != UINT32_MAX)
+        endMs = baseMs + sub.end_display_time;
+    else if (s.packet->duration > 0)
+        endMs = startMs + qint64(s.packet->duration * av_q2d(tb) * 1000.0);
+
+    // 位图字幕（PGS 等）以下一条（常为空字幕）的到来表示上一条结束
+    s.subtitles->closeOpenCues(startMs);
+
+    for (unsigned i = 0; i < sub.num_rects; ++i) {
+        const AVSubtitleRect *r = sub.rects[i];
+        if (r->type == SUBTITLE_ASS && r->ass) {
+            s.subtitles->addAssEvent(QString::fromUtf8(r->ass), startMs, endMs);
+        } else if (r->type == SUBTITLE_TEXT && r->text) {
+            SubtitleCue cue;
+            cue.startMs = startMs;
+            cue.endMs = endMs;
+            cue.text = QString::fromUtf8(r->text);
+            s.subtitles->addCue(cue);
+        } else if (r->type == SUBTITLE_BITMAP && r->w > 0 && r->h > 0 && r->data[0] && r->data[1]) {
+            // data[0] 为调色板索引，data[1] 为 ARGB 调色板（与 QRgb 相同）
+            QImage img(r->w, r->h, QImage::Format_ARGB32);
+            const uint32_t *palette = reinterpret_cast<const uint32_t*>(r->data[1]);
+            for (int y = 0; y < r->h; ++y) {
+                const uint8_t *src = r->data[0] + y * r->linesize[0];
+                QRgb *dst = reinterpret_cast<QRgb*>(img.scanLine(y));
+                for (int x = 0; x < r->w; ++x) dst[x] = palette[src[x]];
             }
-            av_packet_unref(packet);
+            SubtitleCue cue;
+            cue.startMs = startMs;
+            cue.endMs = endMs;
+            cue.image = img.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+            cue.imageRect = QRect(r->x, r->y, r->w, r->h);
+            s.subtitles->addCue(cue);
+        }
+    }
+    avsubtitle_free(&sub);
+}
+
+/**
+ * @brief 累计解复用字节数，约每秒计算一次速率供主线程读取
+ */
+void VideoPlayer::updateDemuxStats(MediaSession &s, int packetBytes)
+{
+    s.demuxWindowPackets += packetBytes;
+    qint64 io = s.fmtCtx->pb ? s.fmtCtx->pb->bytes_read : 0;
+    if (!s.demuxTimer.isValid()) {
+        s.demuxTimer.start();
+        s.demuxWindowIoStart = io;
+        return;
+    }
+    qint64 ms = s.demuxTimer.elapsed();
+    if (ms < 1000) return;
+    m_demuxPacketRate.store(s.demuxWindowPackets * 1000 / ms);
+    m_demuxIoRate.store((io - s.demuxWindowIoStart) * 1000 / ms);
+    s.demuxWindowPackets = 0;
+    s.demuxWindowIoStart = io;
+    s.demuxTimer.restart();
+}
+
+/**
+ * @brief 解码线程进入/离开网络缓冲状态。缓冲期间没有帧输出，恢复时从最后显示的帧重新建立时间基，
+ * 等价于视频时钟暂停；声卡的挂起/恢复交给主线程
+ */
+void VideoPlayer::setBuffering(MediaSession &s, bool on)
+{
+    if (s.buffering == on) return;
+    s.buffering = on;
+    if (!on && s.playStarted) {
+        if (s.lastPts >= 0.0) s.playStartPts = s.lastPts;
+        s.playTimer.restart();
+        s.totalPausedMs = 0;
+        s.pauseStartMs = 0;
+    }
+    std::weak_ptr<const MediaSession> session = s.weak_from_this();
+    QMetaObject::invokeMethod(this, [this, session, on]() { onBufferingChanged(session, on); }, Qt::QueuedConnection);
+}
+
+/**
+ * @brief 按所有权比较而不是地址：weak_ptr 使旧会话的控制块一直存活，新会话不可能与它相同；
+ *        也不 lock()，避免在主线程上成为最后一个持有者而在这里析构会话
+ */
+bool VideoPlayer::isCurrentSession(const std::weak_ptr<const MediaSession> &s) const
+{
+    return m_session && !s.owner_before(m_session) && !m_session.owner_before(s);
+}
+
+void VideoPlayer::onBufferingChanged(const std::weak_ptr<const MediaSession> &s, bool on)
+{
+    // 已换文件或停止：旧会话的通知作废
+    if (!isCurrentSession(s) || m_buffering == on) return;
+    m_buffering = on;
+    qDebug() << (on ? "Buffering..." : "Buffering finished");
+    if (audioSink) {
+        if (on) audioSink->suspend();
+        else if (!m_paused.load() && !m_trickPlay) audioSink->resume();
+    }
+    if (on) emit buffering();
+    else emit bufferingFinished();
+}
+
+int VideoPlayer::bufferingPercent() const
+{
+    if (!m_session || !m_session->demuxer) return 100;
+    return m_session->demuxer->bufferingPercent();
+}
+
+double VideoPlayer::duration() const
+{
+    if (!m_session || !m_session->fmtCtx || m_session->fmtCtx->duration <= 0) return 0.0;
+    return m_session->fmtCtx->duration / double(AV_TIME_BASE);
+}
+
+QSize VideoPlayer::videoSize() const
+{
+    if (!m_session || !m_session->codecCtx) return QSize();
+    return QSize(m_session->codecCtx->width, m_session->codecCtx->height);
+}
+
+QSize VideoPlayer::displaySize() const
+{
+    QSize size = videoSize();
+    if (size.isEmpty()) return size;
+    return VideoFilter::outputSize(size, effectiveFilterConfig(), m_session->videoRotation);
+}
+
+// ---------------- video presentation ----------------
+qint64 VideoPlayer::playElapsedMs(const MediaSession &s)
+{
+    qint64 elapsedMsRaw = s.playTimer.elapsed();
+    if (s.pauseStartMs > 0) {
+        qint64 now = s.playTimer.elapsed();
+        elapsedMsRaw -= now - s.pauseStartMs;
+    } else {
+        elapsedMsRaw -= s.totalPausedMs;
+    }
+    return elapsedMsRaw;
+}
+
+/**
+ * @brief 把解码帧缩放到渲染尺寸（RGB24）并叠加当前字幕
+ */
+QImage VideoPlayer::scaleFrame(MediaSession &s, AVFrame *vframe, double vpts)
+{
+    int dstW = s.renderWidth;
+    int dstH = s.renderHeight;
+    if (dstW <= 0 || dstH <= 0) {
+        dstW = vframe->width;
+        dstH = vframe->height;
+    }
+
+    // 重建 swsCtx（使用更快的缩放算法减少CPU占用）
+    // 源尺寸/格式取自帧本身：GOP 并行模式下帧来自其他解码器实例，滤镜开关或旋转后尺寸也会变化
+    AVPixelFormat srcFmt = static_cast<AVPixelFormat>(vframe->format);
+    if (!s.swsCtx || s.swsNeedReset || vframe->width != s.swsSrcWidth || vframe->height != s.swsSrcHeight
+        || vframe->format != s.swsSrcFormat) {
+        if (s.swsCtx) {
+            sws_freeContext(s.swsCtx);
+            s.swsCtx = nullptr;
+        }
+
+        s.swsCtx = sws_getContext(vframe->width, vframe->height, srcFmt,
+                                  dstW, dstH, AV_PIX_FMT_RGB24,
+                                  s.scalingAlgo, nullptr, nullptr, nullptr);
+        if (!s.swsCtx) {
+            // 降级到最快的算法
+            s.swsCtx = sws_getContext(vframe->width, vframe->height, srcFmt,
+                                      dstW, dstH, AV_PIX_FMT_RGB24,
+                                      SWS_FAST_BILINEAR, nullptr, nullptr, nullptr);
+        }
+        s.swsNeedReset = false;
+        s.swsSrcWidth = vframe->width;
+        s.swsSrcHeight = vframe->height;
+        s.swsSrcFormat = vframe->format;
+    }
+
+    QImage img(dstW, dstH, QImage::Format_RGB888);
+    uint8_t *dst[4] = { img.bits(), nullptr, nullptr, nullptr };
+    int dst_linesize[4] = { static_cast<int>(img.bytesPerLine()), 0, 0, 0 };
+
+    sws_scale(s.swsCtx, vframe->data, vframe->linesize, 0, vframe->height, dst, dst_linesize);
+
+    // 字幕叠加：显示的 cue 集合不变时复用缓存的叠加图，每帧只做包围盒内的混合
+    if (s.subtitles) {
+        s.subtitleRenderer.composite(img, *s.subtitles, qint64(vpts * 1000.0), QSize(vframe->width, vframe->height));
+    }
+    return img;
+}
+
+/**
+ * @brief 解码帧经过视频滤镜后显示。连续播放走完整滤镜链，去隔行使输出晚一帧；
+ * 快进模式的关键帧互不相邻，只做旋转与裁剪；画面不可见时跳过滤镜
+ */
+double VideoPlayer::presentVideoFrame(MediaSession &s, AVFrame *vframe)
+{
+    const double vpts = videoPtsToSeconds(s, vframe);
+    if (s.videoOutput != VideoVisible && s.firstFrameShown) {
+        s.videoFilter.reset();
+        showVideoFrame(s, vframe);
+        return vpts;
+    }
+    if (isTrickRate(s.playRate)) {
+        AVFrame *still = s.videoFilter.filterStill(vframe);
+        showVideoFrame(s, still ? still : vframe);
+        av_frame_free(&still);
+        return vpts;
+    }
+    updateBarDetection(s, vframe, vpts);
+    if (!s.videoFilter.push(vframe)) {
+        showVideoFrame(s, vframe);
+        return vpts;
+    }
+    while (AVFrame *out = s.videoFilter.pull()) {
+        showVideoFrame(s, out);
+        av_frame_free(&out);
+    }
+    return vpts;
+}
+
+void VideoPlayer::flushVideoFilter(MediaSession &s)
+{
+    s.videoFilter.flush();
+    while (AVFrame *out = s.videoFilter.pull()) {
+        showVideoFrame(s, out);
+        av_frame_free(&out);
+    }
+}
+
+QImage VideoPlayer::scaleStill(MediaSession &s, AVFrame *vframe, double vpts)
+{
+    AVFrame *still = s.videoFilter.filterStill(vframe);
+    QImage img = scaleFrame(s, still ? still : vframe, vpts);
+    av_frame_free(&still);
+    return img;
+}
+
+double VideoPlayer::showVideoFrame(MediaSession &s, AVFrame *vframe)
+{
+    const bool first = !s.firstFrameShown;
+    if (first) s.trace.mark("decode");
+
+    double vpts = 0.0;
+    if (vframe->pts != AV_NOPTS_VALUE)
+        vpts = vframe->pts * av_q2d(s.videoTimeBase);
+    else if (vframe->best_effort_timestamp != AV_NOPTS_VALUE)
+        vpts = vframe->best_effort_timestamp * av_q2d(s.videoTimeBase);
+
+    // 缓存帧回放中：已经显示过的位置不再缩放，只借机放出到时间的缓存帧
+    if (s.replaying) {
+        if (vpts <= s.replayPts + 1e-3) {
+            pumpRewind(s);
+            return vpts;
+        }
+        s.replaying = false;
+    }
+
+    // 画面不可见：不缩放也不交给界面，时钟照常推进并定期报告位置（首帧仍然显示，它负责启动声卡）
+    const bool hidden = s.videoOutput != VideoVisible && !first;
+    QImage img;
+    if (!hidden) {
+        img = scaleFrame(s, vframe, vpts);
+        if (!isTrickRate(s.playRate)) m_rewindCache.add(img, vpts);
+    }
+    if (first) {
+        s.trace.mark("convert");
+        s.firstFrameShown = true;
+        s.fastStart = false;
+    }
+
+    // 时间控制
+    if (!s.playStarted) {
+        s.playStartPts = vpts;
+        s.playTimer.start();
+        s.totalPausedMs = 0;
+        s.pauseStartMs = 0;
+        s.playStarted = true;
+    }
+
+    // 倒放时 rate 为负，(vpts - start) 同样为负，目标时间仍为正
+    qint64 targetMs = qint64((vpts - s.playStartPts) * 1000.0 / s.playRate);
+    qint64 waitMs = targetMs - playElapsedMs(s);
+    updateSkipPrefetch(s, vpts, waitMs);
+    if (waitMs > 0) {
+        if (waitMs > 200) waitMs = 200;
+        s.sleepFor(int(waitMs));
+    }
+
+    s.lastPts = vpts;
+    if (hidden) postPosition(s, vpts);
+    else postFrame(s, img, vpts, first);
+    return vpts;
+}
+
+/**
+ * @brief 交给主线程发出；期间若已有新的 seek/换文件，该帧按序号丢弃
+ */
+void VideoPlayer::postFrame(MediaSession &s, const QImage &img, double vpts, bool first)
+{
+    quint64 serial = s.outputSerial;
+    QMetaObject::invokeMethod(this, [this, img, vpts, serial, first]() {
+        if (serial != m_flushSerial.load()) return;
+        // 只记录位置，不再缓存已显示的图像
+        m_lastPresentedPts.store(vpts);
+        emit frameReady(img);
+        emit positionChanged(vpts);
+        // 首帧已交给界面：报告起播耗时，然后再创建声卡输出
+        if (first && m_session) {
+            m_session->trace.mark("present");
+            m_startupReport = m_session->trace.report();
+            qDebug().noquote() << "Startup:" << m_startupReport;
+            m_firstFrameClock.start();
+            if (m_audioOutputPending) QTimer::singleShot(0, this, [this]() {
+                if (m_audioOutputPending) startAudioOutput();
+            });
+        }
+    }, Qt::QueuedConnection);
+}
+
+void VideoPlayer::postPosition(MediaSession &s, double vpts)
+{
+    if (s.lastPositionPts >= 0.0 && std::abs(vpts - s.lastPositionPts) < POSITION_INTERVAL_SEC) return;
+    s.lastPositionPts = vpts;
+    quint64 serial = s.outputSerial;
+    QMetaObject::invokeMethod(this, [this, vpts, serial]() {
+        if (serial != m_flushSerial.load()) return;
+        m_lastPresentedPts.store(vpts);
+        emit positionChanged(vpts);
+    }, Qt::QueuedConnection);
+}
+
+/**
+ * @brief seek 后立即显示一帧已准备好的画面，并以它为起点重新建立时钟。
+ * 之后解码器照常从关键帧解码，追上 replayPts 之前的帧由 presentVideoFrame 丢弃
+ */
+void VideoPlayer::beginReplay(MediaSession &s, const QImage &img, double pts)
+{
+    startReplayClock(s, pts);
+    postFrame(s, img, pts, false);
+}
+
+void VideoPlayer::startReplayClock(MediaSession &s, double pts)
+{
+    s.playStartPts = pts;
+    s.playTimer.start();
+    s.playStarted = true;
+    s.replaying = true;
+    s.replayPts = pts;
+    s.lastPts = pts;
+    s.audioSyncPending = s.audioCodecCtx != nullptr;
+}
+
+bool VideoPlayer::startRewindReplay(MediaSession &s)
+{
+    RewindCache::Frame f;
+    if (!m_rewindCache.frameAt(s.seekTarget, f)) return false;
+    beginReplay(s, f.image, f.pts);
+    return true;
+}
+
+/**
+ * @brief 预判快进已解码到 seek 目标附近：缩放这一帧立即显示，省去主解码器从关键帧追到目标的等待
+ */
+bool VideoPlayer::startSkipReplay(MediaSession &s)
+{
+    if (!s.skipPrefetch || isTrickRate(s.playRate)) return false;
+    AVFrame *f = s.skipPrefetch->take(s.seekTarget);
+    if (!f) return false;
+
+    // 分辨率或像素格式与主解码器不一致时（流中途变化）不能复用当前缩放器
+    bool ok = f->width == s.codecCtx->width && f->height == s.codecCtx->height
+              && f->format == s.codecCtx->pix_fmt;
+    if (ok) {
+        double pts = videoPtsToSeconds(s, f);
+        QImage img = scaleStill(s, f, pts);
+        m_rewindCache.add(img, pts);
+        beginReplay(s, img, pts);
+    }
+    av_frame_free(&f);
+    return ok;
+}
+
+/**
+ * @brief 每显示一帧更新预判快进的目标；播放稳定后才创建后台解码器，主解码落后时通知它让出 CPU
+ */
+void VideoPlayer::updateSkipPrefetch(MediaSession &s, double vpts, qint64 waitMs)
+{
+    if (!m_skipPrefetch.load()) {
+        s.skipPrefetch.reset();
+        return;
+    }
+    if (!s.skipPrefetch) {
+        // 网络流和慢盘上第二路读取会与主读取争抢带宽
+        if (s.network || s.prefetch || QThread::idealThreadCount() < SKIP_PREFETCH_MIN_CORES) return;
+        if (isTrickRate(s.playRate) || s.videoOutput != VideoVisible || playElapsedMs(s) < 1000) return;
+        s.skipPrefetch = std::make_unique<SkipPrefetcher>();
+        s.skipPrefetch->start(s.path, s.videoStreamIndex, s.codecCtx->codec_id);
+    }
+    if (waitMs < -SKIP_PREFETCH_LATE_MS) s.skipPrefetch->reportLate();
+    // 画面不可见时同样暂停准备，不为看不到的快进占用 CPU
+    bool idle = isTrickRate(s.playRate) || s.videoOutput != VideoVisible;
+    s.skipPrefetch->setTarget(idle ? -1.0 : vpts + SkipPrefetcher::SKIP_SEC);
+}
+
+/**
+ * @brief 连续播放时每 SAMPLE_INTERVAL_SEC 送检一帧原始解码帧（裁剪前），检测在后台线程进行
+ */
+void VideoPlayer::updateBarDetection(MediaSession &s, const AVFrame *vframe, double vpts)
+{
+    if (!m_autoCrop.load()) {
+        s.barDetector.reset();
+        return;
+    }
+    if (!s.barDetector) {
+        s.barDetector = std::make_unique<BarDetector>();
+        s.barDetector->start();
+        s.barSamplePts = -1.0;
+    }
+    // 向后 seek 后 pts 变小，同样按间隔重新开始
+    if (s.barSamplePts < 0.0 || std::abs(vpts - s.barSamplePts) >= BarDetector::SAMPLE_INTERVAL_SEC) {
+        s.barDetector->submit(vframe);
+        s.barSamplePts = vpts;
+    }
+    QRect crop;
+    if (s.barDetector->takeCrop(crop)) {
+        std::weak_ptr<const MediaSession> session = s.weak_from_this();
+        QMetaObject::invokeMethod(this, [this, session, crop]() { onBarsDetected(session, crop); }, Qt::QueuedConnection);
+    }
+}
+
+void VideoPlayer::pumpRewind(MediaSession &s)
+{
+    const double now = trickTargetPos(s);
+    double next = m_rewindCache.nextPts(s.replayPts);
+    if (next < 0.0 || next > now) return;
+
+    // 解码线程来不及时跳过中间的缓存帧，只显示最新到期的一帧
+    RewindCache::Frame f;
+    if (!m_rewindCache.frameAt(now, f) || f.pts <= s.replayPts) return;
+    s.replayPts = f.pts;
+    s.lastPts = f.pts;
+    postFrame(s, f.image, f.pts, false);
+}
+
+// ---------------- trick play (keyframe only) ----------------
+double VideoPlayer::trickTargetPos(const MediaSession &s)
+{
+    if (!s.playStarted) return s.playStartPts;
+    return s.playStartPts + playElapsedMs(s) / 1000.0 * s.playRate;
+}
+
+void VideoPlayer::reverseTrickStep(MediaSession &s)
+{
+    // 目标位置必须早于上一次显示的关键帧，否则 seek 会落回同一个关键帧
+    double target = trickTargetPos(s);
+    double lastPts = s.lastPts;
+    if (lastPts >= 0.0 && target > lastPts - 0.001)
+        target = lastPts - 0.001;
+    if (target < 0.0) target = 0.0;
+
+    int64_t ts = static_cast<int64_t>(target / av_q2d(s.videoTimeBase));
+    if (seekInput(s, s.videoStreamIndex, ts, AVSEEK_FLAG_BACKWARD) < 0) {
+        qWarning() << "Reverse trick seek failed at" << target;
+    }
+    avcodec_flush_buffers(s.codecCtx);
+
+    // 读到第一个视频关键帧为止，单独解码（送 nullptr 冲出帧）；有新命令时放弃
+    bool gotFrame = false;
+    while (!s.stop.load() && s.commands.empty()) {
+        int ret = readInput(s, s.packet, false);
+        if (ret == AVERROR(EAGAIN) && s.demuxer) {
+            s.demuxer->waitForData(50);
+            continue;
+        }
+        if (ret < 0) break;
+        bool isKey = s.packet->stream_index == s.videoStreamIndex && (s.packet->flags & AV_PKT_FLAG_KEY);
+        if (!isKey) {
+            av_packet_unref(s.packet);
             continue;
         }
+        avcodec_send_packet(s.codecCtx, s.packet);
+        av_packet_unref(s.packet);
+        avcodec_send_packet(s.codecCtx, nullptr);
+        gotFrame = avcodec_receive_frame(s.codecCtx, s.frame) == 0;
+        break;
+    }
+    avcodec_flush_buffers(s.codecCtx);
+    if (!gotFrame) return;
+
+    double vpts = videoPtsToSeconds(s, s.frame);
+    // 没有更早的关键帧：已退到开头，停在第一帧
+    if (lastPts >= 0.0 && vpts >= lastPts - 0.001) {
+        s.paused = true;
+        // 声卡与按钮状态只在主线程修改；之后又有 seek/换文件时请求过期
+        quint64 serial = s.outputSerial;
+        QMetaObject::invokeMethod(this, [this, serial]() {
+            if (serial == m_flushSerial.load() && !m_paused.load()) pause();
+        }, Qt::QueuedConnection);
+        return;
+    }
+    presentVideoFrame(s, s.frame);
+    av_frame_unref(s.frame);
+}
 
-        // 处理视频帧
-        if (packet->stream_index == videoStreamIndex) {
-            if (avcodec_send_packet(codecCtx, packet) == 0) {
-                while (avcodec_receive_frame(codecCtx, frame) == 0) {
-                    double vpts = 0.0;
-                    if (frame->pts != AV_NOPTS_VALUE)
-                        vpts = frame->pts * av_q2d(videoTimeBase);
-                    else if (frame->best_effort_timestamp != AV_NOPTS_VALUE)
-                        vpts = frame->best_effort_timestamp * av_q2d(videoTimeBase);
-
-                    int dstW = m_renderWidth.load();
-                    int dstH = m_renderHeight.load();
-                    if (dstW <= 0 || dstH <= 0) {
-                        dstW = codecCtx->width;
-                        dstH = codecCtx->height;
-                    }
+// ---------------- scrubbing (decode thread) ----------------
+void VideoPlayer::scrubStep(MediaSession &s)
+{
+    s.scrubPending = false;
+    clearStepWindow(s);                     // 解码器已离开逐帧窗口
+    if (!s.codecCtx) return;
+
+    const double target = s.scrubTarget;
+    int64_t ts = static_cast<int64_t>(target / av_q2d(s.videoTimeBase));
+    if (seekInput(s, s.videoStreamIndex, ts, AVSEEK_FLAG_BACKWARD) < 0) {
+        qWarning() << "Scrub seek failed at" << target;
+        return;
+    }
 
-                    // 重建 swsCtx（使用更快的缩放算法减少CPU占用）
-                    {
-                        QMutexLocker locker(&m_swsMutex);
-                        if (!swsCtx || m_swsCtxNeedReset.load()) {
-                            if (swsCtx) {
-                                sws_freeContext(swsCtx);
-                                swsCtx = nullptr;
-                            }
-
-                            int algo = m_scalingAlgo.load();
-                            swsCtx = sws_getContext(codecCtx->width, codecCtx->height, codecCtx->pix_fmt,
-                                                    dstW, dstH, AV_PIX_FMT_RGB24,
-                                                    algo, nullptr, nullptr, nullptr);
-                            if (!swsCtx) {
-                                // 降级到最快的算法
-                                swsCtx = sws_getContext(codecCtx->width, codecCtx->height, codecCtx->pix_fmt,
-                                                        dstW, dstH, AV_PIX_FMT_RGB24,
-                                                        SWS_FAST_BILINEAR, nullptr, nullptr, nullptr);
-                            }
-                            m_swsCtxNeedReset.store(false);
-                        }
-                    }
+    // 读到第一个视频关键帧，单独解码（送 nullptr 冲出帧）；有更新的预览位置时放弃
+    bool gotFrame = false;
+    while (!s.stop.load() && s.commands.empty()) {
+        int ret = readInput(s, s.packet, false);
+        if (ret == AVERROR(EAGAIN) && s.demuxer) {
+            s.demuxer->waitForData(50);
+            continue;
+        }
+        if (ret < 0) break;
+        bool isKey = s.packet->stream_index == s.videoStreamIndex && (s.packet->flags & AV_PKT_FLAG_KEY);
+        if (!isKey) {
+            av_packet_unref(s.packet);
+            continue;
+        }
+        // 拖动距离小于一个 GOP 时落在同一个关键帧上，画面不变
+        int64_t key = s.packet->pts != AV_NOPTS_VALUE ? s.packet->pts : s.packet->dts;
+        if (key != AV_NOPTS_VALUE && key == s.scrubKeyPts) {
+            av_packet_unref(s.packet);
+            break;
+        }
+        s.scrubKeyPts = key;
+
+        // 预览帧跳过环路滤波：4K HEVC 上单帧解码明显更快，画质损失在拖动中看不出
+        const AVDiscard loopFilter = s.codecCtx->skip_loop_filter;
+        s.codecCtx->skip_loop_filter = AVDISCARD_ALL;
+        avcodec_flush_buffers(s.codecCtx);
+        avcodec_send_packet(s.codecCtx, s.packet);
+        av_packet_unref(s.packet);
+        avcodec_send_packet(s.codecCtx, nullptr);
+        gotFrame = avcodec_receive_frame(s.codecCtx, s.frame) == 0;
+        avcodec_flush_buffers(s.codecCtx);
+        s.codecCtx->skip_loop_filter = loopFilter;
+        break;
+    }
+    if (!gotFrame) return;
 
-                    QImage img(dstW, dstH, QImage::Format_RGB888);
-                    uint8_t *dst[4] = { img.bits(), nullptr, nullptr, nullptr };
-                    int dst_linesize[4] = { static_cast<int>(img.bytesPerLine()), 0, 0, 0 };
+    double pts = videoPtsToSeconds(s, s.frame);
+    s.lastPts = pts;
+    postFrame(s, scaleStill(s, s.frame, pts), pts, false);
+    av_frame_unref(s.frame);
+}
 
-                    sws_scale(swsCtx, frame->data, frame->linesize, 0, codecCtx->height, dst, dst_linesize);
+// ---------------- frame stepping (decode thread) ----------------
+void VideoPlayer::executeStep(MediaSession &s)
+{
+    const int dir = s.stepRequest > 0 ? 1 : -1;
+    s.stepRequest -= dir;
+    if (!s.codecCtx) return;
+
+    // 第一次逐帧：解码器的状态（GOP 并行、已读到文件尾等）不可用，从 lastPts 重新建立窗口
+    if (!s.stepped) {
+        s.stepped = true;
+        clearStepWindow(s);
+    }
+    // 暂停时的 seek 要等恢复播放才执行，逐帧以它的目标为起点
+    if (s.seekPending) {
+        s.seekPending = false;
+        s.seekResume = false;
+        s.lastPts = s.seekTarget;
+        clearStepWindow(s);
+    }
+    s.finished = false;
 
-                    // 时间控制
-                    if (!m_playStarted) {
-                        m_playStartPts = vpts;
-                        m_playTimer.start();
-                        m_totalPausedMs.store(0);
-                        m_pauseStartMs = 0;
-                        m_playStarted = true;
-                    }
+    if (dir > 0) {
+        if (s.stepIndex + 1 < int(s.stepWindow.size())) ++s.stepIndex;
+        else if (!stepForwardDecode(s)) return;     // 文件尾
+    } else {
+        if (s.stepIndex > 0) --s.stepIndex;
+        else if (!stepBackwardDecode(s)) return;    // 已在第一帧
+    }
 
-                    qint64 elapsedMsRaw = m_playTimer.elapsed();
-                    qint64 totalPaused = m_totalPausedMs.load();
-                    if (m_pauseStartMs > 0) {
-                        qint64 now = m_playTimer.elapsed();
-                        elapsedMsRaw -= now - m_pauseStartMs;
-                    } else {
-                        elapsedMsRaw -= totalPaused;
-                    }
+    AVFrame *frame = s.stepWindow[s.stepIndex];
+    double pts = videoPtsToSeconds(s, frame);
+    s.lastPts = pts;
+    postFrame(s, scaleStill(s, frame, pts), pts, false);
+}
 
-                    double rate = m_playRate.load();
-                    qint64 targetMs = qint64((vpts - m_playStartPts) * 1000.0 / rate);
-                    qint64 waitMs = targetMs - elapsedMsRaw;
-                    if (waitMs > 0) {
-                        if (waitMs > 200) waitMs = 200;
-                        QThread::msleep(waitMs);
-                    }
+/**
+ * @brief 向前走出窗口：解码器紧接窗口末尾时只需再解码一帧；
+ * 否则定位到锚点所在的 GOP 重新解码，窗口为空时顺带保留锚点之前的帧供后退使用
+ */
+bool VideoPlayer::stepForwardDecode(MediaSession &s)
+{
+    AVFrame *frame = av_frame_alloc();
+    if (!frame) return false;
+    if (s.stepDecoderLive) {
+        if (readVideoFrame(s, frame)) {
+            pushStepFrame(s, frame, false);
+            s.stepIndex = int(s.stepWindow.size()) - 1;
+            return true;
+        }
+        s.stepDecoderLive = false;
+        av_frame_free(&frame);
+        return false;
+    }
 
-                    {
-                        QMutexLocker locker(&m_mutex);
-                        // 优化：只在队列过大时丢弃，而不是每帧都检查
-                        while (m_frameQueue.size() >= 20) m_frameQueue.dequeue();
-                        m_frameQueue.enqueue(std::make_pair(img, vpts));
-                    }
+    const bool keepBefore = s.stepWindow.empty();
+    const double anchor = keepBefore ? s.lastPts : videoPtsToSeconds(s, s.stepWindow.back());
+    seekVideo(s, anchor);
+    while (readVideoFrame(s, frame)) {
+        bool after = videoPtsToSeconds(s, frame) > anchor + 1e-3;
+        if (after || keepBefore) {
+            pushStepFrame(s, frame, false);
+            frame = av_frame_alloc();
+            if (!frame) return false;
+        } else {
+            av_frame_unref(frame);
+        }
+        if (after) {
+            av_frame_free(&frame);
+            s.stepIndex = int(s.stepWindow.size()) - 1;
+            s.stepDecoderLive = true;
+            return true;
+        }
+    }
+    av_frame_free(&frame);
+    return false;
+}
 
-                    emit frameReady(img);
-                    emit positionChanged(vpts);
+/**
+ * @brief 向后走出窗口：定位到窗口前端之前的关键帧，一次解码出锚点之前最多一个窗口的帧并放到窗口前面。
+ * 锚点本身就是关键帧时逐步向前多退一些再试
+ */
+bool VideoPlayer::stepBackwardDecode(MediaSession &s)
+{
+    const bool empty = s.stepWindow.empty();
+    const double anchor = empty ? s.lastPts : videoPtsToSeconds(s, s.stepWindow.front());
+    std::deque<AVFrame*> before;            // 锚点之前的帧，只保留最后一个窗口
+    AVFrame *current = nullptr;             // 窗口为空时锚点处的帧，之后向前走时复用
+    int capacity = STEP_MAX_FRAMES;
+
+    AVFrame *frame = av_frame_alloc();
+    for (double back = 0.0; frame && before.empty() && !s.stop.load(); back = back > 0.0 ? back * 2.0 : 1.0) {
+        const double target = std::max(0.0, anchor - 1e-3 - back);
+        seekVideo(s, target);
+        while (readVideoFrame(s, frame)) {
+            if (videoPtsToSeconds(s, frame) >= anchor - 1e-3) {
+                if (empty && !current) {
+                    current = frame;
+                    frame = av_frame_alloc();
+                } else {
+                    av_frame_unref(frame);
                 }
+                break;
             }
+            if (before.empty()) capacity = stepCapacity(GopParallelDecoder::frameBytes(frame));
+            before.push_back(frame);
+            if (int(before.size()) > capacity) {
+                av_frame_free(&before.front());
+                before.pop_front();
+            }
+            frame = av_frame_alloc();
+            if (!frame) break;
         }
+        if (target <= 0.0) break;           // 已从文件开头解码
+    }
+    av_frame_free(&frame);
+
+    if (before.empty()) {
+        av_frame_free(&current);
+        return false;
+    }
+    // 解码器停在锚点之后：窗口原本为空时它的下一帧正好接着 current
+    s.stepDecoderLive = empty && current;
+    s.stepIndex = -1;
+    const int count = int(before.size());
+    if (current) pushStepFrame(s, current, true);
+    while (!before.empty()) {
+        pushStepFrame(s, before.back(), true);
+        before.pop_back();
+    }
+    s.stepIndex = count - 1;
+    return true;
+}
 
-        av_packet_unref(packet);
+bool VideoPlayer::readVideoFrame(MediaSession &s, AVFrame *out)
+{
+    while (!s.stop.load()) {
+        int ret = avcodec_receive_frame(s.codecCtx, out);
+        if (ret == 0) return true;
+        if (ret != AVERROR(EAGAIN)) return false;   // 冲洗完毕
+        ret = readInput(s, s.packet, false);
+        if (ret == AVERROR(EAGAIN) && s.demuxer) {
+            s.demuxer->waitForData(50);
+            continue;
+        }
+        if (ret < 0) {
+            avcodec_send_packet(s.codecCtx, nullptr);
+            continue;
+        }
+        if (s.packet->stream_index == s.videoStreamIndex) {
+            avcodec_send_packet(s.codecCtx, s.packet);
+        } else if (s.subtitleCodecCtx && s.packet->stream_index == s.subtitleStreamIndex) {
+            decodeSubtitlePacket(s);
+        }
+        av_packet_unref(s.packet);
     }
+    return false;
+}
 
-    // 清理音频帧缓冲
-    for (auto f : audioFrameBatch) av_frame_free(&f);
-    audioFrameBatch.clear();
+void VideoPlayer::seekVideo(MediaSession &s, double pos)
+{
+    int64_t ts = static_cast<int64_t>(pos / av_q2d(s.videoTimeBase));
+    if (seekInput(s, s.videoStreamIndex, ts, AVSEEK_FLAG_BACKWARD) < 0) {
+        qWarning() << "Step seek failed at" << pos;
+    }
+    avcodec_flush_buffers(s.codecCtx);
+    s.stepDecoderLive = false;
+}
 
-    {
-        QMutexLocker locker(&m_swsMutex);
-        if (swsCtx) {
-            sws_freeContext(swsCtx);
-            swsCtx = nullptr;
+void VideoPlayer::pushStepFrame(MediaSession &s, AVFrame *frame, bool front)
+{
+    qint64 bytes = GopParallelDecoder::frameBytes(frame);
+    if (front) {
+        s.stepWindow.push_front(frame);
+        if (s.stepIndex >= 0) ++s.stepIndex;
+    } else {
+        s.stepWindow.push_back(frame);
+    }
+    s.stepWindowBytes += bytes;
+    m_memory.acquire(MemoryBudget::StepFrames, bytes);
+
+    // 从远离插入的一端淘汰，当前帧（stepIndex 有效时）始终保留
+    const int capacity = stepCapacity(bytes);
+    while (int(s.stepWindow.size()) > capacity) {
+        AVFrame *old;
+        if (front) {
+            if (s.stepIndex == int(s.stepWindow.size()) - 1) break;
+            old = s.stepWindow.back();
+            s.stepWindow.pop_back();
+            s.stepDecoderLive = false;      // 窗口末尾不再紧接解码器
+        } else {
+            if (s.stepIndex == 0) break;
+            old = s.stepWindow.front();
+            s.stepWindow.pop_front();
+            if (s.stepIndex > 0) --s.stepIndex;
         }
+        qint64 oldBytes = GopParallelDecoder::frameBytes(old);
+        s.stepWindowBytes -= oldBytes;
+        m_memory.release(MemoryBudget::StepFrames, oldBytes);
+        av_frame_free(&old);
     }
-    // cleanup audio filter on exit
-    QMutexLocker filterLocker(&m_audioFilterMutex);
-    cleanupAudioFilter();
+}
+
+int VideoPlayer::stepCapacity(qint64 frameBytes) const
+{
+    if (frameBytes <= 0) return STEP_MAX_FRAMES;
+    return int(std::clamp<qint64>(m_memory.quota(MemoryBudget::StepFrames) / frameBytes, STEP_MIN_FRAMES, STEP_MAX_FRAMES));
+}
+
+void VideoPlayer::clearStepWindow(MediaSession &s)
+{
+    for (AVFrame *f : s.stepWindow) av_frame_free(&f);
+    s.stepWindow.clear();
+    m_memory.release(MemoryBudget::StepFrames, s.stepWindowBytes);
+    s.stepWindowBytes = 0;
+    s.stepIndex = -1;
+    s.stepDecoderLive = false;
 }
 
 // ---------------- flushAudioBuffer (main thread) ----------------
 void VideoPlayer::flushAudioBuffer()
 {
-    if (!audioIODevice) return;
+    // 没有可用的声卡输出时直接丢弃，避免解码线程因 PCM 配额用尽而停住
+    if (!audioIODevice || !audioSink) {
+        clearAudioQueue();
+        return;
+    }
+    // seek 之前解码出的 PCM 无论是否暂停、声卡是否有空间都先丢弃，让出配额
+    dropStaleAudio();
     if (m_paused.load()) return;
 
-    QByteArray all;
-    {
-        QMutexLocker locker(&m_audioQueueMutex);
-        if (m_audioQueue.empty()) return;
-        for (const QByteArray &b : m_audioQueue) all.append(b);
-        m_audioQueue.clear();
-    }
+    // 只写入声卡缓冲能容纳的部分，其余留在队列下次再写
+    // （GOP 并行解码时读包会超前于显示，音频队列可能积累数秒）
+    int frameBytes = 2 * m_audioOutChannels; // s16
+    qint64 room = audioSink->bytesFree();
+    room -= room % frameBytes;
+    if (room <= 0) return;
 
-    if (all.isEmpty()) return;
+    // 环形缓冲中的数据直接写入声卡设备
+    qint64 written = m_audioRing.readInto(audioIODevice, room);
+    m_memory.release(MemoryBudget::AudioPcm, written);
 
-    qint64 written = audioIODevice->write(all);
     if (written > 0) {
         int bytesPerSample = 2; // s16
         long long samplesWritten = written / (bytesPerSample * m_audioOutChannels);
@@ -769,112 +2395,341 @@ void VideoPlayer::flushAudioBuffer()
 }
 
 // ---------------- clear / free ----------------
+// 只在主线程调用。按实际清除的字节释放配额，与解码线程的记账不会互相覆盖
+void VideoPlayer::clearAudioQueue()
+{
+    m_memory.release(MemoryBudget::AudioPcm, m_audioRing.clear());
+}
+
+void VideoPlayer::dropStaleAudio()
+{
+    m_memory.release(MemoryBudget::AudioPcm, m_audioRing.dropStale(m_flushSerial.load()));
+}
+
 void VideoPlayer::clearQueue()
 {
-    QMutexLocker locker(&m_mutex);
-    m_frameQueue.clear();
-    QMutexLocker aLocker(&m_audioQueueMutex);
-    m_audioQueue.clear();
+    clearAudioQueue();
     m_audioPlayedSamples.store(0);
     m_audioBasePts.store(-1.0);
-    m_totalPausedMs.store(0);
-    m_pauseStartMs = 0;
 }
 
-void VideoPlayer::freeFFmpegResources()
+/**
+ * @brief 当前播放位置：优先使用最近显示的视频帧 pts，其次使用音频播放进度。
+ * 纯音频模式没有显示的帧，优先使用音频播放进度（快进模式静音，仍以关键帧为准）
+ */
+double VideoPlayer::currentPosition() const
 {
-    if (packet) { av_packet_free(&packet); packet = nullptr; }
-    if (frame) { av_frame_free(&frame); frame = nullptr; }
-    if (swrCtx) { swr_free(&swrCtx); swrCtx = nullptr; }
-    if (codecCtx) { avcodec_free_context(&codecCtx); codecCtx = nullptr; }
-    if (audioCodecCtx) { avcodec_free_context(&audioCodecCtx); audioCodecCtx = nullptr; }
-    if (fmtCtx) { avformat_close_input(&fmtCtx); fmtCtx = nullptr; }
-    if (swsCtx) { sws_freeContext(swsCtx); swsCtx = nullptr; }
-    QMutexLocker filterLocker(&m_audioFilterMutex);
-    cleanupAudioFilter();
+    const bool audioClock = m_videoOutput == VideoOff && !m_trickPlay;
+    double pos = m_lastPresentedPts.load();
+    if (pos >= 0.0 && !audioClock) return pos;
+
+    double base = m_audioBasePts.load();
+    long long playedSamples = m_audioPlayedSamples.load();
+    int sr = m_audioSampleRate > 0 ? m_audioSampleRate : 48000;
+    // 声卡按输出样本计数，变速时每个样本对应 m_playRate 倍的媒体时长
+    if (base >= 0.0) return base + double(playedSamples) / double(sr) * m_playRate;
+
+    return pos >= 0.0 ? pos : 0.0;
+}
+
+void VideoPlayer::setMemoryLimit(qint64 bytes)
+{
+    m_memory.setLimit(bytes);
+    qDebug() << "Memory limit set to" << bytes / (1024 * 1024) << "MB";
+}
+
+void VideoPlayer::setReadAhead(bool always, int windowMB)
+{
+    m_readAheadAlways = always;
+    m_readAheadMB = windowMB;
+}
+
+void VideoPlayer::setSkipPrefetch(bool enabled)
+{
+    // 解码线程在下一次显示帧时创建或释放后台解码器
+    m_skipPrefetch.store(enabled);
+    qDebug() << "Skip prefetch:" << enabled;
+}
+
+void VideoPlayer::setSurfaceVisible(bool visible)
+{
+    if (m_surfaceVisible == visible) return;
+    m_surfaceVisible = visible;
+    applyVideoOutput();
+}
+
+void VideoPlayer::setAudioOnly(bool enabled)
+{
+    if (m_audioOnly == enabled) return;
+    m_audioOnly = enabled;
+    applyVideoOutput();
+}
+
+/**
+ * @brief 投递新的画面输出方式（主线程）。不可见只省掉缩放和非参考帧，恢复可见时解码器可直接接续；
+ * 纯音频期间视频包被丢弃，离开时在声卡位置精确 seek，让解码器从关键帧重新追上
+ */
+void VideoPlayer::applyVideoOutput()
+{
+    int mode = m_audioOnly ? VideoOff : m_surfaceVisible ? VideoVisible : VideoHidden;
+    if (mode == m_videoOutput) return;
+
+    const bool resync = m_videoOutput == VideoOff;
+    double pos = currentPosition();     // 仍按旧模式取位置
+    m_videoOutput = mode;
+    post({PlayerCommand::VideoOutput, 0, 0.0, mode});
+    if (mode == VideoOff) m_positionTimer->start();
+    else m_positionTimer->stop();
+    if (resync && m_session && m_session->thread) seek(pos, true);
+    qDebug() << "Video output:" << mode;
+}
+
+void VideoPlayer::setDeinterlace(int mode)
+{
+    if (m_filterConfig.deinterlace == mode) return;
+    m_filterConfig.deinterlace = mode;
+    postVideoFilter();
+}
+
+void VideoPlayer::setAutoRotate(bool enabled)
+{
+    if (m_filterConfig.autoRotate == enabled) return;
+    m_filterConfig.autoRotate = enabled;
+    postVideoFilter();
+}
+
+void VideoPlayer::setCrop(const QRect &rect)
+{
+    if (m_filterConfig.crop == rect) return;
+    m_filterConfig.crop = rect;
+    postVideoFilter();
+}
+
+/**
+ * @brief 滤镜配置整体投递，解码线程在下一帧按新配置重建滤镜图
+ */
+void VideoPlayer::postVideoFilter()
+{
+    const VideoFilter::Config config = effectiveFilterConfig();
+    PlayerCommand cmd{PlayerCommand::VideoFilter, 0, 0.0, config.deinterlace, config.autoRotate ? 1 : 0};
+    cmd.rect = config.crop;
+    post(cmd);
+    qDebug() << "Video filter: deinterlace" << config.deinterlace << "autoRotate" << config.autoRotate
+             << "crop" << config.crop;
+}
+
+VideoFilter::Config VideoPlayer::effectiveFilterConfig() const
+{
+    VideoFilter::Config config = m_filterConfig;
+    if (config.crop.isEmpty() && m_autoCrop.load()) config.crop = m_autoCropRect;
+    return config;
+}
+
+void VideoPlayer::setAutoCrop(bool enabled)
+{
+    // 解码线程在下一次显示帧时创建或释放检测线程；已有结论立即生效或撤销
+    if (m_autoCrop.exchange(enabled) == enabled) return;
+    if (!m_autoCropRect.isEmpty() && m_filterConfig.crop.isEmpty()) postVideoFilter();
+    qDebug() << "Auto crop:" << enabled;
+}
+
+/**
+ * @brief 黑边检测结论：与其他滤镜配置一样由主线程投递，界面随即按新的显示尺寸更新渲染尺寸，
+ *        两条命令在解码线程的同一次 drainCommands 中生效，不会有按旧比例缩放的过渡帧
+ */
+void VideoPlayer::onBarsDetected(const std::weak_ptr<const MediaSession> &s, const QRect &crop)
+{
+    if (!isCurrentSession(s) || m_autoCropRect == crop) return;
+    m_autoCropRect = crop;
+    if (!m_autoCrop.load() || !m_filterConfig.crop.isEmpty()) return;
+    postVideoFilter();
+    emit displaySizeChanged();
+}
+
+void VideoPlayer::setRewindCacheSeconds(int seconds)
+{
+    m_rewindCache.setWindow(seconds);
+    qDebug() << "Rewind cache:" << seconds << "s";
 }
 
 void VideoPlayer::forward(double seconds)
 {
-    if (!fmtCtx || videoStreamIndex < 0) return;
+    if (!m_session) return;
 
-    const AVStream* vs = fmtCtx->streams[videoStreamIndex];
-    double durationSec = vs->duration * av_q2d(vs->time_base);
+    const AVStream* vs = m_session->fmtCtx->streams[m_session->videoStreamIndex];
+    // 流时长未知（部分网络流）时用容器时长，仍未知则不限制上界
+    double durationSec = vs->duration > 0 ? vs->duration * av_q2d(vs->time_base) : duration();
 
-    double currentPos = 0.0;
-    {
-        QMutexLocker locker(&m_mutex);
-        if (!m_frameQueue.isEmpty()) {
-            currentPos = m_frameQueue.back().second;
-        }
-    }
-    double newPos = currentPos + seconds;
+    double newPos = currentPosition() + seconds;
     if (newPos < 0.0) newPos = 0.0;
-    if (newPos > durationSec) newPos = durationSec;
+    if (durationSec > 0.0 && newPos > durationSec) newPos = durationSec;
 
     seek(newPos);
 }
 
 void VideoPlayer::setPlayRate(double rate)
 {
-    if (rate <= 0.0) return;
+    if (std::abs(rate) < 1e-6) return;
 
-    double oldRate = m_playRate.load();
+    double oldRate = m_playRate;
     if (std::abs(oldRate - rate) < 1e-6) return;
 
-    // 1) 更新原子值（让 decodeLoop 看到新速率）
-    m_playRate.store(rate);
+    bool wasTrick = isTrickRate(oldRate);
+    bool trick = isTrickRate(rate);
 
-    // 2) 计算当前播放位置（优先使用最近视频帧 pts，其次使用音频播放进度）
-    double currentPos = 0.0;
-    bool havePos = false;
-    {
-        QMutexLocker locker(&m_mutex);
-        if (!m_frameQueue.isEmpty()) {
-            currentPos = m_frameQueue.back().second;
-            havePos = true;
-        }
-    }
-    if (!havePos) {
-        double base = m_audioBasePts.load();
-        long long playedSamples = m_audioPlayedSamples.load();
-        int sr = m_audioSampleRate > 0 ? m_audioSampleRate : 48000;
-        if (base >= 0.0) {
-            currentPos = base + double(playedSamples) / double(sr);
-            havePos = true;
-        }
-    }
-    if (!havePos) {
-        // fallback 使用已有的 playStartPts
-        currentPos = m_playStartPts;
-    }
-
-    // 3) 重置播放时间基（保证视频等待逻辑在速率切换时平滑）
-    m_playStartPts = currentPos;
-    m_playTimer.restart();
-    m_totalPausedMs.store(0);
-    m_pauseStartMs = 0;
-    m_playStarted = true;
+    // 1) 记录新速率；解码线程在执行 SetRate 命令时从当前位置重建时间基并原地修改 atempo
+    double currentPos = currentPosition();     // 按旧速率换算音频进度
+    m_playRate = rate;
+    post({PlayerCommand::SetRate, 0, rate});
 
-    // 4) 清空音频队列并重置音频基点（避免旧缓冲在新速率下播放出错）
-    {
-        QMutexLocker aLocker(&m_audioQueueMutex);
-        m_audioQueue.clear();
+    // 退出快进/快退：从当前位置重新 seek，让音频和全量解码重新对齐
+    if (wasTrick && !trick) {
+        m_trickPlay = false;
+        if (audioSink && !m_paused.load()) audioSink->resume();
+        seek(currentPos);
+        qDebug() << "setPlayRate: leave trick play at" << currentPos << "rate" << rate;
+        return;
     }
+
+    // 2) 重置音频基点；已排队的 PCM 照常播放，新速率无缝接上
     m_audioBasePts.store(currentPos);
     m_audioPlayedSamples.store(0);
 
-    // 5) 请求在解码线程重建 audio filter（安全）
-    m_audioFilterNeedReset.store(true);
+    // 进入快进/快退：静音，解码线程切换到仅关键帧
+    if (trick) {
+        if (audioSink) audioSink->suspend();
+        m_trickPlay = true;
+        qDebug() << "setPlayRate: trick play from" << oldRate << "to" << rate << "currentPos" << currentPos;
+        return;
+    }
 
     qDebug() << "setPlayRate: from" << oldRate << "to" << rate << "currentPos" << currentPos;
 }
 
+void VideoPlayer::setGopParallelDecoding(bool enabled)
+{
+    if (m_gopParallel.exchange(enabled) == enabled) return;
+    qDebug() << "GOP parallel decoding:" << enabled;
+
+    // 播放中切换：在当前位置 seek 一次，让解码线程在关键帧处换引擎
+    if (!m_session || !m_session->thread) return;
+    seek(currentPosition());
+}
+
 void VideoPlayer::setRenderSize(int w, int h)
 {
     if (w <= 0 || h <= 0) return;
 
-    m_renderWidth.store(w);
-    m_renderHeight.store(h);
-    m_swsCtxNeedReset.store(true);
+    m_renderWidth = w;
+    m_renderHeight = h;
+    post({PlayerCommand::Resize, 0, 0.0, w, h});
+}
+
+void VideoPlayer::setScalingAlgorithm(int algo)
+{
+    m_scalingAlgo = algo;
+    post({PlayerCommand::ScalingAlgorithm, 0, 0.0, algo});
+}
+
+QList<VideoPlayer::AudioTrack> VideoPlayer::audioTracks() const
+{
+    return m_session ? m_session->audioTracks : QList<AudioTrack>();
+}
+
+/**
+ * @brief 切换音轨（主线程）。只在当前文件有音频输出时可用，
+ * 播放中在当前位置 seek 一次，已排队的旧音轨 PCM 随之作废
+ */
+void VideoPlayer::setAudioTrack(int streamIndex)
+{
+    if (!m_session || m_audioTrack < 0 || streamIndex == m_audioTrack) return;
+    bool known = std::any_of(m_session->audioTracks.cbegin(), m_session->audioTracks.cend(),
+                             [streamIndex](const AudioTrack &t) { return t.streamIndex == streamIndex; });
+    if (!known) return;
+
+    m_audioTrack = streamIndex;
+    post({PlayerCommand::AudioTrack, 0, 0.0, streamIndex});
+    if (m_session->thread) seek(currentPosition());
+}
+
+QList<VideoPlayer::SubtitleStream> VideoPlayer::subtitleStreams() const
+{
+    return m_session ? m_session->subtitleStreams : QList<SubtitleStream>();
+}
+
+/**
+ * @brief 切换字幕（主线程）。嵌入流此前在解复用层被丢弃，播放中在当前位置 seek 一次，
+ * 让正在显示的字幕包重新读到
+ */
+void VideoPlayer::setSubtitle(int selection)
+{
+    if (!m_session || selection == m_subtitle) return;
+    if (selection == SUBTITLE_EXTERNAL && !m_externalSubtitle) return;
+    if (selection >= 0) {
+        bool known = std::any_of(m_session->subtitleStreams.cbegin(), m_session->subtitleStreams.cend(),
+                                 [selection](const SubtitleStream &t) { return t.streamIndex == selection; });
+        if (!known) return;
+    } else if (selection != SUBTITLE_OFF && selection != SUBTITLE_EXTERNAL) {
+        return;
+    }
+
+    m_subtitle = selection;
+    PlayerCommand cmd{PlayerCommand::Subtitle, 0, 0.0, selection};
+    if (selection == SUBTITLE_EXTERNAL) cmd.subtitle = m_externalSubtitle;
+    post(cmd);
+    if (selection >= 0 && m_session->thread) seek(currentPosition());
+}
+
+bool VideoPlayer::loadSubtitleFile(const QString &path)
+{
+    if (!m_session) return false;
+    auto track = std::make_shared<SubtitleTrack>();
+    if (!track->loadFile(path)) {
+        qWarning() << "Failed to load subtitle:" << path;
+        return false;
+    }
+    m_externalSubtitle = track;
+    m_externalSubtitleName = track->name();
+    m_subtitle = SUBTITLE_EXTERNAL;
+    post({PlayerCommand::Subtitle, 0, 0.0, SUBTITLE_EXTERNAL, 0, track});
+    return true;
+}
+
+quint64 VideoPlayer::decodeWakeups() const
+{
+    return m_session ? m_session->wakeups.load(std::memory_order_relaxed) : 0;
+}
+
+VideoPlayer::DemuxStats VideoPlayer::demuxStats() const
+{
+    DemuxStats d;
+    d.packetBytesPerSec = m_demuxPacketRate.load();
+    d.ioBytesPerSec = m_demuxIoRate.load();
+    if (m_session && m_session->fmtCtx) {
+        d.totalStreams = int(m_session->fmtCtx->nb_streams);
+        d.activeStreams = m_session->videoStreamIndex >= 0 ? 1 : 0;
+        if (m_audioTrack >= 0) ++d.activeStreams;
+        if (m_subtitle >= 0) ++d.activeStreams;
+    }
+    if (m_session && m_session->prefetch) {
+        PrefetchIO::Stats io = m_session->prefetch->stats();
+        d.ioStalls = io.stalls;
+        d.ioStallMs = io.stallUs / 1000;
+    }
+    if (m_session && m_session->demuxer) {
+        NetworkDemuxer::Stats net = m_session->demuxer->stats();
+        d.bufferedSec = net.bufferedSec;
+        d.rebuffers = net.rebuffers;
+        d.reconnects = net.reconnects;
+    }
+    return d;
+}
+
+void VideoPlayer::setTimeStretchEngine(int engine)
+{
+    if (engine != StretchAtempo && engine != StretchWsola) return;
+    if (m_stretchEngine == engine) return;
+    qDebug() << "Time-stretch engine:" << (engine == StretchWsola ? "WSOLA" : "atempo");
+    m_stretchEngine = engine;
+    post({PlayerCommand::TimeStretchEngine, 0, 0.0, engine});
 }
@@ -1,12 +1,16 @@
 #pragma once
 #include <QObject>
 #include <QImage>
-#include <QQueue>
 #include <QMutex>
+#include <QWaitCondition>
+#include <QThreadPool>
 #include <QAtomicInt>
 #include <QString>
 #include <utility>
 #include <atomic>
+#include <memory>
+#include <future>
+#include <deque>
 #include <QTimer>
 #include <QAudioSink>
 #include <QAudioFormat>
@@ -15,6 +19,23 @@
 #include <QList>
 #include <QByteArray>
 
+#include "gopdecoder.h"
+#include "memorybudget.h"
+#include "playercommand.h"
+#include "audioringbuffer.h"
+#include "timestretcher.h"
+#include "subtitletrack.h"
+#include "subtitlerenderer.h"
+#include "probesnapshot.h"
+#include "startuptrace.h"
+#include "mappedfileio.h"
+#include "prefetchio.h"
+#include "networkdemuxer.h"
+#include "rewindcache.h"
+#include "skipprefetcher.h"
+#include "videofilter.h"
+#include "bardetector.h"
+
 extern "C" {
 #include <libavformat/avformat.h>
 #include <libavcodec/avcodec.h>
@@ -36,14 +57,24 @@ public:
     explicit VideoPlayer(QObject *parent = nullptr);
     ~VideoPlayer();
 
-    bool openFile(const QString &filePath);
+    bool openFile(const QString &filePath);          // 同步打开，会阻塞调用线程
+    void openFileAsync(const QString &filePath);     // 工作线程中打开，完成后发出 openFinished
+    void cancelOpen();                               // 取消尚未完成的异步打开
+    bool isOpening() const { return m_pendingOpen != nullptr; }
     void play();
     void pause();
     void stop();
-    void seek(double positionSec);
+    void seek(double positionSec, bool exact = false);   // exact：从关键帧解码到目标，之前的帧不显示
+    // 拖动进度条：拖动中只显示目标处最近的关键帧（限速，过期的位置直接丢弃），松开时精确定位
+    void scrubTo(double positionSec);
+    void endScrub(double positionSec);
 
     void forward(double seconds);
+    void stepFrame(int direction);      // 逐帧：暂停并向前（>0）或向后（<0）移动一帧
+    // rate < 0 为快退；|rate| 超过 TRICK_PLAY_MIN_RATE 或倒放时进入仅关键帧的快进/快退模式（静音）
     void setPlayRate(double rate);
+    static constexpr double TRICK_PLAY_MIN_RATE = 4.0;
+    static bool isTrickRate(double rate) { return rate < 0.0 || rate > TRICK_PLAY_MIN_RATE; }
 
     void setRenderSize(int w, int h);
     // 优化：设置视频缩放算法（权衡质量和性能）
@@ -52,7 +83,87 @@ public:
     // SWS_BICUBIC - 较好质量
     // SWS_LANCZOS - 最好质量但最慢（默认不用）
     const QVector<int> scalingAlgorithm = {SWS_FAST_BILINEAR,SWS_BILINEAR,SWS_BICUBIC,SWS_LANCZOS};
-    void setScalingAlgorithm(int algo) { m_scalingAlgo.store(algo); m_swsCtxNeedReset.store(true); }
+    void setScalingAlgorithm(int algo);
+    // GOP 并行解码：多个解码器实例同时解码不同 GOP，用于弱编解码器的 2x~3x 全帧播放
+    void setGopParallelDecoding(bool enabled);
+    // 变速音频的时间伸缩引擎：FFmpeg atempo 链（s16），或内置 WSOLA（float，单级覆盖全部倍速）
+    enum TimeStretchEngine { StretchAtempo = 0, StretchWsola = 1 };
+    void setTimeStretchEngine(int engine);
+
+    // 音轨：未选中的音轨在解复用层丢弃；切换不重新打开文件，在当前位置重新同步
+    struct AudioTrack {
+        int streamIndex = -1;
+        QString language;
+        QString title;
+        QString codec;
+        int channels = 0;
+        int sampleRate = 0;
+    };
+    QList<AudioTrack> audioTracks() const;
+    int currentAudioTrack() const { return m_audioTrack; }     // 流序号，-1 表示没有音频
+    void setAudioTrack(int streamIndex);
+
+    // 字幕：嵌入字幕流或外挂 .srt/.ass/.ssa，打开文件时自动加载同名外挂字幕
+    struct SubtitleStream {
+        int streamIndex = -1;
+        QString language;
+        QString title;
+        QString codec;
+    };
+    static constexpr int SUBTITLE_OFF = -1;
+    static constexpr int SUBTITLE_EXTERNAL = -2;
+    QList<SubtitleStream> subtitleStreams() const;
+    int currentSubtitle() const { return m_subtitle; }     // 流序号，或 SUBTITLE_OFF / SUBTITLE_EXTERNAL
+    QString externalSubtitleName() const { return m_externalSubtitleName; }
+    void setSubtitle(int selection);
+    bool loadSubtitleFile(const QString &path);             // 加载并切换到外挂字幕
+
+    // 解复用吞吐（最近约 1 秒）：packet 为交给播放器的包字节，io 为 AVIOContext 实际读取的字节
+    struct DemuxStats {
+        qint64 packetBytesPerSec = 0;
+        qint64 ioBytesPerSec = 0;
+        int activeStreams = 0;      // 未被 AVDISCARD_ALL 丢弃的流
+        int totalStreams = 0;
+        qint64 ioStalls = 0;        // 预读 I/O：解码线程等待磁盘的次数与累计时长
+        qint64 ioStallMs = 0;
+        double bufferedSec = 0.0;   // 网络流：已缓冲的时长、中途缓冲次数与重连次数
+        qint64 rebuffers = 0;
+        qint64 reconnects = 0;
+    };
+    DemuxStats demuxStats() const;
+
+    QString startupReport() const { return m_startupReport; }  // 最近一次起播的分段耗时
+
+    // 空闲诊断：解码循环执行的轮数（暂停、文件尾时每一轮都对应一次唤醒）与音频刷新定时器是否在运行
+    quint64 decodeWakeups() const;
+    bool audioFlushActive() const { return m_audioFlushTimer && m_audioFlushTimer->isActive(); }
+
+    // 网络流：缓冲低于低水位时发出 buffering()，时钟与声卡暂停，回到高水位后发出 bufferingFinished()
+    bool isBuffering() const { return m_buffering; }
+    int bufferingPercent() const;
+    double duration() const;                    // 秒，直播流等未知时长返回 0
+    QSize videoSize() const;                    // 解码器输出的原始尺寸
+    QSize displaySize() const;                  // 经过旋转与裁剪后的显示尺寸，界面据此计算渲染尺寸
+    static bool isNetworkUrl(const QString &path) { return NetworkDemuxer::isNetworkUrl(path); }
+
+    // 内存预算：PCM/压缩包/解码帧等所有缓冲共享的字节上限，report 给出各队列高水位
+    void setMemoryLimit(qint64 bytes);
+    // 预读 I/O：网络路径总是使用，always 时本地文件也使用（机械硬盘）；下次打开文件时生效
+    void setReadAhead(bool always, int windowMB);
+    void setRewindCacheSeconds(int seconds);    // 0 关闭快退缓存
+    void setSkipPrefetch(bool enabled);         // 空闲时提前解码 +10 秒处的画面
+    // 画面输出：显示目标不可见（最小化/遮挡）时不缩放不显示、只解码参考帧；纯音频模式丢弃整个视频流
+    enum VideoOutputMode { VideoVisible = 0, VideoHidden = 1, VideoOff = 2 };
+    void setSurfaceVisible(bool visible);
+    void setAudioOnly(bool enabled);
+    // 视频滤镜：去隔行（VideoFilter::Deinterlace）、按显示矩阵自动旋转、裁剪（解码尺寸下的区域，空为不裁剪）
+    void setDeinterlace(int mode);
+    void setAutoRotate(bool enabled);
+    void setCrop(const QRect &rect);
+    // 自动裁黑边：后台检测出的稳定区域在没有手动裁剪时生效，缩放与渲染尺寸都只按有效画面计算
+    void setAutoCrop(bool enabled);
+    QString memoryReport() const { return m_memory.report(); }
+    double currentPosition() const;
 
 signals:
     void frameReady(const QImage &img);
@@ -60,91 +171,321 @@ signals:
     void finished();
     void playingChanged(bool playing);
     void buffering();
+    void bufferingFinished();
+    void openFinished(bool ok, const QString &filePath);
+    void displaySizeChanged();                  // 自动裁黑边改变了显示尺寸，界面应重新计算渲染尺寸
 
 private slots:
     void flushAudioBuffer();
+    void startAudioOutput();                    // 创建并启动 QAudioSink，起播时推迟到首帧显示之后
+    void onPlaybackFinished(quint64 serial);    // 解码线程读到文件尾后排队到主线程执行
 
 private:
-    void decodeLoop();
+    // 一个已打开文件的全部 FFmpeg 资源及其解码线程。解码线程只通过它访问这些资源，
+    // stop() 把它整体交给回收线程等待线程退出并释放，主线程不再阻塞，新文件可以立即开始。
+    // 解码线程发给主线程的通知携带它的 weak_ptr，按所有权判断是否仍是当前会话
+    struct MediaSession : std::enable_shared_from_this<MediaSession> {
+        MediaSession();
+        ~MediaSession();                        // 等待解码线程退出后释放全部资源
+        void requestStop();                     // 置位停止并唤醒所有等待，任意线程可调用
+        void sleepFor(int ms);                  // 可被 requestStop 打断的睡眠
+        void waitForCommand();                  // 无超时阻塞，直到有新命令或停止
+        void wake();                            // 投递命令后调用，唤醒 waitForCommand/sleepFor
+        void setGopDecoder(GopParallelDecoder *gop);    // 登记解码线程当前的 GOP 引擎，stop 时唤醒
+
+        QString path;
+        std::atomic<bool> stop{false};          // 同时作为中断回调的标志
+        std::atomic<quint64> wakeups{0};        // 解码循环的轮数，暂停期间应保持不变
+        AVFormatContext *fmtCtx = nullptr;
+        std::unique_ptr<MappedFileIO> io;       // 本地文件的映射 I/O，成员析构晚于析构函数体中的 avformat_close_input
+        std::unique_ptr<PrefetchIO> prefetch;   // 慢盘/网络盘的预读 I/O，与 io 二选一
+        bool network = false;                   // URL 输入，经 demuxer 的缓冲读取
+        std::unique_ptr<NetworkDemuxer> demuxer;    // 析构函数中先于 avformat_close_input 释放
+        bool buffering = false;                 // 解码线程当前是否在等待网络缓冲
+        bool readAheadAlways = false;
+        int readAheadMB = 32;
+        bool probeReused = false;               // 套用了列表加载时的探测快照，未执行 find_stream_info
+        AVCodecContext *codecCtx = nullptr;
+        AVCodecContext *audioCodecCtx = nullptr;
+        int videoStreamIndex = -1;
+        int audioStreamIndex = -1;
+        AVRational videoTimeBase{0,1};
+        AVRational audioTimeBase{0,1};
+        int audioOutRate = 0;                   // 输出采样率，固定为首个音轨的采样率，换音轨时重采样到它
+        QList<AudioTrack> audioTracks;          // 打开后只读
+
+        // 字幕
+        int subtitleStreamIndex = -1;           // 正在解码的嵌入字幕流
+        AVCodecContext *subtitleCodecCtx = nullptr;
+        QList<SubtitleStream> subtitleStreams;  // 打开后只读
+        int subtitleSelection = SUBTITLE_OFF;   // openMedia 选定的初始字幕
+        std::shared_ptr<SubtitleTrack> externalSubtitle;    // openMedia 自动加载的同名外挂字幕
+        std::shared_ptr<SubtitleTrack> subtitles;           // 正在显示的字幕，解码线程独占
+        SubtitleRenderer subtitleRenderer;
+
+        // 以下只在解码线程使用
+        AVFrame *frame = nullptr;
+        AVPacket *packet = nullptr;
+        AVFrame *audioFrame = nullptr;          // 解码输出，送入 filter 后即被重置，循环复用
+        AVFrame *filteredFrame = nullptr;       // filter 输出，拷入 PCM 缓冲后复用
+        SwsContext *swsCtx = nullptr;
+        int swsSrcWidth = 0;                    // swsCtx 建立时的源尺寸与格式，滤镜输出变化时重建
+        int swsSrcHeight = 0;
+        int swsSrcFormat = -1;
+        VideoFilter videoFilter;                // 解码与缩放之间的去隔行/旋转/裁剪
+        double videoRotation = 0.0;             // 流的显示矩阵，打开后只读
+        AVFilterGraph *audioFilterGraph = nullptr;
+        AVFilterContext *audioBufferSrcCtx = nullptr;
+        AVFilterContext *audioBufferSinkCtx = nullptr;
+
+        // 控制状态：主线程只投递命令，以下字段只由解码线程在 drainCommands 中修改
+        CommandQueue commands;
+        quint64 outputSerial = 0;               // 当前输出所属的 seek 命令序号
+        bool paused = false;
+        bool finished = false;                  // 已读到文件尾，等待 seek
+        bool seekPending = false;
+        double seekTarget = 0.0;
+        double playRate = 1.0;
+        int renderWidth = 0;
+        int renderHeight = 0;
+        int scalingAlgo = SWS_BILINEAR;
+        bool swsNeedReset = false;
+        double audioFilterRate = 0.0;           // 当前 atempo 链的倍速
+        int stretchEngine = StretchAtempo;      // 期望的时间伸缩引擎
+        int audioTrackRequest = -1;             // 待切换的音轨流序号
+        bool subtitleRequestPending = false;    // 待切换的字幕
+        int subtitleRequest = SUBTITLE_OFF;
+        std::shared_ptr<SubtitleTrack> subtitleRequestTrack;
+        int audioFilterEngine = -1;             // 当前 filter 按哪种引擎建立
+        TimeStretcher stretcher;                // WSOLA 引擎：filter 只转换为 float 立体声
+        std::vector<int16_t> stretchOut;        // WSOLA 输出暂存，会话内复用
+        bool audioFilterEof = false;            // 已在文件尾冲洗，buffersrc 不再接受输入
+        double lastPts = -1.0;                  // 解码线程最近显示的帧
+        int videoOutput = VideoVisible;         // VideoOutputMode
+        double lastPositionPts = -1.0;          // 画面不可见时最近一次报告的位置
+
+        // 缓存帧回放：seek 后先显示快退缓存或预判快进准备好的帧，
+        // 解码器追上 replayPts 之前解码出的帧不再缩放显示
+        bool replaying = false;
+        double replayPts = -1.0;                // 最近一个放出的缓存帧
+        bool audioSyncPending = false;          // 丢弃早于视频时钟的音频，直到与缓存帧对齐
+        std::unique_ptr<SkipPrefetcher> skipPrefetch;   // 预判快进的后台解码器，decodeLoop 退出前释放
+        std::unique_ptr<BarDetector> barDetector;       // 黑边检测，decodeLoop 退出前释放
+        double barSamplePts = -1.0;             // 最近一次送检的帧
+
+        // 逐帧浏览（暂停时）：按 pts 排序的解码帧窗口，窗口内前后移动不需要解码，
+        // 走出窗口时才重新定位；后退时一次解码到窗口前端，之后连续后退都是 O(1)
+        int stepRequest = 0;                    // 待执行的步数，正数向前
+        bool stepped = false;                   // 逐帧移动过，恢复播放时从 lastPts 重新 seek
+        bool seekResume = false;                // 本次 seek 是逐帧后的恢复播放，画面已停在目标处
+        std::deque<AVFrame*> stepWindow;
+        int stepIndex = -1;                     // 当前显示的帧在窗口中的下标
+        bool stepDecoderLive = false;           // 解码器输出的下一帧紧接窗口末尾
+        qint64 stepWindowBytes = 0;
+
+        // 拖动进度条预览：期间不正常播放，只解码最新预览位置处的关键帧
+        bool scrubbing = false;
+        bool scrubPending = false;
+        double scrubTarget = 0.0;
+        int64_t scrubKeyPts = AV_NOPTS_VALUE;   // 最近显示的关键帧，同一关键帧不重复解码
+        bool seekExact = false;
+
+        // 快速起播：首帧显示前音频包只暂存不解码，音频 filter 也推迟到首帧之后建立
+        StartupTrace trace;                     // 从发起打开到首帧显示的各阶段耗时
+        bool firstFrameShown = false;
+        bool fastStart = true;
+        std::vector<AVPacket*> deferredAudio;
+
+        // 解复用统计窗口
+        QElapsedTimer demuxTimer;
+        qint64 demuxWindowPackets = 0;
+        qint64 demuxWindowIoStart = 0;
+
+        // wall-clock based video timing（扣除暂停时长）
+        QElapsedTimer playTimer;
+        double playStartPts = 0.0;
+        bool playStarted = false;
+        qint64 totalPausedMs = 0;
+        qint64 pauseStartMs = 0;
+
+        QThread *thread = nullptr;
+        std::promise<void> exitPromise;         // 解码线程退出时兑现
+        std::shared_future<void> exited;
+
+    private:
+        QMutex m_wakeMutex;
+        QWaitCondition m_wakeCond;
+        GopParallelDecoder *m_gop = nullptr;
+    };
+    // 一次异步打开请求：工作线程填充 session，主线程安装
+    struct OpenRequest {
+        std::shared_ptr<MediaSession> session;
+        bool ok = false;
+    };
+    static int interruptCallback(void *opaque);
+    static int readInput(MediaSession &s, AVPacket *pkt, bool honorWatermarks = true);
+    static int seekInput(MediaSession &s, int streamIndex, int64_t ts, int flags);
+    void setBuffering(MediaSession &s, bool on);
+    void onBufferingChanged(const std::weak_ptr<const MediaSession> &s, bool on);
+    bool isCurrentSession(const std::weak_ptr<const MediaSession> &s) const;  // 主线程：旧会话释放后地址被新会话复用也能区分
+    static bool openMedia(MediaSession &s);
+    static AVCodecContext *openAudioDecoder(const AVStream *st);
+    static void applyStreamDiscard(MediaSession &s);    // 只保留当前视频流、音轨和字幕流
+    static int bufferReferenceStream(const MediaSession &s);   // 网络缓冲量按哪个流计算
+    static bool openSubtitleStream(MediaSession &s, int streamIndex);
+    static QString findSidecarSubtitle(const QString &videoPath);
+    void applySubtitleRequest(MediaSession &s);
+    void decodeSubtitlePacket(MediaSession &s);
+    void switchAudioTrack(MediaSession &s);
+    void decodeDeferredAudio(MediaSession &s);
+    void updateDemuxStats(MediaSession &s, int packetBytes);
+    void installMedia(const std::shared_ptr<MediaSession> &s);
+    void reap(std::shared_ptr<MediaSession> s);     // 交给回收线程释放
+
+    quint64 post(PlayerCommand cmd);        // 分配序号并投递给当前会话的解码线程
+    void drainCommands(MediaSession &s);    // 解码线程在循环检查点执行全部待处理命令
+    void decodeLoop(MediaSession &s);
     void clearQueue();
-    void freeFFmpegResources();
-    bool initAudioFilter(double rate);
-    void cleanupAudioFilter();
+    void clearAudioQueue();
+    void dropStaleAudio();              // 主线程：丢弃序号早于最近一次 seek/换文件的 PCM
+    bool initAudioFilter(MediaSession &s, double rate);
+    void cleanupAudioFilter(MediaSession &s);
+    static constexpr int AUDIO_TEMPO_STAGES = 2;    // 每级 atempo 0.5~2.0，两级覆盖 0.25x~4x
+    static void splitTempo(double rate, double (&tempo)[AUDIO_TEMPO_STAGES]);
+    bool setAudioFilterTempo(MediaSession &s, double rate);
+    void flushAudioFilter(MediaSession &s);
+    void filterAudioFrame(MediaSession &s, AVFrame *in);   // 过滤一帧并写入 PCM 缓冲，nullptr 表示冲洗
 
-    double videoPtsToSeconds(AVFrame *vframe);
+    double videoPtsToSeconds(const MediaSession &s, AVFrame *vframe);
+    static qint64 playElapsedMs(const MediaSession &s);     // 扣除暂停后的播放时长
+    QImage scaleFrame(MediaSession &s, AVFrame *vframe, double vpts);   // 缩放到渲染尺寸并叠加字幕
+    double presentVideoFrame(MediaSession &s, AVFrame *vframe);  // 经滤镜后逐帧 showVideoFrame，返回输入帧的 pts
+    double showVideoFrame(MediaSession &s, AVFrame *vframe);     // 缩放 + 按速率等待 + 发送帧，返回 pts
+    QImage scaleStill(MediaSession &s, AVFrame *vframe, double vpts);  // 不连续的单帧：只旋转裁剪后缩放
+    void flushVideoFilter(MediaSession &s);     // 文件尾：显示去隔行滞留的最后一帧
+    void postFrame(MediaSession &s, const QImage &img, double vpts, bool first);  // 交给主线程显示
+    void postPosition(MediaSession &s, double vpts);    // 画面不可见时只报告位置，按 POSITION_INTERVAL_SEC 限频
+    static bool videoDiscarded(const MediaSession &s);  // 纯音频：视频包在解复用层丢弃
+    static double trickTargetPos(const MediaSession &s);    // 快进/快退时按墙钟应到达的位置
+    void startReplayClock(MediaSession &s, double pts);     // 以已显示的 pts 为起点重建时钟并开始回放
+    void beginReplay(MediaSession &s, const QImage &img, double pts);  // 立即显示并以它为起点重建时钟
+    bool startRewindReplay(MediaSession &s);    // seek 目标在快退缓存内：立即显示缓存帧并开始回放
+    bool startSkipReplay(MediaSession &s);      // seek 目标已由预判快进准备好
+    void pumpRewind(MediaSession &s);           // 回放中：放出已到时间的缓存帧
+    void updateSkipPrefetch(MediaSession &s, double vpts, qint64 waitMs);
+    void updateBarDetection(MediaSession &s, const AVFrame *vframe, double vpts);   // 抽样送检，结论交给主线程
+    void onBarsDetected(const std::weak_ptr<const MediaSession> &s, const QRect &crop);
+    void reverseTrickStep(MediaSession &s); // 快退：seek 到上一个关键帧并显示
+    void scrubStep(MediaSession &s);        // 拖动预览：解码并显示预览位置之前最近的关键帧
+    void sendScrub();
+
+    // 逐帧（解码线程）
+    void executeStep(MediaSession &s);
+    bool stepForwardDecode(MediaSession &s);
+    bool stepBackwardDecode(MediaSession &s);
+    bool readVideoFrame(MediaSession &s, AVFrame *out);    // 只解码视频，音频包丢弃，文件尾时冲洗解码器
+    void seekVideo(MediaSession &s, double pos);
+    void pushStepFrame(MediaSession &s, AVFrame *frame, bool front);  // 接管 frame，超出容量时淘汰另一端
+    int stepCapacity(qint64 frameBytes) const;
+    void clearStepWindow(MediaSession &s);
+    void restartAudioOutput();              // 丢弃已排队的 PCM 并重启声卡，位置从下一次写入重新计算
+    void applyVideoOutput();                // 按可见性与纯音频开关投递画面输出方式
+    void postVideoFilter();
+    VideoFilter::Config effectiveFilterConfig() const;     // 手动裁剪优先，否则套用自动裁黑边的结论
 
 private:
-    // FFmpeg
-    AVFormatContext *fmtCtx = nullptr;
-
-    // video
-    AVCodecContext *codecCtx = nullptr;
-    int videoStreamIndex = -1;
-
-    // audio
-    AVCodecContext *audioCodecCtx = nullptr;
-    int audioStreamIndex = -1;
-    SwrContext *swrCtx = nullptr;
-
-    // audio filter graph for atempo
-    AVFilterGraph *audioFilterGraph = nullptr;
-    AVFilterContext *audioBufferSrcCtx = nullptr;
-    AVFilterContext *audioBufferSinkCtx = nullptr;
-    QMutex m_audioFilterMutex;
-
-    // reuse frames/packets
-    AVFrame *frame = nullptr;
-    AVPacket *packet = nullptr;
-
-    // thread + queue
-    QThread *m_decodeThread = nullptr;
-    QQueue<std::pair<QImage, double>> m_frameQueue;
-    QMutex m_mutex;
-
-    // state
-    std::atomic<bool> m_stopRequested{false};
+    // 当前文件；解码线程持有裸指针，所有权在 stop() 时转给回收线程
+    std::shared_ptr<MediaSession> m_session;
+    std::shared_future<void> m_prevDecodeExit;  // 上一个解码线程退出，新线程开始前等待
+    QThreadPool m_reaper;                       // 后台释放旧会话
+
+    // async open
+    std::shared_ptr<OpenRequest> m_pendingOpen;
+    QList<QThread*> m_openThreads;
+
+    // 所有缓冲队列的字节预算
+    MemoryBudget m_memory;
+    RewindCache m_rewindCache{&m_memory};       // 最近显示过的画面，短距离快退时直接回放
+
+    // state（主线程）
     std::atomic<bool> m_paused{false};
     std::atomic<bool> m_playing{false};
-    std::atomic<bool> m_finished{false};
-    std::atomic<bool> m_seekRequested{false};
-    double m_seekTargetSec{0.0};
     QString m_filePath;
 
+    // 命令序号：m_flushSerial 是最近一次 seek/换文件的序号，携带更小序号的帧和 PCM 已过期
+    std::atomic<quint64> m_commandSeq{0};
+    std::atomic<quint64> m_flushSerial{0};
+
     // audio queue & writing (main thread)
-    QMutex m_audioQueueMutex;
-    QList<QByteArray> m_audioQueue;
+    AudioRingBuffer m_audioRing;
     QTimer *m_audioFlushTimer = nullptr;
     QAudioSink *audioSink = nullptr;
     QIODevice *audioIODevice = nullptr;
 
+    // 快速起播：声卡输出在首帧显示后创建，期间的 PCM 留在环形缓冲
+    static constexpr int FAST_START_AUDIO_TIMEOUT_MS = 300;     // 首帧迟迟不到时也要启动声卡
+    static constexpr int FAST_START_MAX_AUDIO_PACKETS = 256;    // 首帧前最多暂存的音频包
+    bool m_audioOutputPending = false;
+    bool m_buffering = false;                   // 网络缓冲中（主线程）
+    QElapsedTimer m_firstFrameClock;            // 首帧显示时刻，声卡启动时据此跳过已错过的 PCM
+    QString m_startupReport;
+
     // audio tracking
     std::atomic<double> m_audioBasePts{-1.0};
     std::atomic<long long> m_audioPlayedSamples{0};
+    // 声卡输出参数只由主线程读写：打开文件时按 audioOutRate 预置，声卡启动后取实际格式
     int m_audioOutChannels = 2;
     int m_audioSampleRate = 48000;
 
-    // timebases for pts -> seconds
-    AVRational videoTimeBase{0,1};
-    AVRational audioTimeBase{0,1};
+    // 以下设置由主线程保存，换文件时作为新解码线程的初始状态，之后通过命令同步
+    // video scaler
+    int m_renderWidth = 0;
+    int m_renderHeight = 0;
+    int m_scalingAlgo = SWS_BILINEAR;  // 快速缩放算法，减少CPU
 
-    // wall-clock based video timing
-    QElapsedTimer m_playTimer;
-    double m_playStartPts{0.0};
-    bool m_playStarted{false};
+    double m_playRate = 1.0;
+    int m_stretchEngine = StretchAtempo;
 
-    // video scaler
-    SwsContext *swsCtx = nullptr;
-    QMutex m_swsMutex;
-    QMutex m_swrMutex;
-    std::atomic<int> m_renderWidth{0};
-    std::atomic<int> m_renderHeight{0};
-    std::atomic<bool> m_swsCtxNeedReset{false};
-    std::atomic<int> m_scalingAlgo{SWS_BILINEAR};  // 快速缩放算法，减少CPU
-
-    // pause accumulation
-    std::atomic<qint64> m_totalPausedMs{0};
-    qint64 m_pauseStartMs{0};
-
-    std::atomic<double> m_playRate{1.0};
-    std::atomic<bool> m_audioFilterNeedReset{false};
+    // trick play（仅关键帧快进/快退）
+    static constexpr double TRICK_CATCHUP_SEC = 5.0;   // 落后墙钟超过该值直接跳到目标关键帧
+
+    // 逐帧窗口的帧数范围，实际容量由 StepFrames 配额决定；下限只保证当前帧与相邻帧，4K 高位深下也不超出预算太多
+    static constexpr int STEP_MIN_FRAMES = 3;
+    static constexpr int STEP_MAX_FRAMES = 120;
+    static constexpr int STEP_MAX_PENDING = 30;         // 按住按键时最多积压的步数
+
+    // 拖动进度条预览（主线程）：两次预览请求至少间隔 SCRUB_INTERVAL_MS，间隔内只保留最新位置
+    static constexpr int SCRUB_INTERVAL_MS = 40;
+    QTimer *m_scrubTimer = nullptr;
+    bool m_scrubbing = false;
+    double m_scrubTarget = 0.0;
+    double m_scrubSent = -1.0;
+    bool m_trickPlay = false;
+
+    // 画面输出（主线程）：纯音频时没有显示的帧，位置取声卡进度并由定时器定期发出
+    static constexpr double POSITION_INTERVAL_SEC = 0.25;
+    static constexpr double AUDIO_ONLY_AHEAD_SEC = 2.0;    // 纯音频时 PCM 最多超前声卡的时长
+    bool m_surfaceVisible = true;
+    bool m_audioOnly = false;
+    int m_videoOutput = VideoVisible;
+    QTimer *m_positionTimer = nullptr;
+
+    VideoFilter::Config m_filterConfig;         // 主线程保存，新文件作为初始配置
+    std::atomic<bool> m_autoCrop{true};         // 解码线程据此创建或释放黑边检测
+    QRect m_autoCropRect;                       // 当前文件的黑边检测结论（主线程）
+    std::atomic<double> m_lastPresentedPts{-1.0};   // 最近显示帧的 pts，即当前播放位置
+
+    std::atomic<bool> m_gopParallel{false};  // 是否启用 GOP 并行解码
+    std::atomic<bool> m_skipPrefetch{true};  // 是否启用预判快进
+    static constexpr int SKIP_PREFETCH_MIN_CORES = 4;   // 核心更少时没有空闲核心可用
+    static constexpr qint64 SKIP_PREFETCH_LATE_MS = 40; // 视频帧晚于时钟超过该值视为主解码落后
+    bool m_readAheadAlways = false;
+    int m_readAheadMB = 32;
+
+    int m_audioTrack = -1;                          // 当前音轨（主线程）
+    int m_subtitle = SUBTITLE_OFF;                  // 当前字幕（主线程）
+    std::shared_ptr<SubtitleTrack> m_externalSubtitle;  // 交给解码线程后主线程不再访问其内容
+    QString m_externalSubtitleName;
+    std::atomic<qint64> m_demuxPacketRate{0};       // 解码线程每秒更新
+    std::atomic<qint64> m_demuxIoRate{0};
 };